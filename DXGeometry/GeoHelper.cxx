@@ -6,6 +6,9 @@
 #include <iomanip>
 #include <set>
 #include <memory>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 #include "fhiclcpp/make_ParameterSet.h"
 #include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 #include "lardata/DetectorInfoServices/LArPropertiesService.h"
@@ -53,6 +56,7 @@ GeoHelper::GeoHelper(const geo::GeometryCore* pgeo, bool useChannels, Status dbg
 : m_pgeo(pgeo), m_haveChannelMap(useChannels), m_dbg(dbg), m_ntpc(0), m_ntpp(0), m_napa(0), m_nrop(0) {
   // Fill TPC info.
   ntpc();
+  fillTpcGrid();
   // Fill ROP and APA info.
   if ( useChannels) fillStandardApaMapping();
 }
@@ -83,6 +87,7 @@ GeoHelper::GeoHelper(std::string gname, bool useChannels, Status dbg)
   pdetgeo->LoadGeometryFile(fullgdmlfile, fullrootfile);
   m_pgeo = pdetgeo;
   ntpc();
+  fillTpcGrid();
   // Add the geometry channel map.
   if ( useChannels ) {
     cout << myname << "Adding channel map." << endl;
@@ -252,8 +257,333 @@ Index GeoHelper::rop(geo::PlaneID pid) const {
 
 //**********************************************************************
 
+geo::TPCID GeoHelper::findTpc(const double xyz[]) const {
+  Index itpc = findTpcIndex(xyz);
+  if ( itpc == badIndex() ) return TPCID();
+  Index icry = m_tpccry[itpc];
+  return TPCID(icry, itpc - m_crytpc1[icry]);
+}
+
+//**********************************************************************
+
+Index GeoHelper::findTpcIndex(const double xyz[]) const {
+  if ( m_gridoff.size() ) {
+    Index icel = 0;
+    for ( int icor=0; icor<3; ++icor ) {
+      double u = (xyz[icor] - m_gridlo[icor])*m_gridinv[icor];
+      // Points outside the grid are outside all TPCs.
+      if ( !(u >= 0.0) || u >= m_gridn[icor] ) return badIndex();
+      icel = icel*m_gridn[icor] + Index(u);
+    }
+    Index itpcin = badIndex();
+    bool ambiguous = false;
+    for ( Index ient=m_gridoff[icel]; ient<m_gridoff[icel+1]; ++ient ) {
+      Index itpc = m_gridtpc[ient];
+      int loc = m_tpcbox[itpc].locate(xyz);
+      if ( loc == 0 ) {
+        if ( itpcin != badIndex() ) ambiguous = true;
+        itpcin = itpc;
+      } else if ( loc == 1 ) {
+        ambiguous = true;
+      }
+    }
+    if ( ! ambiguous ) return itpcin;
+  }
+  TPCID tpcid = m_pgeo->FindTPCAtPosition(xyz);
+  if ( ! tpcid.isValid ) return badIndex();
+  return m_crytpc1.at(tpcid.Cryostat) + tpcid.TPC;
+}
+
+//**********************************************************************
+
+Status GeoHelper::
+findSegmentTpcs(const double xyz1[], const double xyz2[], vector<TPCID>& tpcids) const {
+  tpcids.clear();
+  if ( m_gridoff.size() == 0 ) return 1;
+  // Range of grid cells along each axis.
+  Index icel1[3];
+  Index icel2[3];
+  for ( int icor=0; icor<3; ++icor ) {
+    double u1 = (std::min(xyz1[icor], xyz2[icor]) - m_gridlo[icor])*m_gridinv[icor];
+    double u2 = (std::max(xyz1[icor], xyz2[icor]) - m_gridlo[icor])*m_gridinv[icor];
+    // Segments outside the grid are outside all TPCs.
+    if ( !(u2 >= 0.0) || !(u1 < m_gridn[icor]) ) return 0;
+    icel1[icor] = u1 > 0.0 ? Index(u1) : 0;
+    icel2[icor] = std::min(Index(u2), m_gridn[icor] - 1);
+  }
+  IndexVector itpcs;
+  for ( Index ix=icel1[0]; ix<=icel2[0]; ++ix ) {
+    for ( Index iy=icel1[1]; iy<=icel2[1]; ++iy ) {
+      for ( Index iz=icel1[2]; iz<=icel2[2]; ++iz ) {
+        Index icel = (ix*m_gridn[1] + iy)*m_gridn[2] + iz;
+        for ( Index ient=m_gridoff[icel]; ient<m_gridoff[icel+1]; ++ient ) {
+          Index itpc = m_gridtpc[ient];
+          if ( std::find(itpcs.begin(), itpcs.end(), itpc) == itpcs.end() ) itpcs.push_back(itpc);
+        }
+      }
+    }
+  }
+  std::sort(itpcs.begin(), itpcs.end());
+  for ( Index itpc : itpcs ) {
+    Index icry = m_tpccry[itpc];
+    tpcids.push_back(TPCID(icry, itpc - m_crytpc1[icry]));
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+Index GeoHelper::findCryostat(const double xyz[]) const {
+  Index itpc = findTpcIndex(xyz);
+  if ( itpc != badIndex() ) return m_tpccry[itpc];
+  if ( m_crybox.size() ) {
+    Index icryin = badIndex();
+    bool ambiguous = false;
+    for ( Index icry=0; icry<m_crybox.size(); ++icry ) {
+      int loc = m_crybox[icry].locate(xyz);
+      if ( loc == 0 ) {
+        if ( icryin != badIndex() ) ambiguous = true;
+        icryin = icry;
+      } else if ( loc == 1 ) {
+        ambiguous = true;
+      }
+    }
+    if ( ! ambiguous ) return icryin;
+  }
+  unsigned int icry = m_pgeo->FindCryostatAtPosition(xyz);
+  if ( icry >= ncryostat() ) return badIndex();
+  return icry;
+}
+
+//**********************************************************************
+
+int GeoHelper::Box::locate(const double xyz[]) const {
+  int loc = 0;
+  for ( int icor=0; icor<3; ++icor ) {
+    double x = xyz[icor];
+    if ( x < lo[icor] - tol[icor] || x > hi[icor] + tol[icor] ) return 2;
+    if ( x < lo[icor] + tol[icor] || x > hi[icor] - tol[icor] ) loc = 1;
+  }
+  return loc;
+}
+
+//**********************************************************************
+
 PlanePositionVector GeoHelper::planePositions(const double postim[], bool usetime) const {
+  PlanePositionVector pps;
+  planePositions(postim, pps, usetime);
+  return pps;
+}
+
+//**********************************************************************
+
+Status GeoHelper::
+planePositions(const double postim[], PlanePositionVector& pps, bool usetime) const {
   const string myname = "GeoHelper::planePositions: ";
+  pps.clear();
+  if ( m_tpcproj.size() == 0 ) {
+    pps = geometryPlanePositions(postim, usetime);
+    return 0;
+  }
+  if ( usetime && ! m_haveTickModel ) {
+    if ( fillTickModel() ) return 1;
+  }
+  // Find the TPC.
+  Index itpc = findTpcIndex(postim);
+  if ( itpc >= m_tpcproj.size() ) return 0;
+  for ( const PlaneProjection& pla : m_tpcproj[itpc].planes ) {
+    double tick = 0.0;
+    if ( usetime ) {
+      tick = m_tpptickoff[pla.itpp] + postim[0]/m_tpptickcoef[pla.itpp];
+      tick += postim[3]/m_samplingrate;
+    }
+    double wire = std::nearbyint(pla.w0 + pla.wy*postim[1] + pla.wz*postim[2]);
+    Index iwir = 0;
+    if ( wire > 0.0 ) iwir = wire < pla.wirechan.size() ? Index(wire) : pla.wirechan.size() - 1;
+    Index ichan = pla.wirechan[iwir];
+    int itick = int(tick);
+    if ( tick < 0.0 ) itick += -1;
+    pps.push_back(PlanePosition());
+    PlanePosition& pp = pps.back();
+    pp.planeid = pla.pid;
+    pp.rop = pla.rop;
+    pp.channel = ichan;
+    pp.tick = tick;
+    pp.itick = itick;
+    pp.ropchannel = ichan - pla.ropfirstchan;
+    pp.valid = true;
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+Status GeoHelper::
+planePositions(const geo::TPCID& tpcid, Index npt,
+               const double* xs, const double* ys, const double* zs, const double* ts,
+               IndexVector& rops, IndexVector& chans, vector<double>& ticks, bool usetime) const {
+  const string myname = "GeoHelper::planePositions: ";
+  rops.clear();
+  if ( m_tpcproj.size() == 0 ) return 1;
+  if ( usetime && ! m_haveTickModel ) {
+    if ( fillTickModel() ) return 2;
+  }
+  const TpcProjection* ptpc = tpcProjection(tpcid);
+  if ( ptpc == nullptr ) {
+    cout << myname << "ERROR: TPC not found: " << tpcid << endl;
+    return 3;
+  }
+  const TpcProjection& tpc = *ptpc;
+  Index nplane = tpc.planes.size();
+  chans.resize(nplane*npt);
+  ticks.resize(nplane*npt);
+  for ( Index ipla=0; ipla<nplane; ++ipla ) {
+    const PlaneProjection& pla = tpc.planes[ipla];
+    rops.push_back(pla.rop);
+    double* pticks = &ticks[ipla*npt];
+    Index* pchans = &chans[ipla*npt];
+    // Ticks.
+    if ( usetime ) {
+      double tickoff = m_tpptickoff[pla.itpp];
+      double tickcoef = m_tpptickcoef[pla.itpp];
+      double samplingrate = m_samplingrate;
+      for ( Index ipt=0; ipt<npt; ++ipt ) {
+        pticks[ipt] = tickoff + xs[ipt]/tickcoef;
+        pticks[ipt] += ts[ipt]/samplingrate;
+      }
+    } else {
+      for ( Index ipt=0; ipt<npt; ++ipt ) pticks[ipt] = 0.0;
+    }
+    // Channels. Points outside the TPC are flagged with a bad channel.
+    double w0 = pla.w0;
+    double wy = pla.wy;
+    double wz = pla.wz;
+    double wmax = pla.wirechan.size() - 1;
+    const Index* pwirechan = pla.wirechan.data();
+    for ( Index ipt=0; ipt<npt; ++ipt ) {
+      double wire = std::nearbyint(w0 + wy*ys[ipt] + wz*zs[ipt]);
+      wire = std::min(std::max(wire, 0.0), wmax);
+      bool inside = xs[ipt] >= tpc.lo[0] && xs[ipt] <= tpc.hi[0] &&
+                    ys[ipt] >= tpc.lo[1] && ys[ipt] <= tpc.hi[1] &&
+                    zs[ipt] >= tpc.lo[2] && zs[ipt] <= tpc.hi[2];
+      pchans[ipt] = inside ? pwirechan[Index(wire)] : badIndex();
+    }
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+Status GeoHelper::
+planeCrossings(const geo::TPCID& tpcid, const double postim1[], const double postim2[],
+               IndexVector& rops, IndexVector& chans, vector<double>& ticks,
+               vector<double>& fracs, bool usetime) const {
+  const string myname = "GeoHelper::planeCrossings: ";
+  if ( m_tpcproj.size() == 0 ) return 1;
+  if ( usetime && ! m_haveTickModel ) {
+    if ( fillTickModel() ) return 2;
+  }
+  const TpcProjection* ptpc = tpcProjection(tpcid);
+  if ( ptpc == nullptr ) {
+    cout << myname << "ERROR: TPC not found: " << tpcid << endl;
+    return 3;
+  }
+  const TpcProjection& tpc = *ptpc;
+  // Clip the segment to the TPC volume.
+  // Points on the segment are postim1 + s*(postim2 - postim1) for s in [slo, shi].
+  double slo = 0.0;
+  double shi = 1.0;
+  for ( int icor=0; icor<3; ++icor ) {
+    double p1 = postim1[icor];
+    double dp = postim2[icor] - p1;
+    if ( dp == 0.0 ) {
+      if ( p1 < tpc.lo[icor] || p1 > tpc.hi[icor] ) return 0;
+      continue;
+    }
+    double s1 = (tpc.lo[icor] - p1)/dp;
+    double s2 = (tpc.hi[icor] - p1)/dp;
+    if ( s1 > s2 ) std::swap(s1, s2);
+    if ( s1 > slo ) slo = s1;
+    if ( s2 < shi ) shi = s2;
+  }
+  if ( slo >= shi ) return 0;
+  const double sinf = std::numeric_limits<double>::infinity();
+  for ( const PlaneProjection& pla : tpc.planes ) {
+    // The wire coordinate is wa + wb*s and the tick is ta + tb*s.
+    double wa = pla.w0 + pla.wy*postim1[1] + pla.wz*postim1[2];
+    double wb = pla.wy*(postim2[1] - postim1[1]) + pla.wz*(postim2[2] - postim1[2]);
+    double ta = 0.0;
+    double tb = 0.0;
+    if ( usetime ) {
+      double tickcoef = m_tpptickcoef[pla.itpp];
+      ta = m_tpptickoff[pla.itpp] + postim1[0]/tickcoef + postim1[3]/m_samplingrate;
+      tb = (postim2[0] - postim1[0])/tickcoef + (postim2[3] - postim1[3])/m_samplingrate;
+    }
+    // Next wire boundary (half-integer wire coordinate) and tick boundary after slo.
+    double wlo = wa + wb*slo;
+    double tlo = ta + tb*slo;
+    double wbnd = 0.0;
+    double wstep = 0.0;
+    if ( wb > 0.0 ) {
+      wbnd = std::floor(wlo - 0.5) + 1.5;
+      wstep = 1.0;
+    } else if ( wb < 0.0 ) {
+      wbnd = std::ceil(wlo - 0.5) - 0.5;
+      wstep = -1.0;
+    }
+    double tbnd = 0.0;
+    double tstep = 0.0;
+    if ( tb > 0.0 ) {
+      tbnd = std::floor(tlo) + 1.0;
+      tstep = 1.0;
+    } else if ( tb < 0.0 ) {
+      tbnd = std::ceil(tlo) - 1.0;
+      tstep = -1.0;
+    }
+    double wmax = pla.wirechan.size() - 1;
+    Index ncell0 = chans.size();
+    double s = slo;
+    while ( s < shi ) {
+      double sw = wstep == 0.0 ? sinf : (wbnd - wa)/wb;
+      double st = tstep == 0.0 ? sinf : (tbnd - ta)/tb;
+      double snext = std::min(std::min(sw, st), shi);
+      if ( snext > s ) {
+        double smid = 0.5*(s + snext);
+        double wire = std::nearbyint(wa + wb*smid);
+        wire = std::min(std::max(wire, 0.0), wmax);
+        Index ichan = pla.wirechan[Index(wire)];
+        double tick = ta + tb*smid;
+        Index ncell = chans.size();
+        if ( ncell > ncell0 && chans[ncell-1] == ichan &&
+             std::floor(ticks[ncell-1]) == std::floor(tick) ) {
+          fracs[ncell-1] += snext - s;
+        } else {
+          rops.push_back(pla.rop);
+          chans.push_back(ichan);
+          ticks.push_back(tick);
+          fracs.push_back(snext - s);
+        }
+      }
+      if ( sw <= snext ) wbnd += wstep;
+      if ( st <= snext ) tbnd += tstep;
+      if ( snext > s ) s = snext;
+    }
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+Status GeoHelper::checkTickModel() const {
+  if ( m_tpcproj.size() == 0 ) return 0;
+  if ( m_haveTickModel ) return 0;
+  return fillTickModel();
+}
+
+//**********************************************************************
+
+PlanePositionVector GeoHelper::geometryPlanePositions(const double postim[], bool usetime) const {
+  const string myname = "GeoHelper::geometryPlanePositions: ";
   PlanePositionVector pps;
   if ( geometry() == nullptr ) {
     cout << myname << "ERROR: Geometry is null." << endl;
@@ -490,6 +820,11 @@ ostream& GeoHelper::dump(ostream& out) const {
 
 Index GeoHelper::channelRop(Index chan) const {
   const string myname = "GeoHelper::channelRop: ";
+  if ( m_chanrop.size() ) {
+    if ( chan < m_chanrop.size() ) return m_chanrop[chan];
+    return nrop();
+  }
+  // Search the ROPs if the channel table is not yet filled.
   Index irop = nrop();
   for ( irop=0; irop<nrop(); ++irop ) {
     unsigned int lastchan = ropFirstChannel(irop) + ropNChannel(irop) - 1;
@@ -500,6 +835,55 @@ Index GeoHelper::channelRop(Index chan) const {
 
 //**********************************************************************
 
+Status GeoHelper::channelRops(const IndexVector& chans, IndexVector& rops) const {
+  rops.resize(chans.size());
+  Index nchan = chans.size();
+  Index ntab = m_chanrop.size();
+  Index badrop = nrop();
+  const Index* pchan = chans.data();
+  const Index* ptab = m_chanrop.data();
+  Index* prop = rops.data();
+  for ( Index ich=0; ich<nchan; ++ich ) {
+    Index chan = pchan[ich];
+    prop[ich] = chan < ntab ? ptab[chan] : badrop;
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+Index GeoHelper::channelRopChannel(Index chan) const {
+  if ( chan >= m_chanropchan.size() ) return badIndex();
+  return m_chanropchan[chan];
+}
+
+//**********************************************************************
+
+geo::View_t GeoHelper::channelView(Index chan) const {
+  Index irop = channelRop(chan);
+  if ( irop >= nrop() ) return geo::kUnknown;
+  return m_ropview[irop];
+}
+
+//**********************************************************************
+
+Index GeoHelper::channelApa(Index chan) const {
+  Index irop = channelRop(chan);
+  if ( irop >= nrop() ) return badIndex();
+  return m_ropapa[irop];
+}
+
+//**********************************************************************
+
+const GeoHelper::IndexVector& GeoHelper::channelTpcs(Index chan) const {
+  static const IndexVector empty;
+  Index irop = channelRop(chan);
+  if ( irop >= nrop() ) return empty;
+  return m_roptpc[irop];
+}
+
+//**********************************************************************
+
 Status GeoHelper::fillStandardApaMapping() {
   const string myname = "GeoHelper::fillStandardApaMapping: ";
   // Fill the TPC arrays.
@@ -644,6 +1028,214 @@ Status GeoHelper::fillStandardApaMapping() {
   }  // End loop over cryostats
   if ( m_dbg > 1 ) cout << myname << "End loop over cryostats." << endl;
 
+  fillChannelTable();
+  return fillProjections();
+}
+
+//**********************************************************************
+
+Status GeoHelper::fillChannelTable() {
+  const string myname = "GeoHelper::fillChannelTable: ";
+  Index nchan = 0;
+  for ( Index irop=0; irop<m_nrop; ++irop ) {
+    Index chanEnd = m_ropfirstchan[irop] + m_ropnchan[irop];
+    if ( chanEnd > nchan ) nchan = chanEnd;
+  }
+  IndexVector chanrop(nchan, m_nrop);
+  IndexVector chanropchan(nchan, badIndex());
+  for ( Index irop=0; irop<m_nrop; ++irop ) {
+    Index chan1 = m_ropfirstchan[irop];
+    for ( Index ich=0; ich<m_ropnchan[irop]; ++ich ) {
+      chanrop[chan1 + ich] = irop;
+      chanropchan[chan1 + ich] = ich;
+    }
+  }
+  m_chanrop.swap(chanrop);
+  m_chanropchan.swap(chanropchan);
+  if ( m_dbg > 0 ) cout << myname << "Channel table size is " << m_chanrop.size() << endl;
+  return 0;
+}
+
+//**********************************************************************
+
+Status GeoHelper::fillProjections() {
+  const string myname = "GeoHelper::fillProjections: ";
+  // Distance used to evaluate the wire coordinate slopes.
+  const double dist = 1000.0;
+  m_tpcproj.clear();
+  Index itpp = 0;
+  for ( Index icry=0; icry<ncryostat(); ++icry ) {
+    for ( Index icrytpc=0; icrytpc<m_pgeo->NTPC(icry); ++icrytpc ) {
+      TpcProjection tpc;
+      tpc.tpcid = TPCID(icry, icrytpc);
+      double pos1[3];
+      double pos2[3];
+      tpcCorners(icry, icrytpc, pos1, pos2);
+      for ( int icor=0; icor<3; ++icor ) {
+        tpc.lo[icor] = std::min(pos1[icor], pos2[icor]);
+        tpc.hi[icor] = std::max(pos1[icor], pos2[icor]);
+      }
+      Index nplane = m_pgeo->Nplanes(icrytpc, icry);
+      for ( Index ipla=0; ipla<nplane; ++ipla ) {
+        PlaneProjection pla;
+        pla.pid = PlaneID(icry, icrytpc, ipla);
+        pla.itpp = itpp++;
+        pla.rop = rop(pla.pid);
+        if ( pla.rop >= m_nrop ) {
+          cout << myname << "ERROR: Plane " << pla.pid << " does not have a ROP." << endl;
+          m_tpcproj.clear();
+          return 1;
+        }
+        pla.ropfirstchan = m_ropfirstchan[pla.rop];
+        pla.w0 = m_pgeo->WireCoordinate(0.0, 0.0, ipla, icrytpc, icry);
+        pla.wy = (m_pgeo->WireCoordinate(dist, 0.0, ipla, icrytpc, icry) - pla.w0)/dist;
+        pla.wz = (m_pgeo->WireCoordinate(0.0, dist, ipla, icrytpc, icry) - pla.w0)/dist;
+        Index nwire = m_pgeo->Nwires(ipla, icrytpc, icry);
+        for ( Index iwir=0; iwir<nwire; ++iwir ) {
+          pla.wirechan.push_back(m_pgeo->PlaneWireToChannel(ipla, iwir, icrytpc, icry));
+        }
+        tpc.planes.push_back(pla);
+      }
+      m_tpcproj.push_back(tpc);
+    }
+  }
+  if ( m_dbg > 0 ) cout << myname << "Cached projections for " << itpp << " TPC planes." << endl;
+  return 0;
+}
+
+//**********************************************************************
+
+Status GeoHelper::fillTickModel() const {
+  const string myname = "GeoHelper::fillTickModel: ";
+  const DetectorProperties* pdetprop = detectorProperties();
+  if ( pdetprop == nullptr ) {
+    cout << myname << "ERROR: Detector properties not found." << endl;
+    return 1;
+  }
+  double samplingrate = pdetprop->SamplingRate();
+  if ( samplingrate <= 0 ) {
+    cout << myname << "ERROR: Invalid sampling rate." << endl;
+    return 2;
+  }
+  vector<double> tickoff;
+  vector<double> tickcoef;
+  for ( const TpcProjection& tpc : m_tpcproj ) {
+    for ( const PlaneProjection& pla : tpc.planes ) {
+      tickoff.push_back(pdetprop->GetXTicksOffset(pla.pid.Plane, pla.pid.TPC, pla.pid.Cryostat));
+      tickcoef.push_back(pdetprop->GetXTicksCoefficient(pla.pid.TPC, pla.pid.Cryostat));
+    }
+  }
+  m_samplingrate = samplingrate;
+  m_tpptickoff.swap(tickoff);
+  m_tpptickcoef.swap(tickcoef);
+  m_haveTickModel = true;
+  return 0;
+}
+
+//**********************************************************************
+
+const GeoHelper::TpcProjection* GeoHelper::tpcProjection(const TPCID& tpcid) const {
+  if ( ! tpcid.isValid ) return nullptr;
+  if ( tpcid.Cryostat >= m_crytpc1.size() ) return nullptr;
+  Index itpc = m_crytpc1[tpcid.Cryostat] + tpcid.TPC;
+  if ( itpc >= m_tpcproj.size() ) return nullptr;
+  const TpcProjection& tpc = m_tpcproj[itpc];
+  // The TPC index may run into the next cryostat.
+  if ( tpc.tpcid != tpcid ) return nullptr;
+  return &tpc;
+}
+
+//**********************************************************************
+
+Status GeoHelper::fillTpcGrid() {
+  const string myname = "GeoHelper::fillTpcGrid: ";
+  // Relative tolerance for the box faces.
+  // This is larger than that used by the geometry service to find the TPC.
+  const double reltol = 1.e-3;
+  // Maximum # grid cells along each axis.
+  const Index maxcell = 256;
+  m_crytpc1.clear();
+  m_crybox.clear();
+  m_tpcbox.clear();
+  m_gridoff.clear();
+  m_gridtpc.clear();
+  if ( m_pgeo == nullptr ) return 1;
+  // Fill the boxes.
+  for ( Index icry=0; icry<ncryostat(); ++icry ) {
+    m_crytpc1.push_back(m_tpcbox.size());
+    double bounds[6];
+    m_pgeo->CryostatBoundaries(bounds, icry);
+    Box crybox;
+    for ( int icor=0; icor<3; ++icor ) {
+      crybox.lo[icor] = std::min(bounds[2*icor], bounds[2*icor+1]);
+      crybox.hi[icor] = std::max(bounds[2*icor], bounds[2*icor+1]);
+      crybox.tol[icor] = reltol*(crybox.hi[icor] - crybox.lo[icor]) + 1.e-6;
+    }
+    m_crybox.push_back(crybox);
+    for ( Index icrytpc=0; icrytpc<m_pgeo->NTPC(icry); ++icrytpc ) {
+      double pos1[3];
+      double pos2[3];
+      tpcCorners(icry, icrytpc, pos1, pos2);
+      Box tpcbox;
+      for ( int icor=0; icor<3; ++icor ) {
+        tpcbox.lo[icor] = std::min(pos1[icor], pos2[icor]);
+        tpcbox.hi[icor] = std::max(pos1[icor], pos2[icor]);
+        tpcbox.tol[icor] = reltol*(tpcbox.hi[icor] - tpcbox.lo[icor]) + 1.e-6;
+      }
+      m_tpcbox.push_back(tpcbox);
+    }
+  }
+  Index ntpcbox = m_tpcbox.size();
+  if ( ntpcbox == 0 ) return 0;
+  // The grid covers all the TPCs including tolerance. Along each axis, the cell size
+  // is about half that of the smallest TPC.
+  Index ncel = 1;
+  for ( int icor=0; icor<3; ++icor ) {
+    double xlo = m_tpcbox[0].lo[icor] - m_tpcbox[0].tol[icor];
+    double xhi = m_tpcbox[0].hi[icor] + m_tpcbox[0].tol[icor];
+    double dxmin = m_tpcbox[0].hi[icor] - m_tpcbox[0].lo[icor];
+    for ( const Box& box : m_tpcbox ) {
+      xlo = std::min(xlo, box.lo[icor] - box.tol[icor]);
+      xhi = std::max(xhi, box.hi[icor] + box.tol[icor]);
+      dxmin = std::min(dxmin, box.hi[icor] - box.lo[icor]);
+    }
+    Index ncor = 1;
+    if ( dxmin > 0.0 ) ncor = std::min(std::ceil(2.0*(xhi - xlo)/dxmin), double(maxcell));
+    if ( ncor == 0 ) ncor = 1;
+    m_gridlo[icor] = xlo;
+    m_gridn[icor] = ncor;
+    m_gridinv[icor] = ncor/(xhi - xlo);
+    ncel *= ncor;
+  }
+  // Record the TPCs overlapping each cell.
+  IndexVectorVector celtpcs(ncel);
+  for ( Index itpc=0; itpc<ntpcbox; ++itpc ) {
+    const Box& box = m_tpcbox[itpc];
+    Index icel1[3];
+    Index icel2[3];
+    for ( int icor=0; icor<3; ++icor ) {
+      double u1 = (box.lo[icor] - box.tol[icor] - m_gridlo[icor])*m_gridinv[icor];
+      double u2 = (box.hi[icor] + box.tol[icor] - m_gridlo[icor])*m_gridinv[icor];
+      icel1[icor] = u1 > 0.0 ? std::min(Index(u1), m_gridn[icor] - 1) : 0;
+      icel2[icor] = u2 > 0.0 ? std::min(Index(u2), m_gridn[icor] - 1) : 0;
+    }
+    for ( Index ix=icel1[0]; ix<=icel2[0]; ++ix ) {
+      for ( Index iy=icel1[1]; iy<=icel2[1]; ++iy ) {
+        for ( Index iz=icel1[2]; iz<=icel2[2]; ++iz ) {
+          celtpcs[(ix*m_gridn[1] + iy)*m_gridn[2] + iz].push_back(itpc);
+        }
+      }
+    }
+  }
+  m_gridoff.reserve(ncel + 1);
+  for ( const IndexVector& tpcs : celtpcs ) {
+    m_gridoff.push_back(m_gridtpc.size());
+    m_gridtpc.insert(m_gridtpc.end(), tpcs.begin(), tpcs.end());
+  }
+  m_gridoff.push_back(m_gridtpc.size());
+  if ( m_dbg > 0 ) cout << myname << "TPC grid has " << m_gridn[0] << " x " << m_gridn[1]
+                        << " x " << m_gridn[2] << " cells and " << m_gridtpc.size()
+                        << " entries." << endl;
   return 0;
 }
 
@@ -109,6 +109,26 @@ public:
   // Return the ROP for a TPC plane.
   Index rop(geo::PlaneID pid) const;
 
+  // Return the TPC holding a point xyz [cm].
+  // The candidate TPCs are taken from a uniform grid over the TPC volumes. Points within
+  // a small tolerance of a TPC boundary are resolved with the geometry service.
+  geo::TPCID findTpc(const double xyz[]) const;
+
+  // Return the global index (0, ..., ntpc()-1) of the TPC holding a point or badIndex().
+  Index findTpcIndex(const double xyz[]) const;
+
+  // Find the TPCs that may be crossed by the straight segment between xyz1 and xyz2 [cm].
+  // These are the TPCs overlapping the grid cells in the bounding box of the segment,
+  // ordered by global index. Some may not be crossed.
+  // Returns nonzero if the grid is not available.
+  Status findSegmentTpcs(const double xyz1[], const double xyz2[],
+                         std::vector<geo::TPCID>& tpcids) const;
+
+  // Return the cryostat holding a point or badIndex() if there is none.
+  // Points in a TPC and those well inside or outside all cryostat volumes are
+  // resolved without calling the geometry service.
+  Index findCryostat(const double xyz[]) const;
+
   // Print detector description.
   std::ostream& print(std::ostream& out =std::cout, int iopt =0, std::string prefix ="") const;
 
@@ -119,17 +139,118 @@ public:
   // Returns nrop() if the channel is not valid.
   Index channelRop(Index chan) const;
 
+  // Return the ROPs for an array of channels.
+  // rops is resized to match chans.
+  Status channelRops(const IndexVector& chans, IndexVector& rops) const;
+
+  // Channel properties taken from the channel table.
+  // These return badIndex() (or kUnknown for the view or an empty list
+  // for the TPCs) if the channel is not valid.
+  Index channelRopChannel(Index chan) const;
+  geo::View_t channelView(Index chan) const;
+  Index channelApa(Index chan) const;
+  const IndexVector& channelTpcs(Index chan) const;
+
   // Return all TPC plane positions for a spacetime point.
   // xyzt = {x, y, z, t} [cm,ns]
   // If usetime is false, the time component is not accessed and the DetectorProperties
   // service is not required.
+  // If the channel map is loaded, the positions are evaluated with the cached projection
+  // for each TPC plane. The tick constants are taken from the DetectorProperties service
+  // on the first call with usetime true; call checkTickModel before using this object from
+  // more than one thread.
   PlanePositionVector planePositions(const double xyzt[], bool usetime =true) const;
 
+  // Same as above but the positions are written to pps, e.g. to reuse its allocation.
+  // Returns nonzero for error.
+  Status planePositions(const double xyzt[], PlanePositionVector& pps, bool usetime =true) const;
+
+  // Project npt points in one TPC onto each of the planes in that TPC using the cached
+  // projection. The positions are passed as separate arrays xs, ys, zs and ts [cm,ns].
+  // On return, rops[ipla] is the ROP for TPC plane ipla and chans[ipla*npt + ipt] and
+  // ticks[ipla*npt + ipt] are the channel and tick for point ipt on that plane.
+  // The channel is badIndex() for points outside the TPC.
+  // The loops are written over contiguous arrays so the compiler can vectorize them.
+  // Returns nonzero if the cached projection is not available.
+  Status planePositions(const geo::TPCID& tpcid, Index npt,
+                        const double* xs, const double* ys, const double* zs, const double* ts,
+                        IndexVector& rops, IndexVector& chans, std::vector<double>& ticks,
+                        bool usetime =true) const;
+
+  // Find the (channel, tick) cells crossed by the straight segment between spacetime
+  // points xyzt1 and xyzt2 on each plane of a TPC using the cached projection.
+  // The segment is clipped to the TPC volume and split where it crosses a wire-pitch
+  // (half-integer wire coordinate) or tick boundary.
+  // For each piece, the ROP, channel, tick at the center of the piece and the fraction
+  // of the full segment length are appended to rops, chans, ticks and fracs.
+  // Adjacent pieces in the same cell are merged.
+  // Returns nonzero if the cached projection is not available.
+  Status planeCrossings(const geo::TPCID& tpcid, const double xyzt1[], const double xyzt2[],
+                        IndexVector& rops, IndexVector& chans, std::vector<double>& ticks,
+                        std::vector<double>& fracs, bool usetime =true) const;
+
+  // Fill the tick constants for the cached projection if they are not already filled.
+  // The projections fill them on first use, so this must be called before they are
+  // used with time from more than one thread.
+  // Returns nonzero for error.
+  Status checkTickModel() const;
+
+  // Evaluate the plane positions with calls to the LArSoft geometry and detector
+  // properties for each point. This is the reference for the cached projection.
+  PlanePositionVector geometryPlanePositions(const double xyzt[], bool usetime =true) const;
+
 private:
 
   // Fill info pertaining to APAs and ROPs assuming standard TPC-APA mapping.
   Status fillStandardApaMapping();
 
+  // Fill the channel-indexed table of ROPs from the ROP channel ranges.
+  Status fillChannelTable();
+
+  // Fill the cached projection for each TPC plane.
+  Status fillProjections();
+
+  // Fill the tick constants for the cached projection.
+  Status fillTickModel() const;
+
+  // Fill the TPC and cryostat volumes and the grid used to find the TPC for a point.
+  Status fillTpcGrid();
+
+private:
+
+  // Cached projection for one TPC plane.
+  struct PlaneProjection {
+    geo::PlaneID pid;
+    Index itpp;                   // Global TPC plane index.
+    Index rop;                    // ROP for the plane.
+    Index ropfirstchan;           // First channel in the ROP.
+    double w0;                    // The wire coordinate is w0 + wy*y + wz*z
+    double wy;
+    double wz;
+    IndexVector wirechan;         // Channel for each wire.
+  };
+
+  // Cached projection for one TPC.
+  struct TpcProjection {
+    geo::TPCID tpcid;
+    double lo[3];                 // Lower corner of the TPC volume.
+    double hi[3];                 // Upper corner of the TPC volume.
+    std::vector<PlaneProjection> planes;
+  };
+
+  // Return the cached projection for a TPC or null if there is none.
+  const TpcProjection* tpcProjection(const geo::TPCID& tpcid) const;
+
+  // Axis-aligned volume for a TPC or cryostat.
+  // Points closer than tol to a face are resolved with the geometry service.
+  struct Box {
+    double lo[3];
+    double hi[3];
+    double tol[3];
+    // Return 0 if a point is inside, 1 if it is near a face and 2 if it is outside.
+    int locate(const double xyz[]) const;
+  };
+
 private:
 
   const geo::GeometryCore* m_pgeo;
@@ -150,6 +271,21 @@ private:
   ViewVector m_ropview;         // View (kU, kV, kZ) for each ROP
   NameVector m_ropname;         // Name for each ROP
   PlaneIDIndexMap m_tpprop;     // Global ROP index for each TPC plane.
+  IndexVector m_chanrop;        // ROP for each channel (nrop for channels not in a ROP)
+  IndexVector m_chanropchan;    // Channel index in the ROP for each channel
+  std::vector<TpcProjection> m_tpcproj;        // Cached projection for each TPC.
+  mutable bool m_haveTickModel = false;        // Are the tick constants filled?
+  mutable double m_samplingrate = 0.0;         // TDC sampling rate [ns].
+  mutable std::vector<double> m_tpptickoff;    // Tick offset for each TPC plane.
+  mutable std::vector<double> m_tpptickcoef;   // X-to-tick coefficient for each TPC plane.
+  IndexVector m_crytpc1;                       // Global index of the first TPC in each cryostat.
+  std::vector<Box> m_crybox;                   // Volume for each cryostat.
+  std::vector<Box> m_tpcbox;                   // Volume for each TPC.
+  double m_gridlo[3];                          // Lower corner of the TPC grid.
+  double m_gridinv[3];                         // Inverse cell size for the TPC grid.
+  Index m_gridn[3];                            // # cells along each axis of the TPC grid.
+  IndexVector m_gridoff;                       // First entry in m_gridtpc for each grid cell.
+  IndexVector m_gridtpc;                       // Global indices of the TPCs overlapping each cell.
 };
 
 #endif
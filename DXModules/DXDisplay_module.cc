@@ -112,6 +112,7 @@
 #include "DXGeometry/GeoHelper.h"
 #include "DXPerf/MCTrajectoryFollower.h"
 #include "DXPerf/SimChannelTupler.h"
+#include "DXPerf/SimChannelDemultiplexer.h"
 #include "DXPerf/TpcSignalMatcher.h"
 #include "DXPerf/TpcSignalMatchTree.h"
 
@@ -203,7 +204,7 @@ private:
   void processTracks(const art::Event& evt, string conname, string label) const;
 
   // Delete event histograms after writing them to the output file.
-  // This saves a lot of memory.
+  // This saves a lot of memory. Histograms with no entries are not written.
   void removeEventHists();
 
 private:
@@ -248,6 +249,9 @@ private:
   bool fUseGammaNotPi0;                // Flag to select MCParticle gamma from pi0 instead of pi0
   bool fUseSecondaries;                // Flag to include secondary MC particles for tree and hists.
   bool fUseSimChannelDescendants;      // Use descendants when making SimChannel signal hists
+  bool fOptimalClusterMatching;        // Match clusters with the optimal assignment
+  string fClusterMatchMetric;          // Name of the distance metric used to match clusters
+  unsigned int fClusterMatchThreadCount;  // # threads used to match clusters
   double fBinSize;                     // For dE/dx work: the value of dx. 
 
   // Derived control parameters.
@@ -309,6 +313,8 @@ private:
   // Other variables that will be shared between different methods.
   double                            fElectronsToGeV; // conversion factor
   double fmcpdsmax;  // Maximum step size for filling the MC particle trajectory hists
+  unsigned int fmcpnthread;  // # threads used to fill the MC particle signal maps
+  TpcSignalMatcher::Metric fclumetric;  // Distance metric used to match clusters
   double fadcmevu;   // MeV to ADC conversion factor for U-planes.
   double fadcmevv;   // MeV to ADC conversion factor for V-planes.
   double fadcmevz;   // MeV to ADC conversion factor for X-planes.
@@ -401,6 +407,8 @@ void DXDisplay::beginJob() {
   if ( fDoMcParticleTree ) mcptreename = "McParticleTree";
   m_pmctrajmc = new MCTrajectoryFollower(fmcpdsmax, mcptreename, fgeohelp, minNptdet, 0);
   m_pmctrajmd = new MCTrajectoryFollower(fmcpdsmax, "", fgeohelp, 0, 0);
+  // The followers see the same particles and so share the trajectory geometry.
+  m_pmctrajmd->setCache(m_pmctrajmc->cache());
 
   // Match trees.
   m_ptsmtSimChannelCluster.reset(new TpcSignalMatchTree("SimChannelClusterMatch"));
@@ -513,6 +521,9 @@ void DXDisplay::reconfigure(fhicl::ParameterSet const& p) {
   fUseGammaNotPi0                = p.get<bool>("UseGammaNotPi0");
   fUseSecondaries                = p.get<bool>("UseSecondaries");
   fUseSimChannelDescendants      = p.get<bool>("UseSimChannelDescendants");
+  fOptimalClusterMatching        = p.get<bool>("OptimalClusterMatching", false);
+  fClusterMatchMetric            = p.get<string>("ClusterMatchMetric", "BinFraction");
+  fClusterMatchThreadCount       = p.get<unsigned int>("ClusterMatchThreadCount", 1);
   fBinSize                       = p.get<double>("BinSize");
   fscCapacity                    = p.get<double>("SimChannelSize");
   fTdcTickMin                    = p.get<int>("TdcTickMin");
@@ -521,6 +532,7 @@ void DXDisplay::reconfigure(fhicl::ParameterSet const& p) {
   fNTickPerBinForAll             = p.get<int>("NTickPerBinForAll");
   fNChanPerBinForAll             = p.get<int>("NChanPerBinForAll");
   fmcpdsmax                      = p.get<double>("McParticleDsMax");
+  fmcpnthread                    = p.get<unsigned int>("McParticleThreadCount", 1);
   fadcmevu                       = p.get<double>("AdcToMevConversionU");
   fadcmevv                       = p.get<double>("AdcToMevConversionV");
   fadcmevz                       = p.get<double>("AdcToMevConversionZ");
@@ -545,6 +557,11 @@ void DXDisplay::reconfigure(fhicl::ParameterSet const& p) {
   fDoWires = fDoDeconvolutedSignalHists;
   fDoHits = fDoHitSignalHists;
   fDoClusters = fDoClusterSignalMaps;
+  fclumetric = TpcSignalMatcher::metric(fClusterMatchMetric);
+  if ( fclumetric == TpcSignalMatcher::UNDEFINEDMETRIC ) {
+    cout << myname << "ERROR: Invalid cluster match metric: " << fClusterMatchMetric << endl;
+    abort();
+  }
 
   // Display properties.
   string sep = ": ";
@@ -584,6 +601,9 @@ void DXDisplay::reconfigure(fhicl::ParameterSet const& p) {
     cout << prefix << setw(wlab) << "UseGammaNotPi0" << sep << fUseGammaNotPi0 << endl;
     cout << prefix << setw(wlab) << "UseSecondaries" << sep << fUseSecondaries << endl;
     cout << prefix << setw(wlab) << "UseSimChannelDescendants" << sep << fUseSimChannelDescendants << endl;
+    cout << prefix << setw(wlab) << "OptimalClusterMatching" << sep << fOptimalClusterMatching << endl;
+    cout << prefix << setw(wlab) << "ClusterMatchMetric" << sep << fClusterMatchMetric << endl;
+    cout << prefix << setw(wlab) << "ClusterMatchThreadCount" << sep << fClusterMatchThreadCount << endl;
     cout << prefix << setw(wlab) << "BinSize" << sep << fBinSize << endl;
     cout << prefix << setw(wlab) << "SimChannelSize" << sep << fscCapacity << endl;
     cout << prefix << setw(wlab) << "TdcTickMin" << sep << fTdcTickMin << endl;
@@ -592,6 +612,7 @@ void DXDisplay::reconfigure(fhicl::ParameterSet const& p) {
     cout << prefix << setw(wlab) << "NTickPerBinForAll" << sep << fNTickPerBinForAll << endl;
     cout << prefix << setw(wlab) << "NChanPerBinForAll" << sep << fNChanPerBinForAll << endl;
     cout << prefix << setw(wlab) << "McParticleDsMax" << sep << fmcpdsmax << endl;
+    cout << prefix << setw(wlab) << "McParticleThreadCount" << sep << fmcpnthread << endl;
     cout << prefix << setw(wlab) << "AdcToMevConversionU" << sep << fadcmevu << endl;
     cout << prefix << setw(wlab) << "AdcToMevConversionV" << sep << fadcmevv << endl;
     cout << prefix << setw(wlab) << "AdcToMevConversionZ" << sep << fadcmevz << endl;
@@ -794,13 +815,20 @@ void DXDisplay::analyze(const art::Event& event) {
     fprf_mcsedepv = 0.0;
     if ( fDoMcParticleSelection ) {
       if ( fdbg > 1 ) cout << myname << "Selecting MC particles." << endl;
-      for ( auto const& particle : (*particleHandle) ) {
+      // Select particles and create their signal maps. The maps are filled afterwards
+      // with fmcpnthread threads and the results are then recorded in particle order.
+      const vector<MCParticle>& allpars = *particleHandle;
+      unsigned int npar = allpars.size();
+      vector<int> mcsels(npar, -1);   // Index in mcpars for each selected particle.
+      MCTrajectoryFollower::MCParticlePtrVector mcpars;
+      MCTrajectoryFollower::SignalMapVector mcmaps;
+      TpcSignalMapVector mcmapptrs;
+      for ( unsigned int ipar=0; ipar<npar; ++ipar ) {
+        const MCParticle& particle = allpars[ipar];
         int trackid = particle.TrackId();
         pars[trackid] = &particle;
         int rpdg = reducedPDG(particle.PdgCode());
-        if ( rpdg == 8 && !firstselect ) fprf_enu += particle.E();
         int proc = intProcess(particle.Process());
-        int endproc = intProcess(particle.EndProcess());
         // Select particles.
         // 21apr2015: Keep also gammas
         // 08jul2015: Keep also gamma from initial state pi0
@@ -847,7 +875,30 @@ void DXDisplay::analyze(const art::Event& event) {
           ssnam << trackid;
           bool usetpc = true;
           TpcSignalMapPtr pmctpmc(new TpcSignalMap(ssnam.str(), *&particle, fgeohelp, usetpc));
-          int keepstat = m_pmctrajmc->addMCParticle(particle, pmctpmc.get(), false);
+          mcsels[ipar] = mcpars.size();
+          mcpars.push_back(&particle);
+          mcmaps.push_back(pmctpmc.get());
+          mcmapptrs.push_back(pmctpmc);
+        }
+      }
+      MCTrajectoryFollower::StatusVector mcstats;
+      m_pmctrajmc->addMCParticles(mcpars, mcmaps, false, MCTrajectoryFollower::IndexVectorPtrVector(),
+                                  mcstats, fmcpnthread);
+      // Record the accepted particles and create their descendant and SimChannel maps.
+      MCTrajectoryFollower::MCParticlePtrVector mdpars;
+      MCTrajectoryFollower::SignalMapVector mdmaps;
+      MCTrajectoryFollower::IndexVectorPtrVector mdtids;
+      for ( unsigned int ipar=0; ipar<npar; ++ipar ) {
+        const MCParticle& particle = allpars[ipar];
+        int trackid = particle.TrackId();
+        int rpdg = reducedPDG(particle.PdgCode());
+        if ( rpdg == 8 && !firstselect ) fprf_enu += particle.E();
+        int proc = intProcess(particle.Process());
+        int endproc = intProcess(particle.EndProcess());
+        int isel = mcsels[ipar];
+        if ( isel >= 0 ) {
+          TpcSignalMapPtr pmctpmc = mcmapptrs[isel];
+          int keepstat = mcstats[isel];
           // Keep tracks inside detector.
           if ( keepstat == 0 ) {
             if ( firstselect ) {
@@ -857,24 +908,24 @@ void DXDisplay::analyze(const art::Event& event) {
               fprf_e = particle.E();
               firstselect = false;
             }
-            string snam = ssnam.str();
+            string snam = pmctpmc->name();
+            bool usetpc = true;
             if ( fDoMcParticleSignalMaps ) {
               pmctpmc->buildHits();
               selectedMcTpcSignalMapsMC.push_back(pmctpmc);
             }
-            TpcSignalMapPtr pmctpmd;
             if ( fDoMcDescendantSignalMaps ) {
               snam[2] = 'd';  // Use "mcd" instead of "mcp" for map with descendants
-              pmctpmd.reset(new TpcSignalMap(snam, *&particle, fgeohelp, usetpc));
-              m_pmctrajmd->addMCParticle(particle, pmctpmd.get(), true, &descendants[trackid]);
-              pmctpmd->buildHits();
+              TpcSignalMapPtr pmctpmd(new TpcSignalMap(snam, *&particle, fgeohelp, usetpc));
+              mdpars.push_back(&particle);
+              mdmaps.push_back(pmctpmd.get());
+              mdtids.push_back(&descendants[trackid]);
               selectedMcTpcSignalMapsMD.push_back(pmctpmd);
             }
             if ( fDoSimChannelSignalMaps ) {
               snam[2] = 's';  // Use "mcs" instead of "mcp" for SimHits.
               TpcSignalMapPtr pmctpsc(new TpcSignalMap(snam, *&particle, fgeohelp, usetpc));
               selectedMcTpcSignalMapsSC.push_back(pmctpsc);
-              if ( fDoMcDescendantSignalMaps ) pmctpsc->copySegments(*pmctpmd);
             }
             if ( fdbg > 1 ) cout << myname << "  Selected";
           } else {
@@ -907,6 +958,16 @@ void DXDisplay::analyze(const art::Event& event) {
           cout << endl;
         }
       }
+      // Fill the descendant signal maps.
+      if ( fDoMcDescendantSignalMaps ) {
+        MCTrajectoryFollower::StatusVector mdstats;
+        m_pmctrajmd->addMCParticles(mdpars, mdmaps, true, mdtids, mdstats, fmcpnthread);
+        for ( unsigned int imd=0; imd<selectedMcTpcSignalMapsMD.size(); ++imd ) {
+          TpcSignalMapPtr pmctpmd = selectedMcTpcSignalMapsMD[imd];
+          pmctpmd->buildHits();
+          if ( fDoSimChannelSignalMaps ) selectedMcTpcSignalMapsSC[imd]->copySegments(*pmctpmd);
+        }
+      }
       // Display the MC particle signal maps.
       int flag = 0;
       if ( fdbg > 2 ) flag = 11;
@@ -974,10 +1035,12 @@ void DXDisplay::analyze(const art::Event& event) {
     if ( fDoMcParticleSignalHists ) {
       if ( fdbg > 1 ) cout << myname << "Create and fill MC particle histograms for all selected tracks." << endl;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hcreateSim.create("mcp" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                        "MC particle signals for " + geohelp.ropName(irop));
+        ChannelTickHist hist = hcreateSim.book("mcp" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                               "MC particle signals for " + geohelp.ropName(irop));
+        for ( auto pmctp : selectedMcTpcSignalMapsMC ) pmctp->fillRopChannelTickHist(hist, irop);
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
         m_eventhists.push_back(ph);
-        for ( auto pmctp : selectedMcTpcSignalMapsMC ) pmctp->fillRopChannelTickHist(ph, irop);
         if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 4);
       }
     }
@@ -986,15 +1049,13 @@ void DXDisplay::analyze(const art::Event& event) {
     if ( fDoMcDescendantSignalAllHists ) {
       if ( fdbg > 1 ) cout << myname << "Create and fill MC descendant histograms for all selected tracks." << endl;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        unsigned int nbin = 0;
-        for ( auto pmctp : selectedMcTpcSignalMapsMD ) nbin += pmctp->ropNbin(irop);
-        if ( nbin ) {
-          TH2* ph = hcreateSim.create("mcd" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                            "MC par+desc signals for " + geohelp.ropName(irop));
-          m_eventhists.push_back(ph);
-          for ( auto pmctp : selectedMcTpcSignalMapsMD ) pmctp->fillRopChannelTickHist(ph, irop);
-          if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 4);
-        }
+        ChannelTickHist hist = hcreateSim.book("mcd" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                               "MC par+desc signals for " + geohelp.ropName(irop));
+        for ( auto pmctp : selectedMcTpcSignalMapsMD ) pmctp->fillRopChannelTickHist(hist, irop);
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
+        m_eventhists.push_back(ph);
+        if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 4);
       }
     }
 
@@ -1068,29 +1129,29 @@ void DXDisplay::analyze(const art::Event& event) {
       if ( fdbg > 0 ) cout << myname << "Adding sim channels and hits to SimChannel signal maps (size = "
                           << simChannelHandle->size() << ")" << endl;
 
-      // Add SimChannels to the complete signal map.
-      for ( auto const& simchan : (*simChannelHandle) ) {
-        ptpsim->addSimChannel(*&simchan, -1);
-      }
+      // Add SimChannels to the complete signal map and the selected-track SimChannel
+      // signal maps in one pass over the IDEs.
+      // The TPC for each IDE is found once and held in a cache for this event.
+      SimChannelTpcCachePtr psctpc(new SimChannelTpcCache(fgeohelp));
+      SimChannelDemultiplexer scdemux(fgeohelp);
+      scdemux.setTpcCache(psctpc);
+      scdemux.addDestination(-1, ptpsim.get());
+      for ( auto pmctp : selectedMcTpcSignalMapsSC ) {
+        Index tid = pmctp->mcinfo()->trackID;
+        if ( fUseSimChannelDescendants ) {
+          scdemux.addDestination(descendants[tid], pmctp.get());
+        } else {
+          scdemux.addDestination(tid, pmctp.get());
+        }
+      }  // End loop over selected SimChannel MC tracks
+      scdemux.addSimChannels(*simChannelHandle);
+      if ( fdbg > 1 ) cout << myname << "SimChannel IDE TPC lookup count: " << psctpc->lookupCount() << endl;
       ptpsim->buildHits();
+      for ( auto pmctp : selectedMcTpcSignalMapsSC ) pmctp->buildHits();
 
       // Split the complete SimChannel signal map by ROP.
       ptpsim->splitByRop(tpsimByRop, true);
 
-      // Add SimChannels to selected-track SimChannel signal maps.
-      for ( auto pmctp : selectedMcTpcSignalMapsSC ) {
-        // Add the sim channel info to the selected tracks.
-        for ( auto const& simchan : (*simChannelHandle) ) {
-          Index tid = pmctp->mcinfo()->trackID;
-          if ( fUseSimChannelDescendants ) {
-            pmctp->addSimChannel(*&simchan, descendants[tid]);
-          } else {
-            pmctp->addSimChannel(*&simchan, tid);
-          }
-        }  // End loop over sim channels in the event. 
-        pmctp->buildHits();
-      }  // End loop over selected SimChannel MC tracks
-
       // Split the selected-track SimChannel signal maps by ROP.
       for ( const TpcSignalMapPtr& ptsm : selectedMcTpcSignalMapsSC ) {
         ptsm->splitByRop(selectedMcTpcSignalMapsSCbyROP, true);
@@ -1150,42 +1211,41 @@ void DXDisplay::analyze(const art::Event& event) {
     if ( fDoSimChannelSignalHists ) {
   
       // All sim hits for each ROP.
+      // Histograms are only created for ROPs with signals.
       vector<TH2*> spahists;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hcreateSim.create("sim" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                    "Sim channels for " + geohelp.ropName(irop));
+        ChannelTickHist hist = hcreateSim.book("sim" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                               "Sim channels for " + geohelp.ropName(irop));
+        for ( const auto pmctp : tpsimByRop ) pmctp->fillRopChannelTickHist(hist, irop);
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
         spahists.push_back(ph);
         m_eventhists.push_back(ph);
-        for ( const auto pmctp : tpsimByRop ) {
-          if ( pmctp->ropNbin(irop) == 0 ) continue;
-          pmctp->fillRopChannelTickHist(ph, irop);
-        }
       }
       // Display the contents of each SimChannel histogram.
       if ( fdbg > 1 ) {
         cout << myname << "Summary of complete SimChannel histograms:" << endl;
-        for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-          summarize2dHist(spahists[irop], myname, wnam, 4, 4);
+        for ( TH2* ph : spahists ) {
+          summarize2dHist(ph, myname, wnam, 4, 4);
         }
       }
   
       // All selected particles.
       vector<TH2*> sphists;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hcreateSim.create("ssi" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                    "Sim channels for " + geohelp.ropName(irop));
+        ChannelTickHist hist = hcreateSim.book("ssi" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                               "Sim channels for " + geohelp.ropName(irop));
+        for ( const auto pmctp : selectedMcTpcSignalMapsSC ) pmctp->fillRopChannelTickHist(hist, irop);
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
         sphists.push_back(ph);
         m_eventhists.push_back(ph);
-        for ( const auto pmctp : selectedMcTpcSignalMapsSC ) {
-          if ( pmctp->ropNbin(irop) == 0 ) continue;
-          pmctp->fillRopChannelTickHist(ph, irop);
-        }
       }
       // Display the contents of each SimChannel histogram.
       if ( fdbg > 1 ) {
         cout << myname << "Summary of SimChannel histograms for all selected particles:" << endl;
-        for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-          summarize2dHist(sphists[irop], myname, wnam, 4, 4);
+        for ( TH2* ph : sphists ) {
+          summarize2dHist(ph, myname, wnam, 4, 4);
         }
       }
   
@@ -1430,12 +1490,11 @@ void DXDisplay::analyze(const art::Event& event) {
 
       // Create the deconvoluted signal histograms.
       if ( fDoDeconvolutedSignalHists ) {
-        vector<TH2*> dcohists;
+        // Each histogram is created when its first signal is filled.
+        vector<ChannelTickHist> dcohists;
         for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-          TH2* ph = hcreateDco.create("dco" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                       "Prepared signals for " + geohelp.ropName(irop));
-          dcohists.push_back(ph);
-          m_eventhists.push_back(ph);
+          dcohists.push_back(hcreateDco.book("dco" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                             "Prepared signals for " + geohelp.ropName(irop)));
         }
 
         for ( auto const& wire : (*wiresHandle) ) {
@@ -1444,7 +1503,7 @@ void DXDisplay::analyze(const art::Event& event) {
           unsigned int iropchan = ichan - geohelp.ropFirstChannel(irop);
           auto sigs = wire.Signal();
           const auto& roisigs = wire.SignalROI();
-          TH2* ph = dcohists[irop];
+          ChannelTickHist& hist = dcohists[irop];
           if ( fdbg >= 3 ) cout << myname << "Prepared channel " << ichan
                                << " (ROP-chan = " << irop << "-" << iropchan << ")"
                                << " with view " << wire.View()
@@ -1455,15 +1514,18 @@ void DXDisplay::analyze(const art::Event& event) {
             double wt = roisigs[tick];
             if ( wt == 0 ) continue;
             if ( fhistusede ) wt *= adc2de(ichan);
-            ph->Fill(tick, iropchan, wt);
+            hist.hist()->Fill(tick, iropchan, wt);
           }
         }
+        for ( ChannelTickHist& hist : dcohists ) {
+          if ( hist.isCreated() ) m_eventhists.push_back(hist.createdHist());
+        }
 
         // Display the contents of each deconvoluted signal histogram.
         if ( fdbg > 1 ) {
           cout << myname << "Summary of deconvoluted data histograms:" << endl;
-          for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-            summarize2dHist(dcohists[irop], myname, wnam, 4, 7);
+          for ( const ChannelTickHist& hist : dcohists ) {
+            if ( hist.isCreated() ) summarize2dHist(hist.createdHist(), myname, wnam, 4, 7);
           }
         }
       }  // end DoDeconvolutedSignalHists
@@ -1488,19 +1550,17 @@ void DXDisplay::analyze(const art::Event& event) {
 
     // Create the hit histograms.
     if ( fDoHitSignalHists ) {
-      vector<TH2*> hithists;
+      // Each histogram is created when its first hit is filled.
+      vector<ChannelTickHist> hithists;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hcreateRecoPeak.create("hip" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                         "Hit peaks for " + geohelp.ropName(irop));
-        hithists.push_back(ph);
-          m_eventhists.push_back(ph);
+        hithists.push_back(hcreateRecoPeak.book("hip" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                                "Hit peaks for " + geohelp.ropName(irop)));
       }
 
       for ( auto const& hit : (*hitsHandle) ) {
         int ichan = hit.Channel();
         unsigned int irop = geohelp.channelRop(ichan);
         unsigned int iropchan = ichan - geohelp.ropFirstChannel(irop);
-        TH2* ph = hithists[irop];
         if ( fdbg > 3 ) cout << myname << "Hit channel " << ichan
                             << " (ROP-chan = " << irop << "-" << iropchan << ")"
                             << " with view " << hit.View()
@@ -1510,14 +1570,17 @@ void DXDisplay::analyze(const art::Event& event) {
         double wt = hit.SummedADC();
         if ( wt == 0 ) continue;
         if ( fhistusede ) wt *= adc2de(ichan);
+        TH2* ph = hithists[irop].hist();
         if ( fdbg > 3 ) cout << myname << "    Hit histo " << ph->GetName() << " time/channel/wt = "
                              << hit.PeakTime() << "/" << iropchan << "/" << wt << endl;
         ph->Fill(hit.PeakTime(), iropchan, wt);
       }
 
       if ( fdbg > 1 ) cout << myname << "Summary of hit peak histograms:" << endl;
-      for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hithists[irop];
+      for ( const ChannelTickHist& hist : hithists ) {
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
+        m_eventhists.push_back(ph);
         if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 7);
       }
 
@@ -1541,10 +1604,12 @@ void DXDisplay::analyze(const art::Event& event) {
       hitsSignalMap.fillChannelTickHist(phallhits);
       if ( fdbg > 1 ) cout << myname << "Summary of hit histograms:" << endl;
       for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-        TH2* ph = hcreateReco.create("hit" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                     "Hits for " + geohelp.ropName(irop));
+        ChannelTickHist hist = hcreateReco.book("hit" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                                "Hits for " + geohelp.ropName(irop));
+        hitsSignalMap.fillRopChannelTickHist(hist, irop);
+        TH2* ph = hist.createdHist();
+        if ( ph == nullptr ) continue;
         m_eventhists.push_back(ph);
-        hitsSignalMap.fillRopChannelTickHist(ph,irop);
         if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 7);
       }
       if ( fdbg > 1 ) summarize2dHist(phallhits, myname, wnam, 4, 7);
@@ -1577,24 +1642,30 @@ void DXDisplay::analyze(const art::Event& event) {
       pclusterSignalMaps = clures.second;
     }  // end DoClusterSignalMaps
 
+    TpcSignalMatcher::Assignment clumode = fOptimalClusterMatching ? TpcSignalMatcher::OPTIMAL
+                                                                   : TpcSignalMatcher::GREEDY;
+
     // Evaluate the MC cluster-finding performance.
     if ( fDoMcParticleClusterMatching ) {
       if ( fdbg > 1 ) cout << myname << "Matching MC and clusters." << endl;
-      TpcSignalMatcher clumatchmc(selectedMcTpcSignalMapsMCbyROP, *pclusterSignalMaps, true, 0);
+      TpcSignalMatcher clumatchmc(selectedMcTpcSignalMapsMCbyROP, *pclusterSignalMaps, true, 0,
+                                  clumode, fclumetric, fClusterMatchThreadCount);
       clumatchmc.print(cout, 0);
     }
 
     // Evaluate the MD cluster-finding performance.
     if ( fDoMcDescendantClusterMatching ) {
       if ( fdbg > 1 ) cout << myname << "Matching MD and clusters." << endl;
-      TpcSignalMatcher clumatchmd(selectedMcTpcSignalMapsMDbyROP, *pclusterSignalMaps, true, 0);
+      TpcSignalMatcher clumatchmd(selectedMcTpcSignalMapsMDbyROP, *pclusterSignalMaps, true, 0,
+                                  clumode, fclumetric, fClusterMatchThreadCount);
       clumatchmd.print(cout, 0);
     }
 
     // Evaluate the SC cluster-finding performance.
     if ( fDoSimChannelClusterMatching ) {
       if ( fdbg > 1 ) cout << myname << "Matching SC and clusters." << endl;
-      TpcSignalMatcher match(selectedMcTpcSignalMapsSCbyROP, *pclusterSignalMaps, true, 0);
+      TpcSignalMatcher match(selectedMcTpcSignalMapsSCbyROP, *pclusterSignalMaps, true, 0,
+                             clumode, fclumetric, fClusterMatchThreadCount);
       match.print(cout, 0);
       if ( fdbg > 1 ) cout << myname << "Filling match tree." << endl;
       if ( m_ptsmtSimChannelCluster ) m_ptsmtSimChannelCluster->fill(event.id(), match);
@@ -1603,7 +1674,8 @@ void DXDisplay::analyze(const art::Event& event) {
     // Evaluate the reference cluster cluster-finding performance.
     if ( fDoRefClusterClusterMatching ) {
       if ( fdbg > 1 ) cout << myname << "Matching reference clusters and clusters." << endl;
-      TpcSignalMatcher match(*prefClusterSignalMaps, *pclusterSignalMaps, true, 0);
+      TpcSignalMatcher match(*prefClusterSignalMaps, *pclusterSignalMaps, true, 0,
+                             clumode, fclumetric, fClusterMatchThreadCount);
       match.print(cout, 0);
       if ( fdbg > 1 ) cout << myname << "Filling match tree." << endl;
       if ( m_ptsmtRefClusterCluster ) m_ptsmtRefClusterCluster->fill(event.id(), match);
@@ -1725,10 +1797,12 @@ processClusters(const art::Event& event, string conname, string label,
     // Create the channel-tick histograms for all clusters.
     if ( fdbg > 1 ) cout << myname << "Summary of cluster hit histograms:" << endl;
     for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-      TH2* ph = hcreateReco.create(label + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                   "Cluster hits for " + geohelp.ropName(irop));
+      ChannelTickHist hist = hcreateReco.book(label + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                              "Cluster hits for " + geohelp.ropName(irop));
+      allClusterSignalMap.fillRopChannelTickHist(hist, irop);
+      TH2* ph = hist.createdHist();
+      if ( ph == nullptr ) continue;
       m_eventhists.push_back(ph);
-      allClusterSignalMap.fillRopChannelTickHist(ph,irop);
       if ( fdbg > 1 ) summarize2dHist(ph, myname, wnam, 4, 7);
     }
 
@@ -1806,7 +1880,8 @@ void DXDisplay::removeEventHists() {
   if ( fdbg >= 3 ) cout << myname << "Deleting events hists, count = " << m_eventhists.size() << endl;
   for ( TH1* ph : m_eventhists ) {
     if ( fdbg >= 4 ) cout << myname << "Removing " << ph->GetName() << endl;
-    ph->Write();
+    // Histograms that were never filled are not written.
+    if ( ph->GetEntries() > 0 ) ph->Write();
     ph->SetDirectory(0);
     delete ph;
   }
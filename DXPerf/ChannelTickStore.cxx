@@ -0,0 +1,824 @@
+// ChannelTickStore.cxx
+
+#include "ChannelTickStore.h"
+#include <algorithm>
+#include <limits>
+#include <bitset>
+
+typedef ChannelTickStore::Index Index;
+typedef ChannelTickStore::Channel Channel;
+typedef ChannelTickStore::ChannelRange ChannelRange;
+typedef ChannelTickStore::Tick Tick;
+typedef ChannelTickStore::TickRange TickRange;
+typedef ChannelTickStore::Signal Signal;
+typedef ChannelTickStore::ChannelBins ChannelBins;
+typedef ChannelTickStore::ChannelBits ChannelBits;
+typedef ChannelTickStore::Word Word;
+typedef ChannelTickStore::ChannelVector ChannelVector;
+typedef ChannelTickStore::IndexVector IndexVector;
+typedef ChannelTickStore::TickVector TickVector;
+typedef ChannelTickStore::SignalVector SignalVector;
+
+//**********************************************************************
+// Sub class methods.
+//**********************************************************************
+
+Index ChannelTickStore::ChannelBins::find(Tick tick) const {
+  if ( m_pfills != nullptr ) {
+    if ( tick < m_tick1 ) return m_nbin;
+    Index ibin = tick - m_tick1;
+    if ( ibin < m_nbin && m_pfills[ibin] ) return ibin;
+    return m_nbin;
+  }
+  const Tick* ptick = std::lower_bound(m_pticks, m_pticks + m_nbin, tick);
+  Index ibin = ptick - m_pticks;
+  if ( ibin < m_nbin && *ptick == tick ) return ibin;
+  return m_nbin;
+}
+
+//**********************************************************************
+
+Signal ChannelTickStore::ChannelBins::signalSum() const {
+  Signal sum = 0.0;
+  for ( Index ibin=0; ibin<m_nbin; ++ibin ) sum += signal(ibin);
+  return sum;
+}
+
+namespace {
+
+const Tick wordBits = 64;
+
+// Return the bit word holding a tick. Negative ticks round down.
+Tick bitWord(Tick tick) {
+  return tick >= 0 ? tick/wordBits : -((wordBits - 1 - tick)/wordBits);
+}
+
+}
+
+//**********************************************************************
+
+bool ChannelTickStore::ChannelBits::filled(Tick tick) const {
+  Tick iwrd = bitWord(tick);
+  if ( iwrd < m_word0 || iwrd >= m_word0 + Tick(m_nword) ) return false;
+  Index ibit = tick - wordBits*iwrd;
+  return (m_pwords[iwrd - m_word0] >> ibit) & 1;
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::ChannelBits::overlapCount(const ChannelBits& rhs) const {
+  Tick iwrd1 = std::max(m_word0, rhs.m_word0);
+  Tick iwrd2 = std::min(m_word0 + Tick(m_nword), rhs.m_word0 + Tick(rhs.m_nword));
+  Index count = 0;
+  for ( Tick iwrd=iwrd1; iwrd<iwrd2; ++iwrd ) {
+    Word both = m_pwords[iwrd - m_word0] & rhs.m_pwords[iwrd - rhs.m_word0];
+    if ( both ) count += std::bitset<64>(both).count();
+  }
+  return count;
+}
+
+//**********************************************************************
+// Main class.
+//**********************************************************************
+
+ChannelTickStore::ChannelTickStore()
+: m_pcols(new Columns),
+  m_ch1(0), m_ch2(std::numeric_limits<Channel>::max()) { }
+
+//**********************************************************************
+
+void ChannelTickStore::add(Channel chan, Tick tick, Signal sig) {
+  detach();
+  TileVector& tiles = m_pcols->tiles;
+  if ( tiles.size() ) {
+    Index itil = findTile(chan);
+    if ( itil < tiles.size() ) {
+      if ( addDense(tiles[itil], chan, tick, sig) ) return;
+      sparsify(itil);
+    }
+  }
+  m_staged.push_back({chan, tick, sig});
+}
+
+//**********************************************************************
+
+void ChannelTickStore::consolidate() const {
+  if ( m_staged.empty() ) {
+    if ( m_indexStale ) buildChannelIndex();
+    return;
+  }
+  detach();
+  Columns& cols = *m_pcols;
+  // Sort the staged signals keeping the insertion order for each bin so that
+  // the sums are the same as those from adding one signal at a time.
+  // Signals committed from a TpcSignalMap batch are already sorted.
+  auto lessBin = [](const StagedSignal& lhs, const StagedSignal& rhs) {
+    if ( lhs.chan != rhs.chan ) return lhs.chan < rhs.chan;
+    return lhs.tick < rhs.tick;
+  };
+  if ( ! std::is_sorted(m_staged.begin(), m_staged.end(), lessBin) ) {
+    std::stable_sort(m_staged.begin(), m_staged.end(), lessBin);
+  }
+  ChannelVector chans;
+  IndexVector offsets;
+  TickVector ticks;
+  SignalVector sigs;
+  chans.reserve(cols.spchans.size() + 1);
+  offsets.reserve(cols.offsets.size() + 1);
+  ticks.reserve(cols.ticks.size() + m_staged.size());
+  sigs.reserve(cols.sigs.size() + m_staged.size());
+  Index nch = cols.spchans.size();
+  Index nsta = m_staged.size();
+  Index ich = 0;
+  Index ista = 0;
+  // Merge the existing and staged channels.
+  while ( ich < nch || ista < nsta ) {
+    bool useOld = ich < nch && (ista == nsta || cols.spchans[ich] <= m_staged[ista].chan);
+    bool useNew = ista < nsta && (ich == nch || m_staged[ista].chan <= cols.spchans[ich]);
+    Channel chan = useOld ? cols.spchans[ich] : m_staged[ista].chan;
+    chans.push_back(chan);
+    offsets.push_back(ticks.size());
+    Index ibin = useOld ? cols.offsets[ich] : 0;
+    Index ibinEnd = useOld ? cols.offsets[ich+1] : 0;
+    Index jsta = ista;
+    Index jstaEnd = ista;
+    if ( useNew ) {
+      while ( jstaEnd < nsta && m_staged[jstaEnd].chan == chan ) ++jstaEnd;
+    }
+    // Merge the existing and staged ticks for this channel.
+    while ( ibin < ibinEnd || jsta < jstaEnd ) {
+      if ( jsta == jstaEnd || (ibin < ibinEnd && cols.ticks[ibin] < m_staged[jsta].tick) ) {
+        ticks.push_back(cols.ticks[ibin]);
+        sigs.push_back(cols.sigs[ibin]);
+        ++ibin;
+        continue;
+      }
+      Tick tick = m_staged[jsta].tick;
+      Signal sig = 0.0;
+      if ( ibin < ibinEnd && cols.ticks[ibin] == tick ) {
+        sig = cols.sigs[ibin];
+        ++ibin;
+      } else {
+        sig = m_staged[jsta].sig;
+        ++jsta;
+      }
+      while ( jsta < jstaEnd && m_staged[jsta].tick == tick ) {
+        sig += m_staged[jsta].sig;
+        ++jsta;
+      }
+      ticks.push_back(tick);
+      sigs.push_back(sig);
+    }
+    if ( useOld ) ++ich;
+    if ( useNew ) ista = jstaEnd;
+  }
+  offsets.push_back(ticks.size());
+  cols.spchans.swap(chans);
+  cols.offsets.swap(offsets);
+  cols.ticks.swap(ticks);
+  cols.sigs.swap(sigs);
+  m_staged.clear();
+  buildChannelIndex();
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::
+appendChannels(const ChannelTickStore& rhs, Channel ch1, Channel ch2) {
+  consolidate();
+  rhs.consolidate();
+  detach();
+  Index nbin = appendColumns(*m_pcols, *rhs.m_pcols,
+                             std::max(ch1, rhs.m_ch1), std::min(ch2, rhs.m_ch2));
+  buildChannelIndex();
+  return nbin;
+}
+
+//**********************************************************************
+
+ChannelTickStore ChannelTickStore::slice(Channel ch1, Channel ch2) const {
+  consolidate();
+  ChannelTickStore sto;
+  sto.m_pcols = m_pcols;
+  sto.m_slice = true;
+  sto.m_ch1 = std::max(ch1, m_ch1);
+  sto.m_ch2 = std::max(sto.m_ch1, std::min(ch2, m_ch2));
+  sto.m_indexStale = true;
+  return sto;
+}
+
+//**********************************************************************
+
+bool ChannelTickStore::isSlice() const {
+  return m_slice;
+}
+
+//**********************************************************************
+
+double ChannelTickStore::occupancy(Channel ch1, Index nchan) const {
+  consolidate();
+  const Columns& cols = *m_pcols;
+  Index ich1 = 0;
+  Index ich2 = 0;
+  sparseRange(ch1, ch1 + nchan, ich1, ich2);
+  if ( ich2 <= ich1 ) return 0.0;
+  Tick tick1 = std::numeric_limits<Tick>::max();
+  Tick tick2 = std::numeric_limits<Tick>::min();
+  for ( Index ich=ich1; ich<ich2; ++ich ) {
+    tick1 = std::min(tick1, cols.ticks[cols.offsets[ich]]);
+    tick2 = std::max(tick2, cols.ticks[cols.offsets[ich+1] - 1]);
+  }
+  Index nbin = cols.offsets[ich2] - cols.offsets[ich1];
+  return double(nbin)/(double(nchan)*double(tick2 - tick1 + 1));
+}
+
+//**********************************************************************
+
+int ChannelTickStore::densify(Channel ch1, Index nchan) {
+  consolidate();
+  detach();
+  Columns& cols = *m_pcols;
+  Channel ch2 = ch1 + nchan;
+  for ( const Tile& tile : cols.tiles ) {
+    if ( tile.chan1 < ch2 && ch1 < tile.chan1 + tile.nchan ) return 2;
+  }
+  Index ich1 = std::lower_bound(cols.spchans.begin(), cols.spchans.end(), ch1) - cols.spchans.begin();
+  Index ich2 = std::lower_bound(cols.spchans.begin(), cols.spchans.end(), ch2) - cols.spchans.begin();
+  if ( ich2 <= ich1 ) return 1;
+  Tick tick1 = std::numeric_limits<Tick>::max();
+  Tick tick2 = std::numeric_limits<Tick>::min();
+  for ( Index ich=ich1; ich<ich2; ++ich ) {
+    tick1 = std::min(tick1, cols.ticks[cols.offsets[ich]]);
+    tick2 = std::max(tick2, cols.ticks[cols.offsets[ich+1] - 1]);
+  }
+  Tile tile;
+  tile.chan1 = ch1;
+  tile.nchan = nchan;
+  tile.tick1 = tick1;
+  tile.ntick = tick2 - tick1 + 1;
+  tile.sigs.assign(tile.nchan*tile.ntick, 0.0);
+  tile.fills.assign(tile.nchan*tile.ntick, 0);
+  tile.nfill.assign(tile.nchan, 0);
+  for ( Index ich=ich1; ich<ich2; ++ich ) {
+    Index irow = cols.spchans[ich] - ch1;
+    for ( Index ibin=cols.offsets[ich]; ibin<cols.offsets[ich+1]; ++ibin ) {
+      Index icel = irow*tile.ntick + Index(cols.ticks[ibin] - tick1);
+      tile.sigs[icel] = cols.sigs[ibin];
+      tile.fills[icel] = 1;
+    }
+    tile.nfill[irow] = cols.offsets[ich+1] - cols.offsets[ich];
+  }
+  // Remove the moved bins from the sparse columns.
+  Index ibin1 = cols.offsets[ich1];
+  Index ibin2 = cols.offsets[ich2];
+  Index nrem = ibin2 - ibin1;
+  cols.ticks.erase(cols.ticks.begin() + ibin1, cols.ticks.begin() + ibin2);
+  cols.sigs.erase(cols.sigs.begin() + ibin1, cols.sigs.begin() + ibin2);
+  cols.spchans.erase(cols.spchans.begin() + ich1, cols.spchans.begin() + ich2);
+  cols.offsets.erase(cols.offsets.begin() + ich1 + 1, cols.offsets.begin() + ich2 + 1);
+  for ( Index ich=ich1+1; ich<cols.offsets.size(); ++ich ) cols.offsets[ich] -= nrem;
+  // Insert the tile keeping the tiles sorted.
+  TileVector::iterator itil = cols.tiles.begin();
+  while ( itil != cols.tiles.end() && itil->chan1 < ch1 ) ++itil;
+  cols.tiles.insert(itil, std::move(tile));
+  buildChannelIndex();
+  return 0;
+}
+
+//**********************************************************************
+
+bool ChannelTickStore::isDense(Channel chan) const {
+  return findTile(chan) < m_pcols->tiles.size();
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::tileCount() const {
+  if ( ! m_slice ) return m_pcols->tiles.size();
+  // A slice holds the tiles with filled rows in its channel range.
+  Index ntil = 0;
+  for ( const Tile& tile : m_pcols->tiles ) {
+    Index irow1 = 0;
+    Index irow2 = 0;
+    if ( ! tileRows(tile, m_ch1, m_ch2, irow1, irow2) ) continue;
+    for ( Index irow=irow1; irow<irow2; ++irow ) {
+      if ( tile.nfill[irow] ) {
+        ++ntil;
+        break;
+      }
+    }
+  }
+  return ntil;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::clear() {
+  m_pcols.reset(new Columns);
+  m_slice = false;
+  m_ch1 = 0;
+  m_ch2 = std::numeric_limits<Channel>::max();
+  m_staged.clear();
+  m_chans.clear();
+  m_chanTile.clear();
+  m_chanSlot.clear();
+  m_indexStale = false;
+  m_bitWord0.clear();
+  m_bitOffsets.clear();
+  m_bits.clear();
+  m_chanSignal.clear();
+  m_totalChannelSignal = 0.0;
+  m_tickCentroid = 0.0;
+  m_summariesStale = true;
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::size() const {
+  consolidate();
+  return m_chans.size();
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::binCount() const {
+  return binCount(m_ch1, m_ch2);
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::binCount(Channel ch1, Channel ch2) const {
+  consolidate();
+  if ( ch2 <= ch1 ) return 0;
+  const Columns& cols = *m_pcols;
+  Index ich1 = 0;
+  Index ich2 = 0;
+  sparseRange(ch1, ch2, ich1, ich2);
+  Index nbin = cols.offsets[ich2] - cols.offsets[ich1];
+  for ( const Tile& tile : cols.tiles ) {
+    Index irow1 = 0;
+    Index irow2 = 0;
+    if ( ! tileRows(tile, ch1, ch2, irow1, irow2) ) continue;
+    for ( Index irow=irow1; irow<irow2; ++irow ) nbin += tile.nfill[irow];
+  }
+  return nbin;
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::findChannel(Channel chan) const {
+  Index ich = lowerChannel(chan);
+  if ( ich < m_chans.size() && m_chans[ich] == chan ) return ich;
+  return m_chans.size();
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::lowerChannel(Channel chan) const {
+  consolidate();
+  return std::lower_bound(m_chans.begin(), m_chans.end(), chan) - m_chans.begin();
+}
+
+//**********************************************************************
+
+Channel ChannelTickStore::channel(Index ich) const {
+  consolidate();
+  return m_chans[ich];
+}
+
+//**********************************************************************
+
+ChannelBins ChannelTickStore::channelBins(Index ich) const {
+  consolidate();
+  const Columns& cols = *m_pcols;
+  Index itil = m_chanTile[ich];
+  Index islot = m_chanSlot[ich];
+  if ( itil == tpc::badIndex() ) {
+    Index ibin = cols.offsets[islot];
+    return ChannelBins(m_chans[ich], &cols.ticks[ibin], &cols.sigs[ibin], cols.offsets[islot+1] - ibin);
+  }
+  const Tile& tile = cols.tiles[itil];
+  Index icel = islot*tile.ntick;
+  return ChannelBins(m_chans[ich], tile.tick1, &tile.sigs[icel], &tile.fills[icel], tile.ntick, tile.nfill[islot]);
+}
+
+//**********************************************************************
+
+ChannelBits ChannelTickStore::channelBits(Index ich) const {
+  buildSummaries();
+  Index iwrd = m_bitOffsets[ich];
+  return ChannelBits(m_bitWord0[ich], &m_bits[iwrd], m_bitOffsets[ich+1] - iwrd);
+}
+
+//**********************************************************************
+
+Signal ChannelTickStore::channelSignal(Index ich) const {
+  buildSummaries();
+  return m_chanSignal[ich];
+}
+
+//**********************************************************************
+
+Signal ChannelTickStore::totalChannelSignal() const {
+  buildSummaries();
+  return m_totalChannelSignal;
+}
+
+//**********************************************************************
+
+double ChannelTickStore::tickCentroid() const {
+  buildSummaries();
+  return m_tickCentroid;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::buildSummaries() const {
+  consolidate();
+  if ( ! m_summariesStale ) return;
+  Index nch = m_chans.size();
+  m_bitWord0.resize(nch);
+  m_bitOffsets.resize(nch + 1);
+  m_chanSignal.assign(nch, 0.0);
+  // Find the word range for each channel.
+  Index nwrd = 0;
+  for ( Index ich=0; ich<nch; ++ich ) {
+    ChannelBins bins = channelBins(ich);
+    Index ibin1 = 0;
+    Index ibin2 = bins.size();
+    while ( ibin1 < ibin2 && ! bins.filled(ibin1) ) ++ibin1;
+    while ( ibin2 > ibin1 && ! bins.filled(ibin2-1) ) --ibin2;
+    m_bitOffsets[ich] = nwrd;
+    if ( ibin2 == ibin1 ) {
+      m_bitWord0[ich] = 0;
+      continue;
+    }
+    Tick iwrd1 = bitWord(bins.tick(ibin1));
+    Tick iwrd2 = bitWord(bins.tick(ibin2-1)) + 1;
+    m_bitWord0[ich] = iwrd1;
+    nwrd += iwrd2 - iwrd1;
+  }
+  m_bitOffsets[nch] = nwrd;
+  m_bits.assign(nwrd, 0);
+  // Set the bits and sum the signals.
+  double sigsum = 0.0;
+  double ticksum = 0.0;
+  for ( Index ich=0; ich<nch; ++ich ) {
+    ChannelBins bins = channelBins(ich);
+    Word* pwords = &m_bits[m_bitOffsets[ich]];
+    Tick tick0 = wordBits*m_bitWord0[ich];
+    Signal chansig = 0.0;
+    for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+      if ( ! bins.filled(ibin) ) continue;
+      Tick tick = bins.tick(ibin);
+      Signal sig = bins.signal(ibin);
+      Index ibit = tick - tick0;
+      pwords[ibit/wordBits] |= Word(1) << (ibit%wordBits);
+      chansig += sig;
+      ticksum += sig*tick;
+    }
+    m_chanSignal[ich] = chansig;
+    sigsum += chansig;
+  }
+  m_totalChannelSignal = sigsum;
+  m_tickCentroid = sigsum == 0.0 ? 0.0 : ticksum/sigsum;
+  m_summariesStale = false;
+}
+
+//**********************************************************************
+
+ChannelTickStore::Iter ChannelTickStore::begin() const {
+  consolidate();
+  return Iter(this, 0);
+}
+
+//**********************************************************************
+
+ChannelTickStore::Iter ChannelTickStore::end() const {
+  consolidate();
+  return Iter(this, m_chans.size());
+}
+
+//**********************************************************************
+
+Signal ChannelTickStore::signalSum() const {
+  consolidate();
+  const Columns& cols = *m_pcols;
+  Index ich1 = 0;
+  Index ich2 = 0;
+  sparseRange(m_ch1, m_ch2, ich1, ich2);
+  Signal sum = 0.0;
+  for ( Index ibin=cols.offsets[ich1]; ibin<cols.offsets[ich2]; ++ibin ) sum += cols.sigs[ibin];
+  for ( const Tile& tile : cols.tiles ) {
+    Index irow1 = 0;
+    Index irow2 = 0;
+    if ( ! tileRows(tile, m_ch1, m_ch2, irow1, irow2) ) continue;
+    for ( Index icel=irow1*tile.ntick; icel<irow2*tile.ntick; ++icel ) sum += tile.sigs[icel];
+  }
+  return sum;
+}
+
+//**********************************************************************
+
+ChannelRange ChannelTickStore::channelRange() const {
+  consolidate();
+  if ( m_chans.size() == 0 ) {
+    return ChannelRange(std::numeric_limits<Channel>::max(), std::numeric_limits<Channel>::min());
+  }
+  return ChannelRange(m_chans.front(), m_chans.back());
+}
+
+//**********************************************************************
+
+TickRange ChannelTickStore::tickRange() const {
+  consolidate();
+  const Columns& cols = *m_pcols;
+  TickRange range(std::numeric_limits<Tick>::max(), std::numeric_limits<Tick>::min());
+  Index ich1 = 0;
+  Index ich2 = 0;
+  sparseRange(m_ch1, m_ch2, ich1, ich2);
+  for ( Index ich=ich1; ich<ich2; ++ich ) {
+    Tick tick1 = cols.ticks[cols.offsets[ich]];
+    Tick tick2 = cols.ticks[cols.offsets[ich+1] - 1];
+    if ( tick1 < range.first() ) range.first() = tick1;
+    if ( tick2 > range.last() ) range.last() = tick2;
+  }
+  for ( const Tile& tile : cols.tiles ) {
+    Index irow1 = 0;
+    Index irow2 = 0;
+    if ( ! tileRows(tile, m_ch1, m_ch2, irow1, irow2) ) continue;
+    for ( Index irow=irow1; irow<irow2; ++irow ) {
+      if ( tile.nfill[irow] == 0 ) continue;
+      const char* prow = &tile.fills[irow*tile.ntick];
+      Index itick1 = 0;
+      while ( ! prow[itick1] ) ++itick1;
+      Index itick2 = tile.ntick - 1;
+      while ( ! prow[itick2] ) --itick2;
+      Tick tick1 = tile.tick1 + Tick(itick1);
+      Tick tick2 = tile.tick1 + Tick(itick2);
+      if ( tick1 < range.first() ) range.first() = tick1;
+      if ( tick2 > range.last() ) range.last() = tick2;
+    }
+  }
+  return range;
+}
+
+//**********************************************************************
+
+const ChannelVector& ChannelTickStore::channels() const {
+  consolidate();
+  return m_chans;
+}
+
+//**********************************************************************
+
+const ChannelVector& ChannelTickStore::sparseChannels() const {
+  return ownColumns().spchans;
+}
+
+//**********************************************************************
+
+const IndexVector& ChannelTickStore::offsets() const {
+  return ownColumns().offsets;
+}
+
+//**********************************************************************
+
+const TickVector& ChannelTickStore::ticks() const {
+  return ownColumns().ticks;
+}
+
+//**********************************************************************
+
+const SignalVector& ChannelTickStore::signals() const {
+  return ownColumns().sigs;
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::
+appendColumns(Columns& dst, const Columns& src, Channel ch1, Channel ch2) {
+  if ( ch2 <= ch1 ) return 0;
+  Index nbin = 0;
+  // Copy the sparse channels.
+  const ChannelVector& rchans = src.spchans;
+  Index ich1 = std::lower_bound(rchans.begin(), rchans.end(), ch1) - rchans.begin();
+  Index ich2 = std::lower_bound(rchans.begin(), rchans.end(), ch2) - rchans.begin();
+  if ( ich2 > ich1 ) {
+    Index ibin1 = src.offsets[ich1];
+    Index ibin2 = src.offsets[ich2];
+    Index nbinOld = dst.ticks.size();
+    dst.spchans.insert(dst.spchans.end(), rchans.begin() + ich1, rchans.begin() + ich2);
+    dst.offsets.pop_back();
+    for ( Index ich=ich1; ich<ich2; ++ich ) {
+      dst.offsets.push_back(nbinOld + src.offsets[ich] - ibin1);
+    }
+    dst.ticks.insert(dst.ticks.end(), src.ticks.begin() + ibin1, src.ticks.begin() + ibin2);
+    dst.sigs.insert(dst.sigs.end(), src.sigs.begin() + ibin1, src.sigs.begin() + ibin2);
+    dst.offsets.push_back(dst.ticks.size());
+    nbin += ibin2 - ibin1;
+  }
+  // Copy the rows of each tile in the range.
+  for ( const Tile& rtile : src.tiles ) {
+    Channel tch1 = std::max(ch1, rtile.chan1);
+    Channel tch2 = std::min(ch2, rtile.chan1 + rtile.nchan);
+    if ( tch2 <= tch1 ) continue;
+    Index irow1 = tch1 - rtile.chan1;
+    Index irow2 = tch2 - rtile.chan1;
+    Index nfill = 0;
+    for ( Index irow=irow1; irow<irow2; ++irow ) nfill += rtile.nfill[irow];
+    if ( nfill == 0 ) continue;
+    dst.tiles.push_back(Tile());
+    Tile& tile = dst.tiles.back();
+    tile.chan1 = tch1;
+    tile.nchan = tch2 - tch1;
+    tile.tick1 = rtile.tick1;
+    tile.ntick = rtile.ntick;
+    tile.sigs.assign(rtile.sigs.begin() + irow1*rtile.ntick, rtile.sigs.begin() + irow2*rtile.ntick);
+    tile.fills.assign(rtile.fills.begin() + irow1*rtile.ntick, rtile.fills.begin() + irow2*rtile.ntick);
+    tile.nfill.assign(rtile.nfill.begin() + irow1, rtile.nfill.begin() + irow2);
+    nbin += nfill;
+  }
+  return nbin;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::detach() const {
+  if ( m_slice ) {
+    ColumnsPtr pcols(new Columns);
+    appendColumns(*pcols, *m_pcols, m_ch1, m_ch2);
+    m_pcols = pcols;
+    m_slice = false;
+    m_ch1 = 0;
+    m_ch2 = std::numeric_limits<Channel>::max();
+    // The tile and sparse channel indices have changed.
+    m_indexStale = true;
+  } else if ( m_pcols.use_count() > 1 ) {
+    m_pcols.reset(new Columns(*m_pcols));
+  }
+}
+
+//**********************************************************************
+
+const ChannelTickStore::Columns& ChannelTickStore::ownColumns() const {
+  consolidate();
+  if ( m_slice ) {
+    detach();
+    consolidate();
+  }
+  return *m_pcols;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::
+sparseRange(Channel ch1, Channel ch2, Index& isp1, Index& isp2) const {
+  const ChannelVector& chans = m_pcols->spchans;
+  Channel wch1 = std::max(ch1, m_ch1);
+  Channel wch2 = std::min(ch2, m_ch2);
+  if ( wch2 <= wch1 ) {
+    isp1 = 0;
+    isp2 = 0;
+    return;
+  }
+  isp1 = std::lower_bound(chans.begin(), chans.end(), wch1) - chans.begin();
+  isp2 = std::lower_bound(chans.begin() + isp1, chans.end(), wch2) - chans.begin();
+}
+
+//**********************************************************************
+
+bool ChannelTickStore::
+tileRows(const Tile& tile, Channel ch1, Channel ch2, Index& irow1, Index& irow2) const {
+  Channel tch1 = std::max(std::max(ch1, m_ch1), tile.chan1);
+  Channel tch2 = std::min(std::min(ch2, m_ch2), tile.chan1 + tile.nchan);
+  if ( tch2 <= tch1 ) return false;
+  irow1 = tch1 - tile.chan1;
+  irow2 = tch2 - tile.chan1;
+  return true;
+}
+
+//**********************************************************************
+
+Index ChannelTickStore::findTile(Channel chan) const {
+  const TileVector& tiles = m_pcols->tiles;
+  if ( chan < m_ch1 || chan >= m_ch2 ) return tiles.size();
+  // Find the last tile starting at or below the channel.
+  TileVector::const_iterator itilNext =
+    std::upper_bound(tiles.begin(), tiles.end(), chan,
+                     [](Channel ch, const Tile& tile) { return ch < tile.chan1; });
+  if ( itilNext == tiles.begin() ) return tiles.size();
+  Index itil = itilNext - tiles.begin() - 1;
+  if ( chan - tiles[itil].chan1 >= tiles[itil].nchan ) return tiles.size();
+  // A slice holds only the tiles with filled rows in its channel range.
+  if ( m_slice ) {
+    const Tile& tile = tiles[itil];
+    Index irow1 = 0;
+    Index irow2 = 0;
+    tileRows(tile, m_ch1, m_ch2, irow1, irow2);
+    Index nfill = 0;
+    for ( Index irow=irow1; irow<irow2; ++irow ) nfill += tile.nfill[irow];
+    if ( nfill == 0 ) return tiles.size();
+  }
+  return itil;
+}
+
+//**********************************************************************
+
+bool ChannelTickStore::addDense(Tile& tile, Channel chan, Tick tick, Signal sig) {
+  // Extend the tick window if needed.
+  Tick tickEnd = tile.tick1 + Tick(tile.ntick);
+  if ( tick < tile.tick1 || tick >= tickEnd ) {
+    Index nneed = std::max(tick + 1, tickEnd) - std::min(tick, tile.tick1);
+    // Windows narrower than this may grow to maxTileGrowth() times this size.
+    const Index nwinMin = 64;
+    if ( nneed > maxTileGrowth()*std::max(tile.ntick, nwinMin) ) return false;
+    // Grow the window by at least a quarter of its current size on the side of the
+    // new tick so the cost of the copy is amortized over the ticks that fill it.
+    // A larger factor would leave more unfilled cells.
+    Index ngrow = std::max(nneed, tile.ntick + tile.ntick/4 + 1) - tile.ntick;
+    Tick tick1 = tick < tile.tick1 ? tile.tick1 - Tick(ngrow) : tile.tick1;
+    Index ntick = tile.ntick + ngrow;
+    Index ioff = tile.tick1 - tick1;
+    SignalVector sigs(tile.nchan*ntick, 0.0);
+    std::vector<char> fills(tile.nchan*ntick, 0);
+    for ( Index irow=0; irow<tile.nchan; ++irow ) {
+      Index iold = irow*tile.ntick;
+      Index inew = irow*ntick + ioff;
+      std::copy(tile.sigs.begin() + iold, tile.sigs.begin() + iold + tile.ntick, sigs.begin() + inew);
+      std::copy(tile.fills.begin() + iold, tile.fills.begin() + iold + tile.ntick, fills.begin() + inew);
+    }
+    tile.sigs.swap(sigs);
+    tile.fills.swap(fills);
+    tile.tick1 = tick1;
+    tile.ntick = ntick;
+  }
+  Index irow = chan - tile.chan1;
+  Index icel = irow*tile.ntick + Index(tick - tile.tick1);
+  m_summariesStale = true;
+  tile.sigs[icel] += sig;
+  if ( ! tile.fills[icel] ) {
+    tile.fills[icel] = 1;
+    // A channel with a first filled bin must be added to the channel list.
+    if ( tile.nfill[irow]++ == 0 ) m_indexStale = true;
+  }
+  return true;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::sparsify(Index itil) {
+  TileVector& tiles = m_pcols->tiles;
+  const Tile& tile = tiles[itil];
+  // Tile channels have no sparse bins so each staged bin keeps its signal.
+  for ( Index irow=0; irow<tile.nchan; ++irow ) {
+    if ( tile.nfill[irow] == 0 ) continue;
+    Index icel0 = irow*tile.ntick;
+    for ( Index itick=0; itick<tile.ntick; ++itick ) {
+      if ( ! tile.fills[icel0 + itick] ) continue;
+      m_staged.push_back({tile.chan1 + Channel(irow), tile.tick1 + Tick(itick), tile.sigs[icel0 + itick]});
+    }
+  }
+  tiles.erase(tiles.begin() + itil);
+  m_indexStale = true;
+  m_summariesStale = true;
+}
+
+//**********************************************************************
+
+void ChannelTickStore::buildChannelIndex() const {
+  const Columns& cols = *m_pcols;
+  m_chans.clear();
+  m_chanTile.clear();
+  m_chanSlot.clear();
+  // Tile channels are never sparse so the two lists are merged by walking them in step.
+  Index isp = 0;
+  Index nsp = 0;
+  sparseRange(m_ch1, m_ch2, isp, nsp);
+  for ( Index itil=0; itil<cols.tiles.size(); ++itil ) {
+    const Tile& tile = cols.tiles[itil];
+    Index irow1 = 0;
+    Index irow2 = 0;
+    if ( ! tileRows(tile, m_ch1, m_ch2, irow1, irow2) ) continue;
+    for ( ; isp<nsp && cols.spchans[isp]<tile.chan1; ++isp ) {
+      m_chans.push_back(cols.spchans[isp]);
+      m_chanTile.push_back(tpc::badIndex());
+      m_chanSlot.push_back(isp);
+    }
+    for ( Index irow=irow1; irow<irow2; ++irow ) {
+      if ( tile.nfill[irow] == 0 ) continue;
+      m_chans.push_back(tile.chan1 + irow);
+      m_chanTile.push_back(itil);
+      m_chanSlot.push_back(irow);
+    }
+  }
+  for ( ; isp<nsp; ++isp ) {
+    m_chans.push_back(cols.spchans[isp]);
+    m_chanTile.push_back(tpc::badIndex());
+    m_chanSlot.push_back(isp);
+  }
+  m_indexStale = false;
+  m_summariesStale = true;
+}
+
+//**********************************************************************
@@ -0,0 +1,325 @@
+// ChannelTickStore.h
+
+#ifndef ChannelTickStore_H
+#define ChannelTickStore_H
+
+// David Adams
+// October 2026
+//
+// Flat storage for signals indexed by channel and tick.
+//
+// The bins are held in two columns (tick and signal) sorted by channel and
+// then by tick. A CSR-style index gives the first bin for each channel so the
+// bins for any channel or channel range are contiguous.
+//
+// Signals added with add(...) are staged and merged into the sorted columns
+// when the store is next read or when consolidate() is called. Reads of a store
+// with staged signals are not thread safe: call consolidate() before sharing
+// a store between threads.
+//
+// A block of channels with high occupancy may be moved to a dense tile with
+// densify(...). A tile holds a signal and a fill flag for every (channel, tick)
+// in its channel block and tick window and signals for its channels are added
+// directly to the tile. As for sparse channels, a bin is filled once a signal
+// is added to it, even if the signal sum is zero. The tick window grows
+// geometrically (by a quarter) to hold new ticks. A signal far outside the
+// window moves the tile back to sparse storage instead.
+// A tile cell takes less memory than a sparse bin, so a tile is smaller than the
+// sparse bins it replaces only if the occupancy is above breakEvenOccupancy().
+//
+// Summaries of the bins are also kept for use in comparisons of stores: the tick
+// occupancy of each channel as a bitset, so that the number of bins shared by two
+// channels is a popcount of ANDed words, the summed signal for each channel and
+// the signal-weighted mean tick. The summaries are built when first requested
+// after the store changes. Like the staged signals, this is not thread safe:
+// call buildSummaries() before sharing a store between threads.
+//
+// The sorted columns and tiles are shared between copies of a store and with
+// slices made with slice(...). A slice is a view of a channel range of another
+// store: no bins are copied when it is made. Either store makes a private copy
+// of the shared bins (for a slice, only those in its channel range) before its
+// first change.
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "DXUtil/TpcTypes.h"
+
+class ChannelTickStore {
+
+public:
+
+  typedef tpc::Index Index;
+  typedef tpc::Channel Channel;
+  typedef tpc::ChannelRange ChannelRange;
+  typedef tpc::Tick Tick;
+  typedef tpc::TickRange TickRange;
+  typedef double Signal;
+  typedef std::vector<Index> IndexVector;
+  typedef std::vector<Channel> ChannelVector;
+  typedef std::vector<Tick> TickVector;
+  typedef std::vector<Signal> SignalVector;
+
+  // The bins for one channel.
+  // For a sparse channel, each bin is filled.
+  // For a channel in a dense tile, there is a bin for each tick in the tile
+  // window and a flag for each that records if it is filled. Unfilled bins
+  // have zero signal.
+  class ChannelBins {
+  public:
+    ChannelBins(Channel chan, const Tick* pticks, const Signal* psigs, Index nbin)
+    : m_chan(chan), m_pticks(pticks), m_psigs(psigs), m_tick1(0), m_pfills(nullptr),
+      m_nbin(nbin), m_nfill(nbin) { }
+    ChannelBins(Channel chan, Tick tick1, const Signal* psigs, const char* pfills, Index nbin, Index nfill)
+    : m_chan(chan), m_pticks(nullptr), m_psigs(psigs), m_tick1(tick1), m_pfills(pfills),
+      m_nbin(nbin), m_nfill(nfill) { }
+    Channel channel() const { return m_chan; }
+    bool dense() const { return m_pfills != nullptr; }
+    Index size() const { return m_nbin; }
+    Index binCount() const { return m_nfill; }
+    Tick tick(Index ibin) const { return m_pfills == nullptr ? m_pticks[ibin] : m_tick1 + Tick(ibin); }
+    Signal signal(Index ibin) const { return m_psigs[ibin]; }
+    bool filled(Index ibin) const { return m_pfills == nullptr || m_pfills[ibin]; }
+    // Return the index of the filled bin for a tick or size() if there is no such bin.
+    Index find(Tick tick) const;
+    // Return the signal summed over ticks.
+    Signal signalSum() const;
+  private:
+    Channel m_chan;
+    const Tick* m_pticks;
+    const Signal* m_psigs;
+    Tick m_tick1;
+    const char* m_pfills;
+    Index m_nbin;
+    Index m_nfill;
+  };
+
+  // Tick occupancy bits for one channel.
+  // Word iwrd holds ticks starting at 64*(word0 + iwrd) and bit ibit is set if the
+  // bin for tick 64*(word0 + iwrd) + ibit is filled.
+  typedef uint64_t Word;
+  class ChannelBits {
+  public:
+    ChannelBits(Tick word0, const Word* pwords, Index nword)
+    : m_word0(word0), m_pwords(pwords), m_nword(nword) { }
+    Tick firstWord() const { return m_word0; }
+    Index size() const { return m_nword; }
+    Word word(Index iwrd) const { return m_pwords[iwrd]; }
+    // Return if the bin for a tick is filled.
+    bool filled(Tick tick) const;
+    // Return the number of ticks filled in both this and rhs.
+    Index overlapCount(const ChannelBits& rhs) const;
+  private:
+    Tick m_word0;
+    const Word* m_pwords;
+    Index m_nword;
+  };
+
+  // Iterator over channels.
+  class Iter {
+  public:
+    Iter(const ChannelTickStore* pstore, Index ich) : m_pstore(pstore), m_ich(ich) { }
+    ChannelBins operator*() const { return m_pstore->channelBins(m_ich); }
+    Iter& operator++() { ++m_ich; return *this; }
+    bool operator!=(const Iter& rhs) const { return m_ich != rhs.m_ich; }
+  private:
+    const ChannelTickStore* m_pstore;
+    Index m_ich;
+  };
+
+  // Ctor for an empty store.
+  ChannelTickStore();
+
+  // Add a signal. The bin is created if it does not already exist.
+  // Signals for a channel in a dense tile are added directly to the tile
+  // and the tile tick window is extended if needed. If the extended window
+  // would be more than maxTileGrowth() times the current window, the tile is
+  // moved back to sparse storage and the signal is staged.
+  void add(Channel chan, Tick tick, Signal sig);
+
+  // Merge the staged signals into the sorted columns.
+  void consolidate() const;
+
+  // Append the bins for channels in the range [ch1, ch2) from another store.
+  // All the copied channels must be larger than those already in this store.
+  // Dense tiles are copied as dense tiles.
+  // Returns the number of copied (filled) bins.
+  Index appendChannels(const ChannelTickStore& rhs, Channel ch1, Channel ch2);
+
+  // Return a store holding the bins for channels in the range [ch1, ch2).
+  // The bins are shared with this store and are not copied.
+  ChannelTickStore slice(Channel ch1, Channel ch2) const;
+
+  // Return if this store is a slice of another.
+  bool isSlice() const;
+
+  // Return the fraction of bins filled for the sparse channels in the range
+  // [ch1, ch1+nchan) and the tick window spanned by those bins.
+  double occupancy(Channel ch1, Index nchan) const;
+
+  // Move the channels in the range [ch1, ch1+nchan) to a dense tile.
+  // The tile tick window is that spanned by the existing bins.
+  // Returns 0 for success, 1 if there are no bins in the range and 2 if the
+  // range overlaps an existing tile.
+  int densify(Channel ch1, Index nchan);
+
+  // Return if a channel is in a dense tile.
+  bool isDense(Channel chan) const;
+
+  // Return the number of dense tiles.
+  Index tileCount() const;
+
+  // Largest factor by which a signal may extend a tile tick window.
+  static Index maxTileGrowth() { return 4; }
+
+  // Occupancy above which a dense tile takes less memory than the sparse bins
+  // it replaces: the size of a tile cell (signal and fill flag) over that of a
+  // sparse bin (tick and signal).
+  static double breakEvenOccupancy() {
+    return double(sizeof(Signal) + sizeof(char))/double(sizeof(Tick) + sizeof(Signal));
+  }
+
+  // Remove all bins.
+  void clear();
+
+  // Number of channels with bins.
+  Index size() const;
+
+  // Total number of filled bins.
+  Index binCount() const;
+
+  // Number of filled bins in the channel range [ch1, ch2).
+  Index binCount(Channel ch1, Channel ch2) const;
+
+  // Return the index of a channel or size() if the channel has no bins.
+  Index findChannel(Channel chan) const;
+
+  // Return the index of the first channel not less than chan.
+  Index lowerChannel(Channel chan) const;
+
+  // Return the channel for a channel index.
+  Channel channel(Index ich) const;
+
+  // Return the bins for a channel index.
+  ChannelBins channelBins(Index ich) const;
+
+  // Return the occupancy bits for a channel index.
+  ChannelBits channelBits(Index ich) const;
+
+  // Return the signal summed over ticks for a channel index.
+  Signal channelSignal(Index ich) const;
+
+  // Return the sum of the channel signals.
+  Signal totalChannelSignal() const;
+
+  // Return the signal-weighted mean tick.
+  // Returns zero if the summed signal is zero.
+  double tickCentroid() const;
+
+  // Build the occupancy bits and signal summaries if they are out of date.
+  void buildSummaries() const;
+
+  // Iterate over channels.
+  Iter begin() const;
+  Iter end() const;
+
+  // Return the signal summed over all bins.
+  Signal signalSum() const;
+
+  // Return the channel and tick ranges covered by the bins.
+  ChannelRange channelRange() const;
+  TickRange tickRange() const;
+
+  // Sorted list of all channels with filled bins.
+  const ChannelVector& channels() const;
+
+  // Direct access to the columns for the sparse channels.
+  // A slice first makes a private copy of its bins.
+  const ChannelVector& sparseChannels() const;
+  const IndexVector& offsets() const;
+  const TickVector& ticks() const;
+  const SignalVector& signals() const;
+
+private:
+
+  struct StagedSignal {
+    Channel chan;
+    Tick tick;
+    Signal sig;
+  };
+
+  // Dense block of channels.
+  struct Tile {
+    Channel chan1;                // First channel.
+    Index nchan;                  // Number of channels.
+    Tick tick1;                   // First tick in the window.
+    Index ntick;                  // Number of ticks in the window.
+    SignalVector sigs;            // sigs[ichan*ntick + itick] is the signal for (chan1+ichan, tick1+itick)
+    std::vector<char> fills;      // fills[ichan*ntick + itick] is nonzero if that bin is filled
+    IndexVector nfill;            // nfill[ichan] is the number of filled bins for channel chan1+ichan
+  };
+  typedef std::vector<Tile> TileVector;
+
+  // Sorted columns and tiles. These may be shared between stores.
+  struct Columns {
+    ChannelVector spchans;        // Sorted sparse channels with bins.
+    IndexVector offsets;          // offsets[ich] is the first bin for channel spchans[ich]
+    TickVector ticks;             // Tick for each bin.
+    SignalVector sigs;            // Signal for each bin.
+    TileVector tiles;             // Dense tiles sorted by channel.
+    Columns() : offsets(1, 0) { }
+  };
+  typedef std::shared_ptr<Columns> ColumnsPtr;
+
+  // Append the bins for channels in the range [ch1, ch2) from src to dst.
+  // Returns the number of copied (filled) bins.
+  static Index appendColumns(Columns& dst, const Columns& src, Channel ch1, Channel ch2);
+
+  // Make a private copy of the columns if they are shared or this is a slice.
+  void detach() const;
+
+  // Make a private copy of the columns if this is a slice and return them.
+  const Columns& ownColumns() const;
+
+  // Find the range [isp1, isp2) of sparse channel indices for channels in
+  // the range [ch1, ch2) and the channel range of this store.
+  void sparseRange(Channel ch1, Channel ch2, Index& isp1, Index& isp2) const;
+
+  // Find the range [irow1, irow2) of tile rows for channels in the range
+  // [ch1, ch2) and the channel range of this store.
+  // Returns false if the range is empty.
+  bool tileRows(const Tile& tile, Channel ch1, Channel ch2, Index& irow1, Index& irow2) const;
+
+  // Return the index of the tile holding a channel or m_pcols->tiles.size() if there is none.
+  Index findTile(Channel chan) const;
+
+  // Add a signal to a tile.
+  // Returns false if the tick is too far outside the tile window.
+  bool addDense(Tile& tile, Channel chan, Tick tick, Signal sig);
+
+  // Move the bins in a tile to the staged signals and remove the tile.
+  void sparsify(Index itil);
+
+  // Rebuild the list of all channels from the sparse channels and the tiles.
+  void buildChannelIndex() const;
+
+  mutable ColumnsPtr m_pcols;                   // Sorted columns and tiles.
+  mutable bool m_slice = false;                 // Is this a slice of the columns?
+  mutable Channel m_ch1;                        // First channel in the slice.
+  mutable Channel m_ch2;                        // Channel after the last in the slice.
+  mutable std::vector<StagedSignal> m_staged;   // Signals not yet merged.
+  mutable ChannelVector m_chans;                // Sorted list of all channels with bins.
+  mutable IndexVector m_chanTile;               // Tile for each channel in m_chans (badIndex for sparse).
+  mutable IndexVector m_chanSlot;               // Sparse channel index or tile row for each channel in m_chans.
+  mutable bool m_indexStale = false;            // Does the channel list need to be rebuilt?
+  mutable std::vector<Tick> m_bitWord0;         // First bit word for each channel in m_chans.
+  mutable IndexVector m_bitOffsets;             // m_bitOffsets[ich] is the first word for channel m_chans[ich]
+  mutable std::vector<Word> m_bits;             // Occupancy bits.
+  mutable SignalVector m_chanSignal;            // Summed signal for each channel in m_chans.
+  mutable Signal m_totalChannelSignal = 0.0;    // Sum of m_chanSignal.
+  mutable double m_tickCentroid = 0.0;          // Signal-weighted mean tick.
+  mutable bool m_summariesStale = true;         // Do the summaries need to be rebuilt?
+
+};
+
+#endif
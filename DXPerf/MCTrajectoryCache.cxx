@@ -0,0 +1,105 @@
+// MCTrajectoryCache.cxx
+
+#include "MCTrajectoryCache.h"
+#include <iostream>
+#include "art/Framework/Principal/Event.h"
+#include "nusimdata/SimulationBase/MCParticle.h"
+#include "DXGeometry/GeoHelper.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using simb::MCParticle;
+using tpc::badIndex;
+
+typedef MCTrajectoryCache::Trajectory Trajectory;
+
+//**********************************************************************
+
+MCTrajectoryCache::MCTrajectoryCache(const GeoHelper* pgh)
+: m_pgh(pgh), m_run(-1), m_subrun(-1), m_event(-1), m_ppars(nullptr),
+  m_ntpceval(0), m_nppeval(0) { }
+
+//**********************************************************************
+
+int MCTrajectoryCache::beginEvent(const art::Event& event, const MCParticleVector& pars) {
+  const string myname = "MCTrajectoryCache::beginEvent: ";
+  if ( m_pgh == nullptr ) {
+    cout << myname << "ERROR: Geometry helper is absent." << endl;
+    return 1;
+  }
+  int run = event.run();
+  int subrun = event.subRun();
+  int evt = event.id().event();
+  if ( run == m_run && subrun == m_subrun && evt == m_event && &pars == m_ppars ) return 0;
+  clear();
+  m_run = run;
+  m_subrun = subrun;
+  m_event = evt;
+  m_ppars = &pars;
+  for ( const MCParticle& par : pars ) trajectory(par, false);
+  return 0;
+}
+
+//**********************************************************************
+
+const Trajectory& MCTrajectoryCache::trajectory(const MCParticle& par, bool usePlanePositions) {
+  Trajectory& traj = m_trajs[&par];
+  Index npt = par.NumberTrajectoryPoints();
+  if ( traj.tpcids.size() != npt ) {
+    traj.tpcids.resize(npt);
+    traj.crys.resize(npt);
+    traj.ndet = 0;
+    for ( Index ipt=0; ipt<npt; ++ipt ) {
+      const auto& pos = par.Position(ipt);
+      double xyz[3] = {pos.X(), pos.Y(), pos.Z()};
+      geo::TPCID tpcid = m_pgh->findTpc(xyz);
+      traj.tpcids[ipt] = tpcid;
+      if ( tpcid.isValid ) {
+        traj.crys[ipt] = tpcid.Cryostat;
+        ++traj.ndet;
+      } else {
+        traj.crys[ipt] = m_pgh->findCryostat(xyz);
+      }
+    }
+    m_ntpceval += npt;
+  }
+  if ( usePlanePositions && ! traj.havePlanePositions ) {
+    traj.ppoffs.clear();
+    traj.pps.clear();
+    traj.ppoffs.reserve(npt + 1);
+    PlanePositionVector pps;
+    for ( Index ipt=0; ipt<npt; ++ipt ) {
+      traj.ppoffs.push_back(traj.pps.size());
+      if ( ! traj.tpcids[ipt].isValid ) continue;
+      const auto& pos = par.Position(ipt);
+      double xyzt[4] = {pos.X(), pos.Y(), pos.Z(), pos.T()};
+      m_pgh->planePositions(xyzt, pps);
+      traj.pps.insert(traj.pps.end(), pps.begin(), pps.end());
+    }
+    traj.ppoffs.push_back(traj.pps.size());
+    traj.havePlanePositions = true;
+    m_nppeval += npt;
+  }
+  return traj;
+}
+
+//**********************************************************************
+
+const Trajectory* MCTrajectoryCache::find(const MCParticle& par) const {
+  auto itraj = m_trajs.find(&par);
+  if ( itraj == m_trajs.end() ) return nullptr;
+  return &itraj->second;
+}
+
+//**********************************************************************
+
+void MCTrajectoryCache::clear() {
+  m_trajs.clear();
+  m_run = -1;
+  m_subrun = -1;
+  m_event = -1;
+  m_ppars = nullptr;
+}
+
+//**********************************************************************
@@ -0,0 +1,96 @@
+// MCTrajectoryCache.h
+
+#ifndef MCTrajectoryCache_H
+#define MCTrajectoryCache_H
+
+// David Adams
+// October 2026
+//
+// Per-event cache of the geometry information for the points on MCParticle trajectories.
+//
+// The TPC and cryostat for each point are evaluated when an event is started and
+// the plane positions when they are first requested. The cache may be shared by
+// MCTrajectoryFollower objects so that the geometry for each point is evaluated
+// once per event.
+//
+// Trajectories are indexed by the address of the MCParticle so the particles must
+// not be moved or copied during the event.
+
+#include <vector>
+#include <map>
+#include <memory>
+#include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
+#include "DXGeometry/PlanePosition.h"
+#include "DXUtil/TpcTypes.h"
+
+namespace art {
+class Event;
+}
+namespace simb {
+class MCParticle;
+}
+class GeoHelper;
+
+class MCTrajectoryCache {
+
+public:
+
+  typedef tpc::Index Index;
+  typedef tpc::IndexVector IndexVector;
+  typedef std::vector<simb::MCParticle> MCParticleVector;
+  typedef std::vector<geo::TPCID> TPCIDVector;
+
+  // Geometry for the points on one trajectory.
+  struct Trajectory {
+    TPCIDVector tpcids;             // TPC holding each point (invalid if none)
+    IndexVector crys;               // Cryostat holding each point (badIndex if none)
+    Index ndet = 0;                 // # points in any TPC
+    bool havePlanePositions = false;
+    IndexVector ppoffs;             // pps[ppoffs[ipt]] is the first plane position for point ipt
+    PlanePositionVector pps;        // Plane positions for all points
+  };
+
+  // Ctor from the geometry helper used to evaluate the geometry.
+  explicit MCTrajectoryCache(const GeoHelper* pgh);
+
+  // Start a new event.
+  // If this is the event and particle vector from the last call, the cache is retained.
+  // Otherwise it is cleared and the TPC and cryostat for each point of each particle
+  // are evaluated.
+  // Returns nonzero for error.
+  int beginEvent(const art::Event& event, const MCParticleVector& pars);
+
+  // Return the geometry for a particle trajectory, evaluating it if needed.
+  // If usePlanePositions is true, the plane positions are also evaluated.
+  const Trajectory& trajectory(const simb::MCParticle& par, bool usePlanePositions =true);
+
+  // Return the cached geometry for a particle or null if it has not been evaluated.
+  // This does not modify the cache and so may be called from more than one thread.
+  const Trajectory* find(const simb::MCParticle& par) const;
+
+  // Remove all trajectories.
+  void clear();
+
+  // Number of cached trajectories.
+  Index size() const { return m_trajs.size(); }
+
+  // Number of points for which the TPC or plane positions have been evaluated.
+  Index tpcEvaluationCount() const { return m_ntpceval; }
+  Index planeEvaluationCount() const { return m_nppeval; }
+
+private:
+
+  const GeoHelper* m_pgh;
+  int m_run;
+  int m_subrun;
+  int m_event;
+  const MCParticleVector* m_ppars;
+  std::map<const simb::MCParticle*, Trajectory> m_trajs;
+  Index m_ntpceval;
+  Index m_nppeval;
+
+};
+
+typedef std::shared_ptr<MCTrajectoryCache> MCTrajectoryCachePtr;
+
+#endif
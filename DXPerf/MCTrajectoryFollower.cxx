@@ -5,6 +5,10 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <climits>
 
 // Art includes
 #include "art/Framework/Principal/Event.h"
@@ -42,8 +46,7 @@ MCTrajectoryFollower::
 MCTrajectoryFollower(double dsmax, string tname, const GeoHelper* pgeohelp,
                      unsigned int minNptdet, int dbg)
 : m_dbg(dbg), m_tname(tname), m_filltree(tname.size()), m_dsmax(dsmax), m_minNptdet(minNptdet),
-  m_generation(0), 
-  m_geohelp(pgeohelp),
+  m_geohelp(pgeohelp), m_pcache(new MCTrajectoryCache(pgeohelp)),
   m_pevt(nullptr), m_ppars(nullptr)  {
 
   const string myname = "MCTrajectoryFollower:ctor: ";
@@ -157,12 +160,6 @@ int MCTrajectoryFollower::beginEvent(const art::Event& event, const MCParticleVe
     return 1;
   }
 
-  // Check generation.
-  if ( m_generation ) {
-    cout << myname << "ERROR: Generation is not current!" << endl;
-    return 2;
-  }
-
   m_pevt = &event;
   m_ppars = &pars;
 
@@ -182,19 +179,22 @@ int MCTrajectoryFollower::beginEvent(const art::Event& event, const MCParticleVe
 
   fitrk = 0;
   m_ndetptmap.clear();
+  // Evaluate the TPC for each trajectory point. This is skipped if a follower sharing
+  // the cache has already done so for this event.
+  if ( int cstat = m_pcache->beginEvent(event, pars) ) {
+    cout << myname << "ERROR: Trajectory cache begin event returned " << cstat << endl;
+    return 3;
+  }
   // Loop over particles and fetch the # points inside the detector for each.
   // Might later want to add the # descendants with points inside the detector.
-  for ( auto const& par : pars ) {
-    unsigned int npt = 0;
-    unsigned int tid = par.TrackId();
-    size_t numberTrajectoryPoints = par.NumberTrajectoryPoints();
-      for ( unsigned int ipt=0; ipt<numberTrajectoryPoints; ++ipt ) {
-      const auto& pos = par.Position(ipt);
-      double xyzt[4] = {pos.X(), pos.Y(), pos.Z(), pos.T()};
-      geo::TPCID tpcid = m_geohelp->geometry()->FindTPCAtPosition(xyzt);
-      if ( tpcid.isValid ) ++npt;
-    }
-    m_ndetptmap[tid] = npt;
+  // Also index the particles by track ID to find daughters.
+  m_trackIndex.clear();
+  m_ndetptmap.reserve(pars.size());
+  m_trackIndex.reserve(pars.size());
+  for ( unsigned int ipar=0; ipar<pars.size(); ++ipar ) {
+    const MCParticle& par = pars[ipar];
+    m_ndetptmap[par.TrackId()] = m_pcache->trajectory(par, false).ndet;
+    m_trackIndex[par.TrackId()] = ipar;
   }
 
   return 0;
@@ -204,8 +204,214 @@ int MCTrajectoryFollower::beginEvent(const art::Event& event, const MCParticleVe
 
 int MCTrajectoryFollower::
 addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendants, IndexVector* ptids) {
+  ParticleRow row;
+  int rstat = followTrack(particle, pmtsm, useDescendants, ptids, row);
+  if ( rstat ) return rstat;
+  fillTree(row);
+  return 0;
+}
+
+//************************************************************************
+
+int MCTrajectoryFollower::
+addMCParticles(const MCParticlePtrVector& pars, const SignalMapVector& pmtsms, bool useDescendants,
+               const IndexVectorPtrVector& ptidss, StatusVector& stats, unsigned int nthread) {
+  const string myname = "MCTrajectoryFollower::addMCParticles: ";
+  unsigned int npar = pars.size();
+  stats.assign(npar, -1);
+  if ( pmtsms.size() && pmtsms.size() != npar ) {
+    cout << myname << "ERROR: Signal map count does not match particle count." << endl;
+    return -1;
+  }
+  if ( ptidss.size() && ptidss.size() != npar ) {
+    cout << myname << "ERROR: Track ID vector count does not match particle count." << endl;
+    return -2;
+  }
+  // Evaluate the geometry for all the trajectories before starting the threads.
+  for ( const MCParticle* ppar : pars ) prepareTrack(*ppar, useDescendants);
+  // Follow the particles. Each thread takes the next particle until all are done.
+  std::vector<ParticleRow> rows(npar);
+  std::atomic<unsigned int> nextpar(0);
+  auto followNext = [&]() {
+    for ( unsigned int ipar=nextpar++; ipar<npar; ipar=nextpar++ ) {
+      TpcSignalMap* pmtsm = pmtsms.size() ? pmtsms[ipar] : nullptr;
+      IndexVector* ptids = ptidss.size() ? ptidss[ipar] : nullptr;
+      stats[ipar] = followTrack(*pars[ipar], pmtsm, useDescendants, ptids, rows[ipar]);
+    }
+  };
+  if ( nthread > npar ) nthread = npar;
+  // The geometry helper fills its tick constants on first use. Fill them here so the
+  // threads only read them.
+  if ( nthread > 1 && m_geohelp != nullptr && m_geohelp->checkTickModel() ) {
+    cout << myname << "WARNING: Unable to fill the tick model. Using one thread." << endl;
+    nthread = 1;
+  }
+  if ( nthread > 1 ) {
+    if ( m_dbg > 0 ) cout << myname << "Following " << npar << " particles with "
+                          << nthread << " threads." << endl;
+    std::vector<std::thread> threads;
+    for ( unsigned int ithr=0; ithr<nthread; ++ithr ) threads.push_back(std::thread(followNext));
+    for ( std::thread& thr : threads ) thr.join();
+  } else {
+    followNext();
+  }
+  // Fill the tree in the order of the input particles.
+  int nacc = 0;
+  for ( unsigned int ipar=0; ipar<npar; ++ipar ) {
+    if ( stats[ipar] ) continue;
+    fillTree(rows[ipar]);
+    ++nacc;
+  }
+  return nacc;
+}
+
+//************************************************************************
+
+int MCTrajectoryFollower::
+followTrack(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendants,
+            IndexVector* ptids, ParticleRow& row) const {
+  const string myname = "MCTrajectoryFollower::addMCParticle G0: ";
+  if ( int rstat = followParticle(particle, 0, pmtsm, ptids, row) ) return rstat;
+  int trackid = particle.TrackId();
+
+  // Follow the descendants.
+  // They are visited depth first, each before its own descendants, using an explicit
+  // stack of (particle, generation).
+  if ( useDescendants ) {
+    ParticleStack stack;
+    pushDaughters(particle, 1, stack);
+    while ( stack.size() ) {
+      const MCParticle* ppar = stack.back().first;
+      int generation = stack.back().second;
+      stack.pop_back();
+      if ( m_dbg > 1 ) cout << myname << "---Adding child " << ppar->TrackId()
+                            << " in generation " << generation << endl;
+      followParticle(*ppar, generation, pmtsm, ptids, row);
+      pushDaughters(*ppar, generation + 1, stack);
+    }
+  } else {
+    if ( m_dbg > 1 ) cout << myname << "Not adding descendants." << endl;
+  }  // end useDescendants
+
+  bool keep = row.nptdet >= m_minNptdet;
+  if ( m_dbg > 1 ) {
+    cout << myname << "End firstgen ID=" << trackid
+         << " Keep=" << keep;
+    if ( pmtsm != nullptr ) {
+      cout << " Nbin=" << pmtsm->binCount()
+           << " Nseg=" << pmtsm->segments().size();
+    }
+    cout << "." << endl;
+  }
+
+  // Test if this particle is accepted.
+  if ( ! keep ) return 1;
+  return 0;
+}
+
+//************************************************************************
+
+void MCTrajectoryFollower::prepareTrack(const MCParticle& particle, bool useDescendants) const {
+  m_pcache->trajectory(particle);
+  if ( ! useDescendants ) return;
+  ParticleStack stack;
+  pushDaughters(particle, 1, stack);
+  while ( stack.size() ) {
+    const MCParticle* ppar = stack.back().first;
+    int generation = stack.back().second;
+    stack.pop_back();
+    m_pcache->trajectory(*ppar);
+    pushDaughters(*ppar, generation + 1, stack);
+  }
+}
+
+//************************************************************************
+
+void MCTrajectoryFollower::fillTree(const ParticleRow& row) {
+  const string myname = "MCTrajectoryFollower::addMCParticle G0: ";
+  if ( m_filltree ) {
+    fpdg = row.pdg;
+    frpdg = row.rpdg;
+    fproc = row.proc;
+    fendproc = row.endproc;
+    ftrackid = row.trackid;
+    fparent = row.parent;
+    fnchild = row.nchild;
+    fndetchild = row.ndetchild;
+    std::copy(row.child.begin(), row.child.end(), fchild);
+    std::copy(row.detchild.begin(), row.detchild.begin() + fndetchild, fdetchild);
+    fndetin = row.ndetin;
+    fndetout = row.ndetout;
+    fntpcin = row.ntpcin;
+    fntpcout = row.ntpcout;
+    fncryin = row.ncryin;
+    fncryout = row.ncryout;
+    fm = row.m;
+    std::copy(row.StartXYZT, row.StartXYZT + 4, fStartXYZT);
+    std::copy(row.EndXYZT, row.EndXYZT + 4, fEndXYZT);
+    std::copy(row.StartPE, row.StartPE + 4, fStartPE);
+    std::copy(row.EndPE, row.EndPE + 4, fEndPE);
+    fnpt = row.npt;
+    fnptdet = row.nptdet;
+    fnptcry = row.nptcry;
+    std::copy(row.npttpc.begin(), row.npttpc.end(), fnpttpc.begin());
+    std::copy(row.nptapa.begin(), row.nptapa.end(), fnptapa.begin());
+    std::copy(row.nptrop.begin(), row.nptrop.end(), fnptrop.begin());
+    std::copy(row.ptx.begin(), row.ptx.begin() + fnpt, fptx);
+    std::copy(row.pty.begin(), row.pty.begin() + fnpt, fpty);
+    std::copy(row.ptz.begin(), row.ptz.begin() + fnpt, fptz);
+    std::copy(row.ptt.begin(), row.ptt.begin() + fnpt, fptt);
+    std::copy(row.pte.begin(), row.pte.begin() + fnpt, fpte);
+    std::copy(row.pttpc.begin(), row.pttpc.begin() + fnpt, fpttpc);
+    std::copy(row.ptapa.begin(), row.ptapa.begin() + fnpt, fptapa);
+    std::copy(row.ptuchan.begin(), row.ptuchan.begin() + fnpt, fptuchan);
+    std::copy(row.ptvchan.begin(), row.ptvchan.begin() + fnpt, fptvchan);
+    std::copy(row.ptzchan.begin(), row.ptzchan.begin() + fnpt, fptzchan);
+    std::copy(row.ptutick.begin(), row.ptutick.begin() + fnpt, fptutick);
+    std::copy(row.ptvtick.begin(), row.ptvtick.begin() + fnpt, fptvtick);
+    std::copy(row.ptztick.begin(), row.ptztick.begin() + fnpt, fptztick);
+    fdetlen = row.detlen;
+    fdettickmin = row.dettickmin;
+    fdettickmax = row.dettickmax;
+    fdetx1 = row.detx1;
+    fdety1 = row.dety1;
+    fdetz1 = row.detz1;
+    fdetx2 = row.detx2;
+    fdety2 = row.dety2;
+    fdetz2 = row.detz2;
+    m_ptree->Fill();
+    if ( m_dbg > 0 ) cout << myname << "Filled tree. New entry count: " << m_ptree->GetEntries() << endl;
+  }
+  ++fitrk;
+}
+
+//************************************************************************
+
+void MCTrajectoryFollower::
+pushDaughters(const MCParticle& particle, int generation, ParticleStack& stack) const {
+  const string myname = "MCTrajectoryFollower::pushDaughters: ";
+  int nchi = particle.NumberDaughters();
+  if ( m_dbg > 1 ) cout << myname << "Descendant count for ID=" << particle.TrackId()
+                        << ": " << nchi << endl;
+  // Push in reverse order so the first daughter is popped first.
+  for ( int ichi=nchi-1; ichi>=0; --ichi ) {
+    int chtid = particle.Daughter(ichi);
+    auto itrk = m_trackIndex.find(chtid);
+    if ( m_ppars == nullptr || itrk == m_trackIndex.end() ) {
+      cout << myname << "ERROR: Child not found!" << endl;
+      continue;
+    }
+    stack.push_back(ParticleStackEntry(&(*m_ppars)[itrk->second], generation));
+  }
+}
+
+//************************************************************************
+
+int MCTrajectoryFollower::
+followParticle(const MCParticle& particle, int generation, TpcSignalMap* pmtsm,
+               IndexVector* ptids, ParticleRow& row) const {
   ostringstream ssgen;
-  ssgen << m_generation;
+  ssgen << generation;
   const string myname = "MCTrajectoryFollower::addMCParticle G" + ssgen.str() + ": ";
   if ( m_geohelp == nullptr ) {
     cout << myname << "ERROR: Geometry helper is absent." << endl;
@@ -215,44 +421,48 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
   int trackid = particle.TrackId();
   int pdg = particle.PdgCode();
   int rpdg = reducedPDG(pdg);
-  fm = particle.Mass();
+  row.m = particle.Mass();
   if ( ptids != nullptr ) {
     ptids->push_back(trackid);
     if ( m_dbg > 1 ) cout << myname << "New track ID count: " << ptids->size() << endl;
   }
   // Set the fields for the first generation.
   // These should not be overwritten by descendants.
-  if ( m_generation == 0 ) {
-    ftrackid = trackid;
-    fpdg = pdg;
-    frpdg = rpdg;
-    fparent = particle.Mother();
-    fproc = intProcess(particle.Process());
-    if ( fproc < 0 ) {
+  if ( generation == 0 ) {
+    row.trackid = trackid;
+    row.pdg = pdg;
+    row.rpdg = rpdg;
+    row.parent = particle.Mother();
+    row.proc = intProcess(particle.Process());
+    if ( row.proc < 0 ) {
       cout << myname << "WARNING: Unknown process: " << particle.Process() << endl;
     }
-    fendproc = intProcess(particle.EndProcess());
-    if ( fendproc < 0 ) {
+    row.endproc = intProcess(particle.EndProcess());
+    if ( row.endproc < 0 ) {
       cout << myname << "WARNING: Unknown end process: " << particle.EndProcess() << endl;
     }
-    fnchild = particle.NumberDaughters();
-    fndetchild = 0;
-    if ( fnchild > fmaxchild ) {
-      cout << myname << "WARNING: Too many child particles: " << fnchild << endl;
-      fnchild = fmaxchild;
+    row.nchild = particle.NumberDaughters();
+    row.ndetchild = 0;
+    if ( row.nchild > fmaxchild ) {
+      cout << myname << "WARNING: Too many child particles: " << row.nchild << endl;
+      row.nchild = fmaxchild;
     }
-    for ( unsigned int ichi=0; ichi<fnchild; ++ichi ) {
+    row.child.resize(row.nchild);
+    row.detchild.clear();
+    for ( unsigned int ichi=0; ichi<row.nchild; ++ichi ) {
       unsigned int tid = particle.Daughter(ichi);
-      fchild[ichi] = tid;
-      if ( m_ndetptmap[tid] ) fdetchild[fndetchild++] = tid;
+      row.child[ichi] = tid;
+      auto idet = m_ndetptmap.find(tid);
+      if ( idet != m_ndetptmap.end() && idet->second ) row.detchild.push_back(tid);
     }
+    row.ndetchild = row.detchild.size();
   }
-  fndetin = 0;
-  fndetout = 0;
-  fntpcin = 0;
-  fntpcout = 0;
-  fncryin = 0;
-  fncryout = 0;
+  row.ndetin = 0;
+  row.ndetout = 0;
+  row.ntpcin = 0;
+  row.ntpcout = 0;
+  row.ncryin = 0;
+  row.ncryout = 0;
 
   size_t numberTrajectoryPoints = particle.NumberTrajectoryPoints();
 
@@ -260,9 +470,9 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
     cout << myname << "Begin following ID=" << trackid << ", PDG=" << pdg
          << ", RPDG=" << rpdg
          << ", status=" << particle.StatusCode()
-         << ", Process: " << particle.Process() << "(" << fproc << ")"
+         << ", Process: " << particle.Process() << "(" << row.proc << ")"
          << ", Parent: " << particle.Mother()
-         << ", Ancestor: " << ftrackid
+         << ", Ancestor: " << row.trackid
          << endl;
     cout << myname << "# Trajectory points: " << numberTrajectoryPoints << endl;
     // Add this when updating.
@@ -290,18 +500,26 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
   // Fill arrays with the 4-values. (Don't be fooled by
   // the name of the method; it just puts the numbers from
   // the 4-vector into the array.)
-  positionStart.GetXYZT( fStartXYZT );
-  positionEnd.GetXYZT( fEndXYZT );
-  momentumStart.GetXYZT( fStartPE );
-  momentumEnd.GetXYZT( fEndPE );
+  positionStart.GetXYZT( row.StartXYZT );
+  positionEnd.GetXYZT( row.EndXYZT );
+  momentumStart.GetXYZT( row.StartPE );
+  momentumEnd.GetXYZT( row.EndPE );
 
   // Fill trajectory.
-  fnpt = 0;
-  fnptdet = 0;
-  fnptcry = 0;
-  for ( auto& count : fnpttpc ) count = 0;
-  for ( auto& count : fnptapa ) count = 0;
-  for ( auto& count : fnptrop ) count = 0;
+  row.npt = 0;
+  row.nptdet = 0;
+  row.nptcry = 0;
+  row.npttpc.assign(fntpc, 0);
+  row.nptapa.assign(fnapa, 0);
+  row.nptrop.assign(fnrop, 0);
+  unsigned int nptmax = numberTrajectoryPoints < maxpt ? numberTrajectoryPoints : maxpt;
+  for ( std::vector<float>* pvals : {&row.ptx, &row.pty, &row.ptz, &row.ptt, &row.pte,
+                                     &row.ptutick, &row.ptvtick, &row.ptztick} ) {
+    pvals->resize(nptmax);
+  }
+  for ( std::vector<int>* pvals : {&row.pttpc, &row.ptapa, &row.ptuchan, &row.ptvchan, &row.ptzchan} ) {
+    pvals->resize(nptmax);
+  }
       
   double x0 = 0.0;
   double y0 = 0.0;
@@ -316,18 +534,39 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
     cout << myname << "ERROR: Initial TPCID is valid." << endl;
     abort();
   }
-  fdetlen = 0.0;
-  fdettickmin =  1000000.0;
-  fdettickmax = -1000000.0;
-  fdetx1 = 1.e6;
-  fdety1 = 1.e6;
-  fdetz1 = 1.e6;
-  fdetx2 = 1.e6;
-  fdety2 = 1.e6;
-  fdetz2 = 1.e6;
+  row.detlen = 0.0;
+  row.dettickmin =  1000000.0;
+  row.dettickmax = -1000000.0;
+  row.detx1 = 1.e6;
+  row.dety1 = 1.e6;
+  row.detz1 = 1.e6;
+  row.detx2 = 1.e6;
+  row.dety2 = 1.e6;
+  row.detz2 = 1.e6;
   TpcSegmentPtr pseg;
   TpcSegment* pseg0 = nullptr;
   TpcSegmentVector segments;
+  // Geometry for the trajectory points. This is only read if it has already been evaluated.
+  const MCTrajectoryCache::Trajectory* ptraj = m_pcache->find(particle);
+  if ( ptraj == nullptr || ! ptraj->havePlanePositions ) ptraj = &m_pcache->trajectory(particle);
+  const MCTrajectoryCache::Trajectory& traj = *ptraj;
+  PlanePositionVector pps;     // Plane positions reused for each sub-step.
+  // Sub-step positions and their projections reused for each step.
+  std::vector<double> stpxs;
+  std::vector<double> stpys;
+  std::vector<double> stpzs;
+  std::vector<double> stpts;
+  std::vector<double> stpticks;
+  IndexVector stprops;
+  IndexVector stpchans;
+  // Cell crossings reused for each step.
+  IndexVector crsrops;
+  IndexVector crschans;
+  std::vector<double> crsticks;
+  std::vector<double> crsfracs;
+  std::vector<geo::TPCID> segtpcids;
+  // Signals from the sub-steps are recorded in a batch and committed after the loop.
+  if ( pmtsm != nullptr ) pmtsm->beginBatch();
   for ( unsigned int ipt=0; ipt<numberTrajectoryPoints; ++ipt ) {
     if ( ipt >= maxpt ) {
       cout << myname << "Found more than " << maxpt << " trajectory points."
@@ -337,23 +576,23 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
     bool lastpoint = (ipt+1 == numberTrajectoryPoints);
     const auto& pos = particle.Position(ipt);
     const auto& mom = particle.Momentum(ipt);
-    fptx[ipt] = pos.X();
-    fpty[ipt] = pos.Y();
-    fptz[ipt] = pos.Z();
-    fptt[ipt] = pos.T();
-    fpte[ipt] = mom.E();
+    row.ptx[ipt] = pos.X();
+    row.pty[ipt] = pos.Y();
+    row.ptz[ipt] = pos.Z();
+    row.ptt[ipt] = pos.T();
+    row.pte[ipt] = mom.E();
     double xyzt[4] = {pos.X(), pos.Y(), pos.Z(), pos.T()};
-    geo::TPCID tpcid = geohelp.geometry()->FindTPCAtPosition(xyzt);
-    unsigned int icry = geohelp.geometry()->FindCryostatAtPosition(xyzt);
-    if ( icry != notcry ) ++fnptcry;
-    fptuchan[ipt] = -1;
-    fptvchan[ipt] = -1;
-    fptzchan[ipt] = -1;
-    fptutick[ipt] = -1.0;
-    fptvtick[ipt] = -1.0;
-    fptztick[ipt] = -1.0;
+    geo::TPCID tpcid = traj.tpcids[ipt];
+    unsigned int icry = traj.crys[ipt];
+    if ( icry != notcry ) ++row.nptcry;
+    row.ptuchan[ipt] = -1;
+    row.ptvchan[ipt] = -1;
+    row.ptzchan[ipt] = -1;
+    row.ptutick[ipt] = -1.0;
+    row.ptvtick[ipt] = -1.0;
+    row.ptztick[ipt] = -1.0;
     bool indet = false;
-    ++fnpt;
+    ++row.npt;
     double x = pos.X();
     double y = pos.Y();
     double z = pos.Z();
@@ -362,45 +601,47 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
     double detot = 1000.0*(e0 - e);
     unsigned int itpc = badIndex();
     if ( ! tpcid.isValid ) {
-      fpttpc[ipt] = -1;
-      fptapa[ipt] = -1;
+      row.pttpc[ipt] = -1;
+      row.ptapa[ipt] = -1;
     } else if ( tpcid.Cryostat != 0 ) {
-      fpttpc[ipt] = -2;
-      fptapa[ipt] = -2;
+      row.pttpc[ipt] = -2;
+      row.ptapa[ipt] = -2;
     } else {
       indet = true;
       itpc = tpcid.TPC;
       unsigned int iapa = geohelp.tpcApa(itpc);
-      fpttpc[ipt] = itpc;
-      fptapa[ipt] = iapa;
-      if ( fnptdet == 0 ) {
-        fdetx1 = x;
-        fdety1 = y;
-        fdetz1 = z;
+      row.pttpc[ipt] = itpc;
+      row.ptapa[ipt] = iapa;
+      if ( row.nptdet == 0 ) {
+        row.detx1 = x;
+        row.dety1 = y;
+        row.detz1 = z;
       }
-      fdetx2 = x;
-      fdety2 = y;
-      fdetz2 = z;
-      // Find the (channel, tick) for each plane in this TPC.
-      PlanePositionVector pps = geohelp.planePositions(xyzt);
-      if ( pps.size() ) {
-        ++fnptdet;
-        ++fnpttpc[itpc];
-        ++fnptapa[iapa];
+      row.detx2 = x;
+      row.dety2 = y;
+      row.detz2 = z;
+      // Fetch the (channel, tick) for each plane in this TPC.
+      unsigned int ipp1 = traj.ppoffs[ipt];
+      unsigned int ipp2 = traj.ppoffs[ipt+1];
+      if ( ipp2 > ipp1 ) {
+        ++row.nptdet;
+        ++row.npttpc[itpc];
+        ++row.nptapa[iapa];
       }
-      for ( const auto& pp : pps ) {
+      for ( unsigned int ipp=ipp1; ipp<ipp2; ++ipp ) {
+        const PlanePosition& pp = traj.pps[ipp];
         unsigned int irop = pp.rop;
         View_t orient = geohelp.ropView(irop);
-        ++fnptrop[irop];
+        ++row.nptrop[irop];
         if ( orient == kU ) {
-          fptuchan[ipt] = pp.ropchannel;
-          fptutick[ipt] = pp.tick;
+          row.ptuchan[ipt] = pp.ropchannel;
+          row.ptutick[ipt] = pp.tick;
         } else if ( orient == kV ) {
-          fptvchan[ipt] = pp.ropchannel;
-          fptvtick[ipt] = pp.tick;
+          row.ptvchan[ipt] = pp.ropchannel;
+          row.ptvtick[ipt] = pp.tick;
         } else if ( orient == kZ ) {
-          fptzchan[ipt] = pp.ropchannel;
-          fptztick[ipt] = pp.tick;
+          row.ptzchan[ipt] = pp.ropchannel;
+          row.ptztick[ipt] = pp.tick;
         }
       }
       if ( !pseg || pseg->tpc != int(itpc)  ) {
@@ -413,23 +654,23 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
       }
     }
     if ( m_dbg > 3 ) cout << myname << "  MC Particle " << trackid
-                         << " point " << fnpt << ": xyzt=("
+                         << " point " << row.npt << ": xyzt=("
                          << x << ", " << y << ", " << z << ", " << t << ")"
                          << ", E=" << 1000*e << " MeV"
                          << ", TPC=" << tpcid.TPC
                          << endl;
     if ( ipt ) {
-      if ( !indet0 && indet ) ++fndetin;
-      if ( indet0 && !indet ) ++fndetout;
+      if ( !indet0 && indet ) ++row.ndetin;
+      if ( indet0 && !indet ) ++row.ndetout;
       if ( tpcid.isValid && (!tpcid0.isValid or tpcid.TPC != tpcid0.TPC ) ) {
-        ++fntpcin;
+        ++row.ntpcin;
         pseg->enter = 1;
         if ( m_dbg > 3 ) {
           cout << myname << "    Entering TPC " << tpcid.TPC;
           if ( tpcid0.isValid ) cout << ", exiting TPC " << tpcid0.TPC;
           cout << endl;
         }
-        ++fntpcin;
+        ++row.ntpcin;
         pseg->enter = 1;
       }
       if ( tpcid0.isValid && (!tpcid.isValid or tpcid.TPC != tpcid0.TPC ) ) {
@@ -441,11 +682,11 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
         if ( pseg0 == nullptr ) {
           cout << myname << "ERROR: Exited TPC with a null segment pointer." << endl;
         }
-        ++fntpcout;
+        ++row.ntpcout;
         pseg0->exit = 1;
       }
       if ( icry!=notcry && icry!=icry0 ) {
-        ++fncryin;
+        ++row.ncryin;
         if ( m_dbg > 3 ) {
           cout << myname << "    Entering cryostat " << icry;
           if ( icry0 != notcry ) cout << ", exiting cryostat " << icry0;
@@ -453,7 +694,7 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
         }
       }
       if ( icry0!=notcry && icry!=icry0 ) {
-        ++fncryout;
+        ++row.ncryout;
         if ( m_dbg > 3 ) {
           cout << myname << "    Exiting cryostat " << icry0;
           if ( icry != notcry ) cout << ", entering cryostat " << icry;
@@ -461,18 +702,58 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
         }
       }
       if ( lastpoint && m_dbg > 3 ) {
-        cout << myname << "    Last trajectory point; # children is " << fnchild << endl; 
+        cout << myname << "    Last trajectory point; # children is " << row.nchild << endl; 
       }
     }
     // Fill the signal map with dE for each pair of adjacent trajectory points.
     // Increase the number of points to ensure granularity less than fmcpdsmax;
+    // or, if that is not positive, split the step at each wire and tick boundary.
     bool useTrajSubPoints = pmtsm != nullptr;   // Caller must provide signal map.
     useTrajSubPoints &= detot > 0;          // There must be some energy deposit.
     useTrajSubPoints &= ipt != 0;           // This must not be the first point.
     useTrajSubPoints &= indet;              // This point must be in the detector.
     useTrajSubPoints &= indet0;             // Last point must be in the detector.
     useTrajSubPoints &= !deAtEndOfSegment;  // Energy deposit must be along the track.
-    if ( useTrajSubPoints ) {
+    bool useCrossings = useTrajSubPoints && m_dsmax <= 0.0;
+    if ( useCrossings ) {
+      double dx = x - x0;
+      double dy = y - y0;
+      double dz = z - z0;
+      double ds = sqrt(dx*dx + dy*dy + dz*dz);
+      double xyzt0[4] = {x0, y0, z0, t0};
+      // Deposit the energy in each (channel, tick) cell crossed by the step in each TPC
+      // it passes through. The TPCs are taken from the geometry helper grid or, if that
+      // is not available, are those holding the end points of the step.
+      if ( geohelp.findSegmentTpcs(xyzt0, xyzt, segtpcids) ) {
+        segtpcids.clear();
+        if ( tpcid0.isValid ) segtpcids.push_back(tpcid0);
+        if ( tpcid.isValid && tpcid != tpcid0 ) segtpcids.push_back(tpcid);
+      }
+      for ( const geo::TPCID& segtpcid : segtpcids ) {
+        crsrops.clear();
+        crschans.clear();
+        crsticks.clear();
+        crsfracs.clear();
+        geohelp.planeCrossings(segtpcid, xyzt0, xyzt, crsrops, crschans, crsticks, crsfracs);
+        for ( unsigned int icrs=0; icrs<crschans.size(); ++icrs ) {
+          unsigned int irop = crsrops[icrs];
+          unsigned int ichan = crschans[icrs];
+          double tick = crsticks[icrs];
+          double decell = crsfracs[icrs]*detot;
+          if ( m_dbg > 3 ) {
+            cout << myname << "    Filling: "
+                 << "ROP=" << irop
+                 << " tick=" << tick
+                 << ", chan=" << ichan - geohelp.ropFirstChannel(irop)
+                 << ", DE=" << decell << " MeV" << endl;
+          }
+          if ( tick < row.dettickmin ) row.dettickmin = tick;
+          if ( tick > row.dettickmax ) row.dettickmax = tick;
+          pmtsm->addSignal(ichan, tick, decell, segtpcid.TPC);
+        }
+      }
+      row.detlen += ds;
+    } else if ( useTrajSubPoints ) {
       double dx = x - x0;
       double dy = y - y0;
       double dz = z - z0;
@@ -482,29 +763,49 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
       double invstep = 1.0/nstep;
       double destep = invstep*detot;
       if ( m_dbg > 3 ) cout << myname << "    # steps: " << nstep << endl;
+      // Project all the sub-steps onto the planes of this TPC in one call.
+      stpxs.resize(nstep);
+      stpys.resize(nstep);
+      stpzs.resize(nstep);
+      stpts.resize(nstep);
+      for ( unsigned int istp=0; istp<nstep; ++istp ) {
+        stpxs[istp] = x0 + (istp+0.5)*invstep*dx;
+        stpys[istp] = y0 + (istp+0.5)*invstep*dy;
+        stpzs[istp] = z0 + (istp+0.5)*invstep*dz;
+        stpts[istp] = t0 + (istp+0.5)*invstep*dt;
+      }
+      bool useBatch = geohelp.planePositions(tpcid, nstep, stpxs.data(), stpys.data(), stpzs.data(),
+                                             stpts.data(), stprops, stpchans, stpticks) == 0;
+      unsigned int nplane = stprops.size();
       for ( unsigned int istp=0; istp<nstep; ++istp ) {
-        double xa = x0 + (istp+0.5)*invstep*dx;
-        double ya = y0 + (istp+0.5)*invstep*dy;
-        double za = z0 + (istp+0.5)*invstep*dz;
-        double ta = t0 + (istp+0.5)*invstep*dt;
-        double postim[4] = {xa, ya, za, ta};
-        PlanePositionVector pps = geohelp.planePositions(postim);
-        for ( const auto& pp : pps ) {
-          if ( ! pp.valid ) cout << myname << "    Invalid plane position!" << endl;
+        // Sub-steps outside this TPC are projected individually.
+        bool inTpc = useBatch;
+        for ( unsigned int ipla=0; inTpc && ipla<nplane; ++ipla ) {
+          inTpc = stpchans[ipla*nstep + istp] != GeoHelper::badIndex();
+        }
+        if ( ! inTpc ) {
+          double postim[4] = {stpxs[istp], stpys[istp], stpzs[istp], stpts[istp]};
+          geohelp.planePositions(postim, pps);
+        }
+        unsigned int npp = inTpc ? nplane : pps.size();
+        for ( unsigned int ipp=0; ipp<npp; ++ipp ) {
+          unsigned int irop = inTpc ? stprops[ipp] : pps[ipp].rop;
+          unsigned int ichan = inTpc ? stpchans[ipp*nstep + istp] : pps[ipp].channel;
+          double tick = inTpc ? stpticks[ipp*nstep + istp] : pps[ipp].tick;
           if ( m_dbg > 3 ) {
             cout << myname << "    Filling: "
-                 << "ROP=" << pp.rop
-                 << " tick=" << pp.tick
-                 << ", chan=" << pp.ropchannel
+                 << "ROP=" << irop
+                 << " tick=" << tick
+                 << ", chan=" << ichan - geohelp.ropFirstChannel(irop)
                  << ", DE=" << destep << " MeV" << endl;
           }
-          if ( pp.tick < fdettickmin ) fdettickmin = pp.tick;
-          if ( pp.tick > fdettickmax ) fdettickmax = pp.tick;
-          pmtsm->addSignal(pp.channel, pp.tick, destep, itpc);
+          if ( tick < row.dettickmin ) row.dettickmin = tick;
+          if ( tick > row.dettickmax ) row.dettickmax = tick;
+          pmtsm->addSignal(ichan, tick, destep, itpc);
         }  // End loop over planes in the TPC
       }  // End loop over sub-steps.
       // If this and the last point are in the detector, increment the detector path length.
-      if ( indet0 && indet ) fdetlen += ds;
+      if ( indet0 && indet ) row.detlen += ds;
     }
     x0 = x,
     y0 = y;
@@ -517,6 +818,7 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
     pseg0 = pseg.get();
     if ( m_dbg > 3 && pmtsm != nullptr ) cout << myname << "  Current energy deposit: " << pmtsm->tickSignal() << " MeV" << endl;
   }  // End loop over trajectory points.
+  if ( pmtsm != nullptr ) pmtsm->commitBatch();
 
   // Add segments to signal map.
   if ( pmtsm != nullptr ) {
@@ -536,58 +838,7 @@ addMCParticle(const MCParticle& particle, TpcSignalMap* pmtsm, bool useDescendan
          << ". Signal map bin count is " << pmtsm->size() << "." << endl;
   }
 
-  // Follow the descendants.
-  if ( useDescendants ) {
-    int nchi = particle.NumberDaughters();
-    if ( m_dbg > 1 ) cout << myname << "Descendant count for ID=" << trackid
-                          << ": " << nchi << endl;
-    for ( int ichi=0; ichi<nchi; ++ichi ) {
-      int chtid = particle.Daughter(ichi);
-      bool foundChild = false;
-      for ( const MCParticle& chpar : *m_ppars ) {
-        if ( chpar.TrackId() == chtid ) {
-          if ( m_dbg > 1 ) cout << myname << "---Adding child " << chtid << endl;
-          ++m_generation;
-          this->addMCParticle(chpar, pmtsm, true, ptids);
-          --m_generation;
-          foundChild = true;
-          break;
-        }
-      }  // End loop over all particles
-      if ( ! foundChild ) {
-        cout << myname << "ERROR: Child not found!" << endl;
-      }
-    }  // End loop over children.
-  } else {
-    if ( m_dbg > 1 ) cout << myname << "Not adding descendants." << endl;
-  }  // end useDescendants
-
-  // Exit if this is a descendant.
-  if ( m_generation ) return 0;
-
-  bool keep = fnptdet >= m_minNptdet;
-  if ( m_dbg > 1 ) {
-    cout << myname << "End firstgen ID=" << trackid
-         << " Keep=" << keep;
-    if ( pmtsm != nullptr ) {
-      cout << " Nbin=" << pmtsm->binCount()
-           << " Nseg=" << pmtsm->segments().size();
-    }
-    cout << "." << endl;
-  }
-
-  // Test if this particle is accepted.
-  if ( ! keep ) return 1;
-
-  // Fill the tree.
-  if ( m_filltree ) {
-    m_ptree->Fill();
-    if ( m_dbg > 0 ) cout << myname << "Filled tree. New entry count: " << m_ptree->GetEntries() << endl;
-  }
-  ++fitrk;
-
   return 0;
-
 }
 
 //**********************************************************************
@@ -4,15 +4,22 @@
 // May 2015
 //
 // Uses MCParticles to build a Root tree and to add hits to TpcSignalMap objects.
-// Interpolates between the points on the MCParticle trajectory.
+// Interpolates between the points on the MCParticle trajectory or divides the energy
+// for each step between the wire and tick cells it crosses.
+//
+// The tree fields for each particle are held in a ParticleRow that is copied to the
+// tree buffer when the particle is accepted. This allows the signal maps for different
+// particles to be filled concurrently with addMCParticles.
 
 #ifndef MCTracjectoryFollower_Module
 #define MCTracjectoryFollower_Module
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include "nusimdata/SimulationBase/MCParticle.h"
 #include "DXUtil/TpcTypes.h"
+#include "DXPerf/MCTrajectoryCache.h"
 
 namespace art {
 class Event;
@@ -29,10 +36,16 @@ class MCTrajectoryFollower {
 public:
 
   typedef std::vector<simb::MCParticle> MCParticleVector; 
+  typedef std::vector<const simb::MCParticle*> MCParticlePtrVector;
+  typedef std::vector<TpcSignalMap*> SignalMapVector;
+  typedef std::vector<tpc::IndexVector*> IndexVectorPtrVector;
+  typedef std::vector<int> StatusVector;
 
   // Ctor.
   //   dsmax  - Maximum step size used inf following trajectory.
   //            Interpolation is used when the steps are larger.
+  //            If this is zero or negative, the energy for each step is instead divided
+  //            exactly between the (channel, tick) cells the step crosses.
   //   tname - Name for the Root tree. If blank, no tree is filled.
   //   geohelp - GeoHelper used to access geometry information
   MCTrajectoryFollower(double dsmax, std::string tname, const GeoHelper* geohelp =nullptr,
@@ -41,6 +54,12 @@ public:
   // Dtor.
   ~MCTrajectoryFollower();
 
+  // Trajectory geometry cache.
+  // Each follower creates its own cache. Followers sharing the same particles may
+  // share a cache so the geometry of each trajectory point is evaluated only once.
+  MCTrajectoryCachePtr cache() const { return m_pcache; }
+  void setCache(MCTrajectoryCachePtr pcache) { m_pcache = pcache; }
+
   // This method is called at the start of each event.
   int beginEvent(const art::Event& event, const MCParticleVector& pars =MCParticleVector());
 
@@ -54,6 +73,102 @@ public:
   int addMCParticle(const simb::MCParticle& par, TpcSignalMap* pmtsm =nullptr,
                     bool useDescendants =false, tpc::IndexVector* ptids =nullptr);
 
+  // Add a vector of MCParticles to the current event.
+  // This is equivalent to calling addMCParticle for each particle in turn except the
+  // signal maps are filled using nthread threads. The tree entries are filled afterwards
+  // in the order of the input particles.
+  //   pars - The input MCParticles. These must be in the vector passed to beginEvent.
+  //   pmtsms - If not empty, the signal map for each particle (entries may be null).
+  //            The maps for different particles must be distinct.
+  //   useDescendants - If true, descendants are also added to the signal maps.
+  //   ptidss - If not empty, the track IDs for each particle are added to these vectors.
+  //   stats - On return, the status (see addMCParticle) for each particle.
+  // Returns the number of accepted particles or <0 for error.
+  int addMCParticles(const MCParticlePtrVector& pars, const SignalMapVector& pmtsms,
+                     bool useDescendants, const IndexVectorPtrVector& ptidss,
+                     StatusVector& stats, unsigned int nthread =1);
+
+private:
+
+  typedef std::pair<const simb::MCParticle*, int> ParticleStackEntry;
+  typedef std::vector<ParticleStackEntry> ParticleStack;
+
+  // Tree fields for one first-generation particle.
+  // The trajectory fields are those for the last particle followed.
+  struct ParticleRow {
+    int pdg = 0;                    // PDG ID
+    int rpdg = 0;                   // reduced PDG ID
+    int proc = 0;                   // Process
+    int endproc = 0;                // End process
+    int trackid = 0;                // Track ID
+    int parent = 0;                 // Parent track ID
+    unsigned int nchild = 0;        // # children
+    unsigned int ndetchild = 0;     // # children in detector
+    std::vector<int> child;
+    std::vector<int> detchild;
+    int ndetin = 0;                 // # TPC entries from non-TPC
+    int ndetout = 0;                // # TPC exits to non-TPC
+    int ntpcin = 0;                 // # TPC entries from non-TPC or other TPC
+    int ntpcout = 0;                // # TPC exits to not-TPC or other TPC
+    int ncryin = 0;                 // # cryo entries from non-cryo or other cryo
+    int ncryout = 0;                // # cryo exits to non-cryo or other cryo
+    float m = 0.0;                  // Mass
+    float StartXYZT[4];
+    float EndXYZT[4];
+    float StartPE[4];
+    float EndPE[4];
+    unsigned int npt = 0;           // # points in trajectory
+    unsigned int nptdet = 0;        // # trajectory points in any TPC
+    unsigned int nptcry = 0;        // # trajectory points in any cryostat
+    std::vector<unsigned int> npttpc;
+    std::vector<unsigned int> nptapa;
+    std::vector<unsigned int> nptrop;
+    std::vector<float> ptx;
+    std::vector<float> pty;
+    std::vector<float> ptz;
+    std::vector<float> ptt;
+    std::vector<float> pte;
+    std::vector<int> pttpc;
+    std::vector<int> ptapa;
+    std::vector<int> ptuchan;
+    std::vector<int> ptvchan;
+    std::vector<int> ptzchan;
+    std::vector<float> ptutick;
+    std::vector<float> ptvtick;
+    std::vector<float> ptztick;
+    float detlen = 0.0;
+    float dettickmin = 0.0;
+    float dettickmax = 0.0;
+    float detx1 = 0.0;
+    float dety1 = 0.0;
+    float detz1 = 0.0;
+    float detx2 = 0.0;
+    float dety2 = 0.0;
+    float detz2 = 0.0;
+  };
+
+  // Follow a first-generation particle and, if useDescendants is set, its descendants.
+  // The signals are added to pmtsm and the tree fields to row.
+  // Returns 0 if particle is accepted, >0 if rejected, <0 for error.
+  int followTrack(const simb::MCParticle& par, TpcSignalMap* pmtsm, bool useDescendants,
+                  tpc::IndexVector* ptids, ParticleRow& row) const;
+
+  // Follow the trajectory for one particle and add its signals to pmtsm.
+  // The tree fields are filled for this particle; those for the first
+  // generation are only filled if generation is zero.
+  int followParticle(const simb::MCParticle& par, int generation, TpcSignalMap* pmtsm,
+                     tpc::IndexVector* ptids, ParticleRow& row) const;
+
+  // Push the daughters of a particle onto a stack with the given generation.
+  void pushDaughters(const simb::MCParticle& par, int generation, ParticleStack& stack) const;
+
+  // Evaluate the cached geometry for a particle and, if useDescendants is set, its
+  // descendants so that the cache is only read while following them.
+  void prepareTrack(const simb::MCParticle& par, bool useDescendants) const;
+
+  // Copy a row to the tree buffer and fill the tree.
+  void fillTree(const ParticleRow& row);
+
 private:
 
   // Control parameters.
@@ -62,12 +177,11 @@ private:
   bool m_filltree;               // Create and fill the MCParticle tree.
   double m_dsmax;                // Maximum step size for interpolation of trajectory
   unsigned int m_minNptdet;      // Min # points in detector to keep the particle
-  int m_generation;              // Depth in the descendant tree.
 
   // The tree.
   TTree* m_ptree;
 
-  // The variables that will go into the n-tuple.
+  // The tree buffer: the variables that will go into the n-tuple.
   int fevent;
   int fRun;
   int fSubRun;
@@ -133,8 +247,14 @@ private:
   // Geometry.
   const GeoHelper* m_geohelp;
 
+  // Geometry for the trajectory points.
+  MCTrajectoryCachePtr m_pcache;
+
   // # detector points for each MC particle.
-  std::map<unsigned int, unsigned int> m_ndetptmap;
+  std::unordered_map<unsigned int, unsigned int> m_ndetptmap;
+
+  // Index in the event particle vector for each track ID.
+  std::unordered_map<int, unsigned int> m_trackIndex;
 
   const art::Event* m_pevt;
   const MCParticleVector* m_ppars;
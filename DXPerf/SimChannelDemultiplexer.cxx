@@ -0,0 +1,148 @@
+// SimChannelDemultiplexer.cxx
+
+#include "SimChannelDemultiplexer.h"
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include "lardataobj/Simulation/SimChannel.h"
+#include "DXGeometry/GeoHelper.h"
+#include "DXPerf/TpcSignalMap.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::find;
+using tpc::badIndex;
+
+typedef tpc::Channel Channel;
+typedef tpc::Tick Tick;
+
+//**********************************************************************
+
+SimChannelDemultiplexer::
+SimChannelDemultiplexer(const GeoHelper* pgh, bool useUntrackedDescendants, int dbg)
+: m_pgh(pgh), m_useUntrackedDescendants(useUntrackedDescendants), m_dbg(dbg),
+  m_needTpc(false) { }
+
+//**********************************************************************
+
+int SimChannelDemultiplexer::addDestination(int tid, TpcSignalMap* psm) {
+  IndexVector tids;
+  if ( tid >= 0 ) tids.push_back(tid);
+  return addDestination(tids, psm);
+}
+
+//**********************************************************************
+
+int SimChannelDemultiplexer::addDestination(const IndexVector& tids, TpcSignalMap* psm) {
+  const string myname = "SimChannelDemultiplexer::addDestination: ";
+  if ( psm == nullptr ) {
+    cout << myname << "ERROR: Signal map is null." << endl;
+    return 1;
+  }
+  if ( psm->usetpc() && m_pgh == nullptr ) {
+    cout << myname << "ERROR: Geometry is required to find the TPC." << endl;
+    return 2;
+  }
+  if ( find(m_dests.begin(), m_dests.end(), psm) != m_dests.end() ) {
+    cout << myname << "ERROR: Signal map " << psm->name() << " is already a destination." << endl;
+    return 3;
+  }
+  m_dests.push_back(psm);
+  if ( psm->usetpc() ) m_needTpc = true;
+  if ( tids.size() == 0 ) {
+    m_allTrackDests.push_back(psm);
+    return 0;
+  }
+  for ( Index tid : tids ) {
+    SignalMapVector& dests = m_trackDests[tid];
+    // Skip repeated track IDs.
+    if ( dests.size() && dests.back() == psm ) continue;
+    dests.push_back(psm);
+  }
+  return 0;
+}
+
+//**********************************************************************
+
+void SimChannelDemultiplexer::clear() {
+  m_dests.clear();
+  m_allTrackDests.clear();
+  m_trackDests.clear();
+  m_needTpc = false;
+}
+
+//**********************************************************************
+
+int SimChannelDemultiplexer::addSimChannels(const SimChannelVector& schs) {
+  const string myname = "SimChannelDemultiplexer::addSimChannels: ";
+  if ( m_dbg ) cout << myname << "# destinations " << m_dests.size()
+                    << ", # sim channels " << schs.size() << endl;
+  if ( m_dests.size() == 0 ) return 0;
+  const SignalMapVector nodests;
+  for ( TpcSignalMap* psm : m_dests ) psm->beginBatch();
+  for ( const sim::SimChannel& sch : schs ) {
+    Channel chan = sch.Channel();
+    const SimChannelTpcCache::TPCIDVector* ptpcids = nullptr;
+    if ( m_needTpc && m_psctpc ) ptpcids = &m_psctpc->tpcids(sch);
+    Index iide = 0;
+    for ( auto const& tickide : sch.TDCIDEMap() ) {
+      Tick tick = tickide.first;
+      auto const& ides = tickide.second;
+      Index iide0 = iide;
+      iide += ides.size();
+      // Protect against negative ticks.
+      if ( tick > 63000 ) continue;
+      for ( Index kide=0; kide<ides.size(); ++kide ) {
+        auto const& ide = ides[kide];
+        int signedtid = ide.trackID;
+        if ( ! m_useUntrackedDescendants && signedtid < 0 ) continue;
+        Index abstid = abs(signedtid);
+        auto itdests = m_trackDests.find(abstid);
+        const SignalMapVector& trackDests = itdests == m_trackDests.end() ? nodests : itdests->second;
+        if ( m_allTrackDests.size() == 0 && trackDests.size() == 0 ) {
+          if ( m_dbg > 1 ) cout << myname << "  Skipping track " << signedtid << endl;
+          continue;
+        }
+        //TpcSignalMap::Signal sig = ide.numElectrons;
+        TpcSignalMap::Signal sig = ide.energy;
+        // Find the TPC once for all destinations.
+        Index itpc = badIndex();
+        bool havetpc = false;
+        if ( m_needTpc ) {
+          geo::TPCID tpcid;
+          if ( ptpcids != nullptr ) {
+            tpcid = (*ptpcids)[iide0 + kide];
+          } else {
+            double pos[3] = {ide.x, ide.y, ide.z};
+            tpcid = m_pgh->findTpc(pos);
+          }
+          if ( ! tpcid.isValid ) {
+            cout << myname << "WARNING: IDE is not inside a TPC!" << endl;
+          } else if ( tpcid.Cryostat != 0 ) {
+            cout << myname << "WARNING: IDE is not in cryostat 0!" << endl;
+          } else {
+            itpc = tpcid.TPC;
+            havetpc = true;
+          }
+        }
+        for ( TpcSignalMap* psm : m_allTrackDests ) {
+          if ( psm->usetpc() && ! havetpc ) continue;
+          psm->addSignal(chan, tick, sig, itpc);
+        }
+        for ( TpcSignalMap* psm : trackDests ) {
+          if ( psm->usetpc() && ! havetpc ) continue;
+          psm->addSignal(chan, tick, sig, itpc);
+        }
+      }  // End loop over IDE's for this tick
+    }  // End loop over ticks for this sim channel
+  }  // End loop over sim channels
+  int rstat = 0;
+  for ( TpcSignalMap* psm : m_dests ) {
+    if ( psm->commitBatch() < 0 ) rstat = 4;
+  }
+  return rstat;
+}
+
+//**********************************************************************
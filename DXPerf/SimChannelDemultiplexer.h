@@ -0,0 +1,88 @@
+// SimChannelDemultiplexer.h
+
+#ifndef SimChannelDemultiplexer_H
+#define SimChannelDemultiplexer_H
+
+// David Adams
+// October 2026
+//
+// Class that adds the contributions from a vector of SimChannel objects to many
+// TpcSignalMap objects in one pass over the IDEs.
+//
+// Each destination signal map is registered with the track IDs whose contributions
+// it should receive. The destinations for each track ID are held in a hash map so
+// each IDE is looked up once and its TPC is found once, independent of the number
+// of destinations. The signals added to each map are the same as those from
+// TpcSignalMap::addSimChannel with the same track IDs.
+//
+// The TPCs may be taken from a SimChannelTpcCache shared with other consumers of
+// the same SimChannel objects.
+
+#include <vector>
+#include <unordered_map>
+#include "DXUtil/TpcTypes.h"
+#include "DXPerf/SimChannelTpcCache.h"
+
+namespace sim {
+class SimChannel;
+}
+class GeoHelper;
+class TpcSignalMap;
+
+class SimChannelDemultiplexer {
+
+public:
+
+  typedef tpc::Index Index;
+  typedef tpc::IndexVector IndexVector;
+  typedef std::vector<sim::SimChannel> SimChannelVector;
+  typedef std::vector<TpcSignalMap*> SignalMapVector;
+
+public:
+
+  // Ctor.
+  //  pgh - Geometry helper used to find the TPC for each IDE. This is required if
+  //        any of the destination maps has usetpc set.
+  //  useUntrackedDescendants - If true, untracked descendants are included for each
+  //        track. Those have the negative of the track ID.
+  explicit SimChannelDemultiplexer(const GeoHelper* pgh, bool useUntrackedDescendants =true, int dbg =0);
+
+  // Add a destination signal map for track tid.
+  // Set tid = -1 to include all tracks.
+  // Returns nonzero for error, e.g. if the map is already a destination.
+  int addDestination(int tid, TpcSignalMap* psm);
+
+  // Add a destination signal map for the track IDs in tids.
+  // If tids is empty, all contributions are included.
+  int addDestination(const IndexVector& tids, TpcSignalMap* psm);
+
+  // Set/get the cache used to find the TPC for each IDE.
+  // If this is not set, the TPC for each IDE is found with the geometry helper.
+  void setTpcCache(SimChannelTpcCachePtr pcache) { m_psctpc = pcache; }
+  SimChannelTpcCachePtr tpcCache() const { return m_psctpc; }
+
+  // Remove all destinations.
+  void clear();
+
+  // Return the number of destination signal maps.
+  Index destinationCount() const { return m_dests.size(); }
+
+  // Add the contributions from the sim channels to the destination signal maps.
+  // The signals for each map are added in one batch.
+  // Returns nonzero for error.
+  int addSimChannels(const SimChannelVector& schs);
+
+private:
+
+  const GeoHelper* m_pgh;
+  bool m_useUntrackedDescendants;
+  int m_dbg;
+  SignalMapVector m_dests;                                // All destinations.
+  SignalMapVector m_allTrackDests;                        // Destinations for all tracks.
+  std::unordered_map<Index, SignalMapVector> m_trackDests;  // Destinations for each track ID.
+  bool m_needTpc;                                         // Does any destination use the TPC?
+  SimChannelTpcCachePtr m_psctpc;                         // TPC for each IDE.
+
+};
+
+#endif
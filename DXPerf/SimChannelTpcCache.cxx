@@ -0,0 +1,54 @@
+// SimChannelTpcCache.cxx
+
+#include "SimChannelTpcCache.h"
+#include <string>
+#include <iostream>
+#include "lardataobj/Simulation/SimChannel.h"
+#include "DXGeometry/GeoHelper.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+
+typedef SimChannelTpcCache::TPCIDVector TPCIDVector;
+
+//**********************************************************************
+
+SimChannelTpcCache::SimChannelTpcCache(const GeoHelper* pgh)
+: m_pgh(pgh), m_nrequest(0), m_nlookup(0) { }
+
+//**********************************************************************
+
+const TPCIDVector& SimChannelTpcCache::tpcids(const sim::SimChannel& sch) {
+  const string myname = "SimChannelTpcCache::tpcids: ";
+  ++m_nrequest;
+  auto itpcids = m_tpcids.find(&sch);
+  if ( itpcids != m_tpcids.end() ) return itpcids->second;
+  TPCIDVector& tpcids = m_tpcids[&sch];
+  if ( m_pgh == nullptr ) {
+    cout << myname << "ERROR: Geometry helper is absent." << endl;
+  }
+  for ( auto const& tickide : sch.TDCIDEMap() ) {
+    int tick = tickide.first;
+    for ( auto const& ide : tickide.second ) {
+      geo::TPCID tpcid;
+      if ( m_pgh != nullptr && tick <= 63000 ) {
+        double pos[3] = {ide.x, ide.y, ide.z};
+        tpcid = m_pgh->findTpc(pos);
+        ++m_nlookup;
+      }
+      tpcids.push_back(tpcid);
+    }
+  }
+  return tpcids;
+}
+
+//**********************************************************************
+
+void SimChannelTpcCache::clear() {
+  m_tpcids.clear();
+  m_nrequest = 0;
+  m_nlookup = 0;
+}
+
+//**********************************************************************
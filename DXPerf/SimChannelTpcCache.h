@@ -0,0 +1,70 @@
+// SimChannelTpcCache.h
+
+#ifndef SimChannelTpcCache_H
+#define SimChannelTpcCache_H
+
+// David Adams
+// October 2026
+//
+// Per-event cache of the TPC holding each IDE in a set of SimChannel objects.
+//
+// The TPCs for a SimChannel are found the first time they are requested and
+// are then shared by all the signal maps filled from that channel, so the
+// geometry is queried once per IDE.
+//
+// The cache is indexed by the address of the SimChannel so the channels must
+// not be moved, copied or modified while the cache is in use. Call clear()
+// at the start of each event.
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
+#include "DXUtil/TpcTypes.h"
+
+namespace sim {
+class SimChannel;
+}
+class GeoHelper;
+
+class SimChannelTpcCache {
+
+public:
+
+  typedef tpc::Index Index;
+  typedef std::vector<geo::TPCID> TPCIDVector;
+
+  // Ctor from the geometry helper used to find the TPCs.
+  explicit SimChannelTpcCache(const GeoHelper* pgh);
+
+  // Return the TPC for each IDE of a SimChannel, evaluating them if needed.
+  // The IDEs are ordered as in TDCIDEMap, i.e. a loop over ticks and then
+  // over the IDEs for each tick.
+  // The TPC is invalid for IDEs outside all TPCs and for those with tick above
+  // 63000 (negative ticks), which are not looked up.
+  const TPCIDVector& tpcids(const sim::SimChannel& sch);
+
+  // Remove all channels.
+  void clear();
+
+  // Number of cached channels.
+  Index size() const { return m_tpcids.size(); }
+
+  // Number of calls to tpcids.
+  Index requestCount() const { return m_nrequest; }
+
+  // Number of IDEs for which the TPC has been looked up in the geometry.
+  Index lookupCount() const { return m_nlookup; }
+
+private:
+
+  const GeoHelper* m_pgh;
+  std::unordered_map<const sim::SimChannel*, TPCIDVector> m_tpcids;
+  Index m_nrequest;
+  Index m_nlookup;
+
+};
+
+typedef std::shared_ptr<SimChannelTpcCache> SimChannelTpcCachePtr;
+
+#endif
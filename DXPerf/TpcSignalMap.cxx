@@ -4,12 +4,14 @@
 #include <iomanip>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 #include "TH2.h"
 #include "nusimdata/SimulationBase/MCParticle.h"
 #include "lardataobj/Simulation/SimChannel.h"
 #include "lardataobj/RecoBase/Hit.h"
 #include "larcore/Geometry/Geometry.h"
 #include "DXUtil/reducedPDG.h"
+#include "DXUtil/ChannelTickHist.h"
 
 using std::string;
 using std::cout;
@@ -72,11 +74,7 @@ TpcSignalMap::TpcSignalMap(string name, const GeoHelper* pgh, bool ausetpc)
   m_usetpc(ausetpc),
   m_channelRange(std::numeric_limits<Channel>::max(), std::numeric_limits<Channel>::min()),
   m_tickRange(std::numeric_limits<Tick>::max(), std::numeric_limits<Tick>::min()),
-  m_rop(badIndex()) {
-  if ( m_pgh != nullptr ) {
-    m_ropnbin.resize(m_pgh->nrop(), 0);
-  }
-}
+  m_rop(badIndex()) { }
 
 //**********************************************************************
 
@@ -87,11 +85,7 @@ TpcSignalMap::TpcSignalMap(string name, const simb::MCParticle& par, const GeoHe
   m_channelRange(std::numeric_limits<Channel>::max(), std::numeric_limits<Channel>::min()),
   m_tickRange(std::numeric_limits<Tick>::max(), std::numeric_limits<Tick>::min()),
   m_pmci(new McInfo(par)),
-  m_rop(badIndex()) {
-  if ( m_pgh != nullptr ) {
-    m_ropnbin.resize(m_pgh->nrop(), 0);
-  }
-}
+  m_rop(badIndex()) { }
 
 //**********************************************************************
 
@@ -113,53 +107,28 @@ int TpcSignalMap::dbg() const {
 //**********************************************************************
 
 int TpcSignalMap::addSignal(Channel chan, Tick tick, Signal signal, Index itpcin) {
-  const string myname = "TpcSignalMap::add: ";
+  // In a batch, record the signal and defer everything else to the commit.
+  if ( m_batchDepth ) {
+    m_batch.push_back({itpcin, chan, tick, signal});
+    return 0;
+  }
+  // Not a string so that nothing is built on each call.
+  const char* const myname = "TpcSignalMap::add: ";
   if ( dbg() ) std::cout << myname
                          << "Adding channel " << chan << ", tick " << tick
                          << " with signal " << signal << endl;
   Index itpc = itpcin;
   if ( usetpc() ) {
-    if ( itpc == badIndex() ) {
-      cout << myname << "ERROR: Ignoring request to add TPC signal with invalid TPC." << endl;
-      return 1;
-    }
     if ( dbg() ) std::cout << myname << "  Using TPC " << itpc << endl;
-    if ( m_pgh != nullptr ) {
-      Index chanRop = m_pgh->channelRop(chan);
-      if ( chanRop >= m_pgh->nrop() ) {
-        cout << myname << "ERROR: Channel " << chan << " is not in detector." << endl;
-        return 2;
-      }
-      const IndexVector& ropTpcs = m_pgh->ropTpcs(chanRop);
-      if ( find(ropTpcs.begin(), ropTpcs.end(), itpc) == ropTpcs.end() ) {
-        cout << myname << "ERROR: Channel " << chan << " is not in TPC " << itpc << endl;
-        return 2;
-      }
-    }
+    if ( int stat = checkChannelTpc(chan, itpc) ) return stat;
   } else {
     itpc = badIndex();
     if ( dbg() ) std::cout << myname << "  Not using TPC " << endl;
   }
   // Ignore the TPC if object is not in the usetpc state.
-  TickChannelMap& ticksigmap = m_tpcticksig[itpc];
-  if ( ticksigmap.find(chan) == ticksigmap.end() ) ticksigmap[chan] = SignalTickMap();
-  SignalTickMap& ticksig = ticksigmap[chan];
-  if ( ticksig.find(tick) == ticksig.end() ) {
-    if ( dbg() ) std::cout << myname << "  Adding new tick" << endl;
-    ticksig[tick] = signal;
-    if ( m_pgh != nullptr ) {
-      Index irop = m_pgh->channelRop(chan);
-      if ( irop < m_ropnbin.size() ) {
-        ++m_ropnbin[irop];
-      } else {
-        cout << myname << "  Channel " << chan << " does not have a ROP." << endl;
-      }
-    }
-  } else {
-    if ( dbg() ) std::cout << myname << "  Updating existing tick" << endl;
-    ticksig[tick] += signal;
-  }
-  if ( dbg() ) std::cout << myname << "  Map entry count: " << ticksig.size() << endl;
+  // The signal is staged and summed with any existing signal in the bin
+  // when the store is consolidated.
+  m_tpcticksig[itpc].add(chan, tick, signal);
   Channel& chan1 = m_channelRange.first();
   Channel& chan2 = m_channelRange.last();
   if ( chan < chan1 ) chan1 = chan;
@@ -170,6 +139,167 @@ int TpcSignalMap::addSignal(Channel chan, Tick tick, Signal signal, Index itpcin
   if ( tick < tick1 ) tick1 = tick;
   if ( tick > tick2 ) tick2 = tick;
   if ( dbg() ) std::cout << myname << "  Tick range: " << "[" << tick1 << ", " << tick2 << "]" << endl;
+  if ( ++m_nadd >= m_naddDense ) densify();
+  return 0;
+}
+
+//**********************************************************************
+
+int TpcSignalMap::beginBatch() {
+  ++m_batchDepth;
+  return 0;
+}
+
+//**********************************************************************
+
+int TpcSignalMap::commitBatch() {
+  const string myname = "TpcSignalMap::commitBatch: ";
+  if ( m_batchDepth == 0 ) {
+    cout << myname << "ERROR: There is no open batch." << endl;
+    return -1;
+  }
+  if ( --m_batchDepth ) return 0;
+  if ( dbg() ) cout << myname << "Committing " << m_batch.size() << " signals." << endl;
+  // Ignore the TPC if object is not in the usetpc state.
+  if ( ! usetpc() ) {
+    for ( BatchSignal& bsig : m_batch ) bsig.itpc = badIndex();
+  }
+  // Sort so each (TPC, channel) is validated once and the stores receive ordered bins.
+  // The sort is stable so bins are summed in the order the signals were added.
+  std::stable_sort(m_batch.begin(), m_batch.end(),
+                   [](const BatchSignal& lhs, const BatchSignal& rhs) {
+                     if ( lhs.itpc != rhs.itpc ) return lhs.itpc < rhs.itpc;
+                     if ( lhs.chan != rhs.chan ) return lhs.chan < rhs.chan;
+                     return lhs.tick < rhs.tick;
+                   });
+  int nreject = 0;
+  Channel chan1 = m_channelRange.first();
+  Channel chan2 = m_channelRange.last();
+  Tick tick1 = m_tickRange.first();
+  Tick tick2 = m_tickRange.last();
+  TickChannelMap* pstore = nullptr;
+  bool first = true;
+  bool accept = false;
+  Index itpcLast = badIndex();
+  Channel chanLast = badChannel();
+  for ( const BatchSignal& bsig : m_batch ) {
+    if ( first || bsig.itpc != itpcLast || bsig.chan != chanLast ) {
+      accept = ! usetpc() || checkChannelTpc(bsig.chan, bsig.itpc) == 0;
+      if ( accept && (pstore == nullptr || bsig.itpc != itpcLast) ) pstore = &m_tpcticksig[bsig.itpc];
+      if ( ! accept ) pstore = nullptr;
+      itpcLast = bsig.itpc;
+      chanLast = bsig.chan;
+      first = false;
+      if ( accept ) {
+        if ( bsig.chan < chan1 ) chan1 = bsig.chan;
+        if ( bsig.chan > chan2 ) chan2 = bsig.chan;
+      }
+    }
+    if ( ! accept ) {
+      ++nreject;
+      continue;
+    }
+    pstore->add(bsig.chan, bsig.tick, bsig.signal);
+    if ( bsig.tick < tick1 ) tick1 = bsig.tick;
+    if ( bsig.tick > tick2 ) tick2 = bsig.tick;
+  }
+  m_channelRange = ChannelRange(chan1, chan2);
+  m_tickRange = TickRange(tick1, tick2);
+  m_nadd += m_batch.size() - nreject;
+  m_batch.clear();
+  if ( nreject ) cout << myname << "WARNING: Rejected " << nreject << " signals." << endl;
+  if ( m_nadd >= m_naddDense ) densify();
+  return nreject;
+}
+
+//**********************************************************************
+
+bool TpcSignalMap::inBatch() const {
+  return m_batchDepth > 0;
+}
+
+//**********************************************************************
+
+void TpcSignalMap::setDenseOccupancy(double occ) {
+  m_denseOccupancy = occ;
+}
+
+//**********************************************************************
+
+double TpcSignalMap::denseOccupancy() const {
+  return m_denseOccupancy;
+}
+
+//**********************************************************************
+
+int TpcSignalMap::densify() {
+  const string myname = "TpcSignalMap::densify: ";
+  // The check requires a merge of the staged signals so the interval between
+  // automatic checks grows with the number of signals.
+  m_naddDense = std::max(2*m_nadd, m_naddDense);
+  if ( m_pgh == nullptr ) return 0;
+  if ( m_denseOccupancy > 1.0 ) return 0;
+  int ntile = 0;
+  Index nrop = m_pgh->nrop();
+  for ( auto& tpcticksig : m_tpcticksig ) {
+    TickChannelMap& ticksig = tpcticksig.second;
+    // Only check the ROPs holding channels in this store: find the ROP for
+    // the first channel not yet checked and then skip past that ROP.
+    Index ich = 0;
+    while ( ich < ticksig.size() ) {
+      Channel chan = ticksig.channel(ich);
+      Index irop = m_pgh->channelRop(chan);
+      if ( irop >= nrop ) {
+        ++ich;
+        continue;
+      }
+      Channel ch1 = m_pgh->ropFirstChannel(irop);
+      Index nchan = m_pgh->ropNChannel(irop);
+      ich = ticksig.lowerChannel(ch1 + nchan);
+      if ( ticksig.isDense(ch1) ) continue;
+      double occ = ticksig.occupancy(ch1, nchan);
+      if ( occ == 0.0 || occ < m_denseOccupancy ) continue;
+      if ( ticksig.densify(ch1, nchan) == 0 ) {
+        if ( dbg() ) cout << myname << "Moved ROP " << irop << " TPC " << tpcticksig.first
+                          << " with occupancy " << occ << " to a dense tile." << endl;
+        ++ntile;
+      }
+    }
+  }
+  return ntile;
+}
+
+//**********************************************************************
+
+bool TpcSignalMap::ropIsDense(Index irop) const {
+  if ( m_pgh == nullptr ) return false;
+  if ( irop >= m_pgh->nrop() ) return false;
+  Channel ch1 = m_pgh->ropFirstChannel(irop);
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    if ( tpcticksig.second.isDense(ch1) ) return true;
+  }
+  return false;
+}
+
+//**********************************************************************
+
+int TpcSignalMap::checkChannelTpc(Channel chan, Index itpc) const {
+  const string myname = "TpcSignalMap::checkChannelTpc: ";
+  if ( itpc == badIndex() ) {
+    cout << myname << "ERROR: Ignoring request to add TPC signal with invalid TPC." << endl;
+    return 1;
+  }
+  if ( m_pgh != nullptr ) {
+    if ( m_pgh->channelRop(chan) >= m_pgh->nrop() ) {
+      cout << myname << "ERROR: Channel " << chan << " is not in detector." << endl;
+      return 2;
+    }
+    const IndexVector& ropTpcs = m_pgh->channelTpcs(chan);
+    if ( find(ropTpcs.begin(), ropTpcs.end(), itpc) == ropTpcs.end() ) {
+      cout << myname << "ERROR: Channel " << chan << " is not in TPC " << itpc << endl;
+      return 2;
+    }
+  }
   return 0;
 }
 
@@ -193,13 +323,20 @@ addSimChannel(const SimChannel& simchan, const IndexVector& tids, bool useUntrac
   Channel chan = simchan.Channel();
   auto const& tickides = simchan.TDCIDEMap();
   if ( dbg() ) std::cout << myname << "# tracks " << tids.size() << ", channel " << chan << endl;
+  const SimChannelTpcCache::TPCIDVector* ptpcids = nullptr;
+  if ( usetpc() && m_psctpc ) ptpcids = &m_psctpc->tpcids(simchan);
+  Index iide = 0;
+  beginBatch();
   for ( auto const& tickide : tickides ) {
     Tick tick = tickide.first;
+    auto& ides = tickide.second;
+    Index iide0 = iide;
+    iide += ides.size();
     // Protect against negative ticks.
     if ( tick > 63000 ) continue;
-    auto& ides = tickide.second;
     if ( dbg() ) std::cout << myname << "  Adding Tick=" << tick << " with IDE count " << ides.size() << endl;
-    for ( auto& ide : ides ) {
+    for ( Index kide=0; kide<ides.size(); ++kide ) {
+      auto& ide = ides[kide];
       int signedtid = ide.trackID;
       if ( ! useUntrackedDescendants && signedtid < 0 ) continue;
       Index abstid = abs(signedtid);
@@ -210,11 +347,16 @@ addSimChannel(const SimChannel& simchan, const IndexVector& tids, bool useUntrac
         if ( dbg() > 1 ) std::cout << myname << "    Signal=" << sig << endl;
         Index itpc = badIndex();
         if ( usetpc() ) {
-          double pos[3];
-          pos[0] = ide.x;
-          pos[1] = ide.y;
-          pos[2] = ide.z;
-          geo::TPCID tpcid = geometryHelper()->geometry()->FindTPCAtPosition(pos);
+          geo::TPCID tpcid;
+          if ( ptpcids != nullptr ) {
+            tpcid = (*ptpcids)[iide0 + kide];
+          } else {
+            double pos[3];
+            pos[0] = ide.x;
+            pos[1] = ide.y;
+            pos[2] = ide.z;
+            tpcid = geometryHelper()->findTpc(pos);
+          }
           if ( ! tpcid.isValid ) {
             std::cout << myname << "WARNING: IDE is not inside a TPC!" << endl;
             continue;
@@ -231,6 +373,7 @@ addSimChannel(const SimChannel& simchan, const IndexVector& tids, bool useUntrac
       }
     }  // End loop over IDE's for this tick
   }  // End loop over ticks for this sim channel
+  commitBatch();
   return 0;
 }
 
@@ -363,14 +506,12 @@ int TpcSignalMap::copySegments(const TpcSignalMapVector& tsms) {
 int TpcSignalMap::buildHits() {
   const string myname = "TpcSignalMap::buildHits: ";
   // Loop over TPCs.
-  for ( auto itpcticksig : m_tpcticksig ) {
+  for ( const auto& itpcticksig : m_tpcticksig ) {
     Index itpc = itpcticksig.first;
     const TickChannelMap& ticksig = itpcticksig.second;
     // Loop over channels.
-    for ( const auto ent : ticksig ) {
-      Channel chan = ent.first;
-      //const auto& ticks = ent.second;
-      const SignalTickMap& ticks = ent.second;
+    for ( ChannelBins bins : ticksig ) {
+      Channel chan = bins.channel();
       Signal hitsig = 0.0;
       Tick tick1 = badTick();
       Tick tick2 = badTick();
@@ -380,9 +521,10 @@ int TpcSignalMap::buildHits() {
         cout << myname << "ERROR: Channel hits already defined. Size = " << hits.size() << endl;
         return 1;
       }
-      for ( auto ticksig : ticks ) {
-        Tick tick = ticksig.first;
-        Signal sig = ticksig.second;
+      for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+        if ( ! bins.filled(ibin) ) continue;
+        Tick tick = bins.tick(ibin);
+        Signal sig = bins.signal(ibin);
         if ( tick1 != badTick() && tick != tick2+1 ) {
           hits.push_back(Hit(tick1, tick2, hitsig));
           tick1 = badTick();
@@ -407,7 +549,7 @@ int TpcSignalMap::buildHits() {
 
 IndexVector TpcSignalMap::tpcs() const {
   IndexVector out;
-  for ( auto tpcticksig : m_tpcticksig ) {
+  for ( const auto& tpcticksig : m_tpcticksig ) {
     Index itpc = tpcticksig.first;
     out.push_back(itpc);
   }
@@ -438,8 +580,47 @@ const TpcSignalMap::HitChannelMap& TpcSignalMap::hitSignalMap(Index itpc) const
 //**********************************************************************
 
 Index TpcSignalMap::ropNbin(Index irop) const {
-  if ( irop >= m_ropnbin.size() ) return 0;
-  return m_ropnbin[irop];
+  if ( m_pgh == nullptr ) return 0;
+  if ( irop >= m_pgh->nrop() ) return 0;
+  Channel ch1 = m_pgh->ropFirstChannel(irop);
+  Channel ch2 = ch1 + m_pgh->ropNChannel(irop);
+  Index nbin = 0;
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    nbin += tpcticksig.second.binCount(ch1, ch2);
+  }
+  return nbin;
+}
+
+//**********************************************************************
+
+void TpcSignalMap::consolidate() const {
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    tpcticksig.second.consolidate();
+  }
+}
+
+//**********************************************************************
+
+void TpcSignalMap::buildSummaries() const {
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    tpcticksig.second.buildSummaries();
+  }
+}
+
+//**********************************************************************
+
+double TpcSignalMap::tickCentroid() const {
+  // Combine the centroids for the TPCs.
+  double sigsum = 0.0;
+  double ticksum = 0.0;
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    const TickChannelMap& ticksig = tpcticksig.second;
+    double storesig = ticksig.totalChannelSignal();
+    sigsum += storesig;
+    ticksum += storesig*ticksig.tickCentroid();
+  }
+  if ( sigsum == 0.0 ) return 0.0;
+  return ticksum/sigsum;
 }
 
 //**********************************************************************
@@ -572,11 +753,8 @@ unsigned int TpcSignalMap::tickCount() const {
 
 unsigned int TpcSignalMap::binCount() const {
   unsigned int nbin = 0;
-  for ( auto tpcticksig : m_tpcticksig ) {
-    TickChannelMap& ticksig = tpcticksig.second;
-    for ( const auto& echan : ticksig ) {
-      nbin += echan.second.size();
-    }
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    nbin += tpcticksig.second.binCount();
   }
   return nbin;
 }
@@ -615,11 +793,9 @@ unsigned int TpcSignalMap::hitCount() const {
 
 Signal TpcSignalMap::tickSignal() const {
   Signal sigtot = 0.0;
-  for ( TpcTickChannelMap::value_type tpctickmap : m_tpcticksig ) {
-    for ( TickChannelMap::value_type chticksigmap : tpctickmap.second ) {
-      for ( SignalTickMap::value_type ticksig : chticksigmap.second ) {
-        sigtot += ticksig.second;
-      }
+  for ( const auto& tpctickmap : m_tpcticksig ) {
+    for ( ChannelBins bins : tpctickmap.second ) {
+      for ( Index ibin=0; ibin<bins.size(); ++ibin ) sigtot += bins.signal(ibin);
     }
   }
   return sigtot;
@@ -630,15 +806,12 @@ Signal TpcSignalMap::tickSignal() const {
 Signal TpcSignalMap::viewTickSignal(geo::View_t aview) const {
   const GeoHelper& geohelp = *geometryHelper();
   Signal sigtot = 0.0;
-  for ( TpcTickChannelMap::value_type tpctickmap : m_tpcticksig ) {
-    for ( TickChannelMap::value_type chticksigmap : tpctickmap.second ) {
-      Index chan = chticksigmap.first;
-      Index rop = geohelp.channelRop(chan);
-      geo::View_t view = geohelp.ropView(rop);
+  for ( const auto& tpctickmap : m_tpcticksig ) {
+    for ( ChannelBins bins : tpctickmap.second ) {
+      Index chan = bins.channel();
+      geo::View_t view = geohelp.channelView(chan);
       if ( view != aview ) continue;
-      for ( SignalTickMap::value_type ticksig : chticksigmap.second ) {
-        sigtot += ticksig.second;
-      }
+      for ( Index ibin=0; ibin<bins.size(); ++ibin ) sigtot += bins.signal(ibin);
     }
   }
   return sigtot;
@@ -661,13 +834,13 @@ Signal TpcSignalMap::hitSignal() const {
 //**********************************************************************
 
 int TpcSignalMap::fillChannelTickHist(TH2* ph) const {
-  for ( auto tpcticksig : m_tpcticksig ) {
-    TickChannelMap& ticksigmap = tpcticksig.second;
-    for ( const auto& chanticksigs : ticksigmap ) {
-      unsigned int chan = chanticksigs.first;
-      for ( const auto& ticksig : chanticksigs.second ) {
-        unsigned int tick = ticksig.first;
-        double sig = ticksig.second;
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    for ( ChannelBins bins : tpcticksig.second ) {
+      unsigned int chan = bins.channel();
+      for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+        if ( ! bins.filled(ibin) ) continue;
+        unsigned int tick = bins.tick(ibin);
+        double sig = bins.signal(ibin);
         ph->Fill(tick, chan, sig);
       }
     }
@@ -682,19 +855,23 @@ int TpcSignalMap::fillRopChannelTickHist(TH2* ph, Index irop) const {
   const string myname = "TpcSignalMap::fillRopChannelTickHist: ";
   if ( m_pgh == nullptr ) return -1;
   if ( dbg ) cout << myname << "Filling histogram " << ph->GetName() << endl;
-  for ( auto tpcticksig : m_tpcticksig ) {
-    TickChannelMap& ticksigmap = tpcticksig.second;
-    for ( const auto& chanticksigs : ticksigmap ) {
-      unsigned int chan = chanticksigs.first;
-      if ( m_pgh->channelRop(chan)  == irop ) {
-        Index ropchan = chan - m_pgh->ropFirstChannel(irop);
-        for ( const auto& ticksig : chanticksigs.second ) {
-          unsigned int tick = ticksig.first;
-          double sig = ticksig.second;
-          if ( dbg ) cout << myname << "ROPchan, tick, sig = " << ropchan
-                          << ", " << tick << ", " << sig << endl;
-          ph->Fill(tick, ropchan, sig);
-        }
+  if ( irop >= m_pgh->nrop() ) return -2;
+  Channel ch1 = m_pgh->ropFirstChannel(irop);
+  Channel ch2 = ch1 + m_pgh->ropNChannel(irop);
+  for ( const auto& tpcticksig : m_tpcticksig ) {
+    const TickChannelMap& ticksigmap = tpcticksig.second;
+    // The channels for the ROP are contiguous in the store.
+    Index ich2 = ticksigmap.lowerChannel(ch2);
+    for ( Index ich=ticksigmap.lowerChannel(ch1); ich<ich2; ++ich ) {
+      ChannelBins bins = ticksigmap.channelBins(ich);
+      Index ropchan = bins.channel() - ch1;
+      for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+        if ( ! bins.filled(ibin) ) continue;
+        unsigned int tick = bins.tick(ibin);
+        double sig = bins.signal(ibin);
+        if ( dbg ) cout << myname << "ROPchan, tick, sig = " << ropchan
+                        << ", " << tick << ", " << sig << endl;
+        ph->Fill(tick, ropchan, sig);
       }
     }
   }
@@ -703,6 +880,17 @@ int TpcSignalMap::fillRopChannelTickHist(TH2* ph, Index irop) const {
 
 //**********************************************************************
 
+int TpcSignalMap::fillRopChannelTickHist(ChannelTickHist& hist, Index irop) const {
+  if ( m_pgh == nullptr ) return -1;
+  if ( irop >= m_pgh->nrop() ) return -2;
+  if ( ropNbin(irop) == 0 ) return 0;
+  TH2* ph = hist.hist();
+  if ( ph == nullptr ) return -3;
+  return fillRopChannelTickHist(ph, irop);
+}
+
+//**********************************************************************
+
 ostream& TpcSignalMap::print(ostream& out, int fulldetail, string hdrprefix, string prefix) const {
   const string myname = "TpcSignalMap::print: ";
   if ( int cstat = check() ) {
@@ -741,23 +929,24 @@ ostream& TpcSignalMap::print(ostream& out, int fulldetail, string hdrprefix, str
   } else if ( detail1 == 1 ) {
     out << hdrprefix << "TpcSignalMap map has " << channelCount() << " channels:" << endl;
     Tick badtick = badTick();
-    for ( auto tpcticksig : m_tpcticksig ) {
+    for ( const auto& tpcticksig : m_tpcticksig ) {
       Index itpc = tpcticksig.first;
-      TickChannelMap& ticksigmap = tpcticksig.second;
+      const TickChannelMap& ticksigmap = tpcticksig.second;
       if ( itpc == badIndex() ) {
         out << prefix << "No TPC." << endl;
       } else {
         out << prefix << "TPC " << itpc << endl;
       }
-      for ( const auto& echan : ticksigmap ) {
-        Channel chan = echan.first;
+      for ( ChannelBins bins : ticksigmap ) {
+        Channel chan = bins.channel();
         out << prefix << "  " << setw(5) << chan << ": ";
         Signal channelSignal = 0;
         Tick tick1 = badtick;
         Tick tick2 = badtick;
-        for ( const auto& etick : echan.second ) {
-          Tick tick = etick.first;
-          Signal signal = etick.second;
+        for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+          if ( ! bins.filled(ibin) ) continue;
+          Tick tick = bins.tick(ibin);
+          Signal signal = bins.signal(ibin);
           channelSignal += signal;
           if ( tick1 == badtick ) {
             // Start the first range.
@@ -805,19 +994,20 @@ ostream& TpcSignalMap::print(ostream& out, int fulldetail, string hdrprefix, str
   // Line for each channel displaying the time range(s) and signal
   } else if ( detail1 == 3 ) {
     out << prefix << "TpcSignalMap map has " << tickCount() << " ticks:" << endl;
-    for ( auto tpcticksig : m_tpcticksig ) {
+    for ( const auto& tpcticksig : m_tpcticksig ) {
       Index itpc = tpcticksig.first;
-      TickChannelMap& ticksigmap = tpcticksig.second;
+      const TickChannelMap& ticksigmap = tpcticksig.second;
       if ( itpc == badIndex() ) {
         out << prefix << "No TPC." << endl;
       } else {
         out << prefix << "TPC " << itpc << endl;
       }
-      for ( const auto& echan : ticksigmap ) {
-        Channel chan = echan.first;
-        for ( const auto& etick : echan.second ) {
-          Tick tick = etick.first;
-          Signal signal = etick.second;
+      for ( ChannelBins bins : ticksigmap ) {
+        Channel chan = bins.channel();
+        for ( Index ibin=0; ibin<bins.size(); ++ibin ) {
+          if ( ! bins.filled(ibin) ) continue;
+          Tick tick = bins.tick(ibin);
+          Signal signal = bins.signal(ibin);
           out << prefix << "  " << setw(5) << chan << ": " << setw(6) << tick
               << " ADC = " << signal << " MeV" << endl;
         }
@@ -829,10 +1019,10 @@ ostream& TpcSignalMap::print(ostream& out, int fulldetail, string hdrprefix, str
   }
   // Print ROP counts.
   if ( detail2 == 1 ) {
-    if ( m_ropnbin.size() ) {
+    if ( m_pgh != nullptr && m_pgh->nrop() ) {
       out << prefix << "  ROP      Name    Nbin" << endl;
-      for ( Index irop=0; irop<m_ropnbin.size(); ++irop ) {
-        out << prefix << setw(5) << irop << setw(10) << m_pgh->ropName(irop) << setw(8) << m_ropnbin[irop] << endl;
+      for ( Index irop=0; irop<m_pgh->nrop(); ++irop ) {
+        out << prefix << setw(5) << irop << setw(10) << m_pgh->ropName(irop) << setw(8) << ropNbin(irop) << endl;
       }
     }
   }
@@ -887,9 +1077,9 @@ int TpcSignalMap::splitByRop(TpcSignalMapVector& tsms, bool splitByTpc) const {
       if ( itts == m_tpcticksig.end() ) continue;
       const TickChannelMap& ticksig = itts->second;
       auto ithv = m_tpchitsig.find(itpc);
-      HitChannelMap hitmap;
-      if ( ithv != m_tpchitsig.end() ) hitmap = ithv->second;
-      if ( dbg() > 1 ) cout << myname << "    Found " << hitmap.size() << " hits for the TPC." << endl;
+      const HitChannelMap* phitmap = ithv == m_tpchitsig.end() ? nullptr : &ithv->second;
+      if ( dbg() > 1 ) cout << myname << "    Found " << (phitmap ? phitmap->size() : 0)
+                            << " hit channels for the TPC." << endl;
       Index ch1 = geohelp.ropFirstChannel(irop);
       Index ch2 = ch1 + geohelp.ropNChannel(irop);
       if ( locdbg ) {
@@ -899,24 +1089,27 @@ int TpcSignalMap::splitByRop(TpcSignalMapVector& tsms, bool splitByTpc) const {
         cout << ", channel range (" << ch1 << ", " << ch2 << ")";
         cout << endl;
         cout << myname << "Old map size is " << ticksig.size();
-        if ( ticksig.size() ) cout << " and range is (" << ticksig.begin()->first
-                                   << ", " << ticksig.rbegin()->first << ")";
+        if ( ticksig.size() ) cout << " and range is (" << ticksig.channelRange().first()
+                                   << ", " << ticksig.channelRange().last() << ")";
         cout << endl;
       }
       TpcSignalMapPtr psm(new TpcSignalMap("tmp", m_pgh, splitByTpc));
-      for ( Channel ich=ch1; ich<ch2; ++ich ) {
-        TickChannelMap::const_iterator its = ticksig.find(ich);
-        HitChannelMap::const_iterator ihs = hitmap.find(ich);
-        if ( locdbg ) cout << myname << "  Channel " << ich << ": ";
-        if ( its != ticksig.end() ) {
-          if ( locdbg ) cout << " adding signals" << endl;
-          for ( auto ticksig : its->second ) {
-            psm->addSignal(ich, ticksig.first, ticksig.second, itpc);
-          }
-        } else {
-          if ( locdbg ) cout << " no signal" << endl;
-        }
-        if ( ihs != hitmap.end() ) psm->m_tpchitsig[itpc][ich] = ihs->second;
+      psm->m_denseOccupancy = m_denseOccupancy;
+      // The signals for the ROP channels are contiguous and the new map holds
+      // a slice that shares them with this map.
+      TickChannelMap newticksig = ticksig.slice(ch1, ch2);
+      Index nbin = newticksig.binCount();
+      if ( locdbg ) cout << myname << "  Sliced " << nbin << " bins." << endl;
+      if ( nbin ) {
+        psm->m_channelRange = newticksig.channelRange();
+        psm->m_tickRange = newticksig.tickRange();
+        psm->m_tpcticksig.emplace(itpc, std::move(newticksig));
+      }
+      // Copy the hits for the ROP channels.
+      if ( phitmap != nullptr ) {
+        HitChannelMap::const_iterator ihs1 = phitmap->lower_bound(ch1);
+        HitChannelMap::const_iterator ihs2 = phitmap->lower_bound(ch2);
+        if ( ihs1 != ihs2 ) psm->m_tpchitsig[itpc].insert(ihs1, ihs2);
       }
       if ( locdbg ) cout << myname << "  ROP " << irop << " has "
                         << psm->tickCount() << " ticks and "
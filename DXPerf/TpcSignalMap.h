@@ -12,6 +12,11 @@
 //
 // For dune, one channel may be mapped to one or two TPCs.  TpcSignalMap has a
 // flag usetpc and if it is true, signals are reccorded separately for each TPC.
+//
+// The signals for each TPC are held in a ChannelTickStore, i.e. sorted flat
+// arrays of ticks and signals with a channel index. When the occupancy of a
+// ROP exceeds the dense occupancy threshold, the signals for that ROP are moved
+// to a dense tile spanning all the ROP channels.
 
 #include <string>
 #include <vector>
@@ -23,6 +28,8 @@
 #include "DXUtil/TpcTypes.h"
 #include "DXUtil/TpcSegment.h"
 #include "DXGeometry/GeoHelper.h"
+#include "DXPerf/ChannelTickStore.h"
+#include "DXPerf/SimChannelTpcCache.h"
 
 namespace simb {
 class MCParticle;
@@ -34,6 +41,7 @@ namespace recob {
 class Hit;
 }
 class TH2;
+class ChannelTickHist;
 
 class TpcSignalMap {
 
@@ -71,8 +79,8 @@ public:
 public:
 
   typedef std::shared_ptr<McInfo> McInfoPtr;
-  typedef std::map<Tick, double> SignalTickMap;
-  typedef std::map<Channel, SignalTickMap> TickChannelMap;
+  typedef ChannelTickStore TickChannelMap;
+  typedef ChannelTickStore::ChannelBins ChannelBins;
   typedef std::map<Index, TickChannelMap> TpcTickChannelMap;
   typedef std::vector<Hit> HitVector;
   typedef std::map<Channel, HitVector> HitChannelMap;
@@ -104,10 +112,45 @@ public:
   int dbg() const;
   
   // Add a signal (energy deposit or ADC count) in a bin.
+  // The signal is staged and merged into the sorted storage on the next read.
   // If itpc is valid, then the signal is assigned to that TPC if object is in the usetpc state.
   // Returns error (nonzero) if in usetpc state and itpc is not valid.
   int addSignal(Channel chan, Tick tick, Signal signal, Index itpc =GeoHelper::badIndex());
 
+  // Start a batch of signals.
+  // Until the batch is committed, addSignal only records the (channel, tick, TPC, signal)
+  // and always returns 0. Validation and range updates are done in commitBatch.
+  // Batches may be nested. The signals are committed when the outermost batch ends.
+  int beginBatch();
+
+  // End a batch. When the outermost batch ends, the recorded signals are sorted,
+  // validated once for each (TPC, channel) and added to the signal storage.
+  // Returns the number of rejected signals or -1 if there is no open batch.
+  int commitBatch();
+
+  // Return if a batch is open.
+  bool inBatch() const;
+
+  // Set/get the occupancy above which the signals for a ROP are held in a dense tile.
+  // The occupancy is the fraction of filled bins in the ROP channels and tick window.
+  // The check is made automatically as signals are added. A value above 1.0
+  // disables dense storage. The default is ChannelTickStore::breakEvenOccupancy()
+  // so that a tile is not larger than the sparse bins it replaces.
+  void setDenseOccupancy(double occ);
+  double denseOccupancy() const;
+
+  // Move the signals for each ROP whose occupancy exceeds the threshold to dense tiles.
+  // Returns the number of tiles created.
+  int densify();
+
+  // Return if the signals for a ROP are held in a dense tile.
+  bool ropIsDense(Index irop) const;
+
+  // Set/get the cache used to find the TPC for each SimChannel IDE.
+  // If this is not set, the TPC for each IDE is found with the geometry helper.
+  void setSimChannelTpcCache(SimChannelTpcCachePtr pcache) { m_psctpc = pcache; }
+  SimChannelTpcCachePtr simChannelTpcCache() const { return m_psctpc; }
+
   // Add contributions from a SimChannel for track tid.
   // Set tid = -1 to include all tracks.
   // If useUntrackedDescendants is true, then untracked descendants are included for each track.
@@ -204,6 +247,19 @@ public:
   // Read the number of filled channel-tick bins for a ROP.
   Index ropNbin(Index irop) const;
 
+  // Merge any staged signals into the sorted storage.
+  // This is done automatically when the signals are read but should be called
+  // explicitly before the object is read from more than one thread.
+  void consolidate() const;
+
+  // Build the occupancy and signal summaries used to compare signal maps.
+  // This is done automatically when the summaries are read but should be called
+  // explicitly before the object is compared in more than one thread.
+  void buildSummaries() const;
+
+  // Return the signal-weighted mean tick.
+  double tickCentroid() const;
+
   // Return if there is MC info associated with this object.
   bool haveMcinfo() const;
 
@@ -241,26 +297,53 @@ public:
   // Fill a Channel vs. tick histogram for a given ROP.
   int fillRopChannelTickHist(TH2* ph, Index irop) const;
 
+  // Fill a booked channel vs. tick histogram for a given ROP.
+  // The histogram is only created if this map has bins in the ROP.
+  int fillRopChannelTickHist(ChannelTickHist& hist, Index irop) const;
+
   // Split this object along ROP boundaries, i.e. one object for each ROP
   // with signals. The new object are appended to tsms.
   // If splitByTpc is true, then a separate map is created for each TPC
   // in each ROP.
+  // The signals are not copied: each new map holds a slice of the signal
+  // storage of this object (see ChannelTickStore::slice).
   int splitByRop(TpcSignalMapVector& tsms, bool splitByTpc =false) const;
 
+private:
+
+  // Signal recorded in a batch.
+  struct BatchSignal {
+    Index itpc;
+    Channel chan;
+    Tick tick;
+    Signal signal;
+  };
+  typedef std::vector<BatchSignal> BatchSignalVector;
+
+  // Check that a channel may be assigned to a TPC.
+  // Returns nonzero for error with the same meaning as addSignal.
+  int checkChannelTpc(Channel chan, Index itpc) const;
+
 private:
 
   std::string m_name;             // Name.
   const GeoHelper* m_pgh;         // Geometry helper maps channels to ROPs.
   bool m_usetpc;                  // Are signals and hits indexed by TPC?
   int m_dbg = 0;                  // Debug flag: nonzero to print messages.
-  TpcTickChannelMap m_tpcticksig; // m_ticksig[itpc][chan][tick] is the signal for (itpc, chan, tick)
+  TpcTickChannelMap m_tpcticksig; // m_tpcticksig[itpc] holds the signals for TPC itpc
   TpcHitChannelMap m_tpchitsig;   // m_tpchitsig[chan][hit] is the hit for (chan, hit number)
   ChannelRange m_channelRange;    // Range of channels covered by this signal map.
   TickRange m_tickRange;          // Range of ticks covered by this signal map.
-  IndexVector m_ropnbin;          // Number of filled channel-tick bins for each ROP
   McInfoPtr m_pmci;               // Managing pointer to MC info.
   Index m_rop;                    // ROP for this object (badIndex() if not defined)
   TpcSegmentVector m_segments;    // Attached segments.
+  Index m_batchDepth = 0;         // Number of open batches.
+  BatchSignalVector m_batch;      // Signals recorded in the open batch.
+  // Occupancy above which a ROP is held in a dense tile.
+  double m_denseOccupancy = ChannelTickStore::breakEvenOccupancy();
+  Index m_nadd = 0;               // Number of signals added.
+  Index m_naddDense = 1024;       // Value of m_nadd for the next dense occupancy check.
+  SimChannelTpcCachePtr m_psctpc; // TPC for each SimChannel IDE.
 
 };
 
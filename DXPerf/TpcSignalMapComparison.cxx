@@ -12,14 +12,13 @@ using std::ostream;
 using std::cout;
 using std::endl;
 using std::setw;
-using tpc::Tick;
-using tpc::badTick;
 
 typedef TpcSignalMap::Channel Channel;
 typedef TpcSignalMap::Index Index;
 typedef TpcSignalMap::IndexPair IndexPair;
 typedef TpcSignalMap::TickChannelMap TickChannelMap;
-typedef TpcSignalMap::SignalTickMap SignalTickMap;
+typedef TpcSignalMap::ChannelBins ChannelBins;
+typedef ChannelTickStore::ChannelBits ChannelBits;
 
 namespace {
   int dbg() { return 0; }
@@ -32,7 +31,10 @@ TpcSignalMapComparison(const TpcSignalMap& tsm1, const TpcSignalMap& tsm2)
 : m_tsm1(tsm1), m_tsm2(tsm2),
   m_rop(tpc::badIndex()),
   m_chbegin(0), m_chend(tpc::badChannel()),
-  m_nchanref(tsm1.channelCount()), m_nchanmat(tsm2.channelCount()) {
+  m_nchanref(tsm1.channelCount()), m_nchanmat(tsm2.channelCount()),
+  m_evaluated(false),
+  m_nchanShared(0), m_nchanTotal(0), m_nbinShared(0), m_nbinTotal(0),
+  m_sigShared(0.0), m_sigRef(0.0), m_sigMatch(0.0) {
   const string myname = "TpcSignalMapComparison::ctor: ";
   if ( tsm1.channelCount() == 0 ) return;
   if ( tsm2.channelCount() == 0 ) return;
@@ -64,21 +66,14 @@ TpcSignalMapComparison(const TpcSignalMap& tsm1, const TpcSignalMap& tsm2)
     m_chend = m_chbegin + pgeohelp->ropNChannel(m_rop) - 1;
     m_nchanref = 0;
     m_nchanmat = 0;
+    // Channels are sorted in the signal store so the count is a difference of indices.
     for ( Index itpc : m_tsm1.tpcs() ) {
-      for ( const auto& chanticksigs1 : m_tsm1.tickSignalMap(itpc) ) {
-        Channel ch1 = chanticksigs1.first;
-        if ( ch1 < m_chbegin ) continue;
-        if ( ch1 >= m_chend ) continue;
-        ++m_nchanref;
-      }
+      const TickChannelMap& tsmap1 = m_tsm1.tickSignalMap(itpc);
+      m_nchanref += tsmap1.lowerChannel(m_chend) - tsmap1.lowerChannel(m_chbegin);
     }
     for ( Index itpc : m_tsm2.tpcs() ) {
-      for ( const auto& chanticksigs2 : m_tsm2.tickSignalMap(itpc) ) {
-        Channel ch2 = chanticksigs2.first;
-        if ( ch2 < m_chbegin ) continue;
-        if ( ch2 >= m_chend ) continue;
-        ++m_nchanmat;
-      }
+      const TickChannelMap& tsmap2 = m_tsm2.tickSignalMap(itpc);
+      m_nchanmat += tsmap2.lowerChannel(m_chend) - tsmap2.lowerChannel(m_chbegin);
     }
   }
 }
@@ -87,13 +82,66 @@ TpcSignalMapComparison(const TpcSignalMap& tsm1, const TpcSignalMap& tsm2)
 
 double TpcSignalMapComparison::channelFraction() const {
   const string myname = "TpcSignalMapComparison::channelFraction: ";
+  evaluate();
   double chanfrac = 0.0;
-  // Find the fraction of overlapping channels (in the allowed range).
-  unsigned int nchanNum = 0;
-  unsigned int nchanDen = 0;
+  if ( m_nchanTotal > 0 ) chanfrac = double(m_nchanShared)/double(m_nchanTotal);
+  if ( dbg() ) cout << myname << "--chanfrac=" << chanfrac << endl;
+  return chanfrac;
+}
+
+//**********************************************************************
+
+double TpcSignalMapComparison::binFraction() const {
+  const string myname = "TpcSignalMapComparison::binFraction: ";
+  evaluate();
+  double binfrac = 0.0;
+  if ( m_nbinTotal > 0 ) binfrac = double(m_nbinShared)/double(m_nbinTotal);
+  if ( dbg() ) cout << myname << " binfrac=" << binfrac << endl;
+  return binfrac;
+}
+
+//**********************************************************************
+
+double TpcSignalMapComparison::signalFraction() const {
+  const string myname = "TpcSignalMapComparison::signalFraction: ";
+  evaluate();
+  double sigfrac = 0.0;
+  if ( m_sigRef != 0.0 ) sigfrac = m_sigShared/m_sigRef;
+  if ( dbg() ) cout << myname << " sigfrac=" << sigfrac << endl;
+  return sigfrac;
+}
+
+//**********************************************************************
+
+double TpcSignalMapComparison::referenceSignal() const {
+  evaluate();
+  return m_sigRef;
+}
+
+//**********************************************************************
+
+double TpcSignalMapComparison::matchSignal() const {
+  evaluate();
+  return m_sigMatch;
+}
+
+//**********************************************************************
+
+double TpcSignalMapComparison::sharedSignal() const {
+  evaluate();
+  return m_sigShared;
+}
+
+//**********************************************************************
+
+void TpcSignalMapComparison::evaluate() const {
+  const string myname = "TpcSignalMapComparison::evaluate: ";
+  if ( m_evaluated ) return;
+  m_evaluated = true;
+  // Count the overlapping channels and bins (in the allowed channel range).
   if ( dbg() ) cout << myname << "Checking " << referenceChannelCount() << " and "
                     << matchChannelCount() << " channels"
-                    << " over range [" << m_chbegin << "," << m_chend << "):" << endl;
+                    << " over range [" << m_chbegin << "," << m_chend << ") for ROP " << rop() << endl;
   if ( dbg() > 1 ) {
     cout << myname << "Reference TPCs:";
     for ( Index itpc : m_tsm1.tpcs() ) cout << " " << itpc;
@@ -106,77 +154,53 @@ double TpcSignalMapComparison::channelFraction() const {
     Index itpc1 = ijtpc.first;
     Index itpc2 = ijtpc.second;
     if ( dbg() > 1 ) cout << myname << "  TPCs (" << itpc1 << ", " << itpc2 << ")" << endl;;
-    for ( const auto& ent1 : m_tsm1.tickSignalMap(itpc1) ) {
-      Channel ch1 = ent1.first;
-      if ( dbg() > 2 ) cout << myname << "    Channel " << ch1 << endl;;
-      if ( ch1 < m_chbegin ) continue;
-      if ( ch1 >= m_chend ) continue;
-      const TickChannelMap& tsmap2 = m_tsm2.tickSignalMap(itpc2);
-      bool match = tsmap2.find(ch1) != tsmap2.end();
-      if ( dbg() ) cout << (match ? "+" : ".");
-      if ( match ) ++nchanNum;
-      ++nchanDen;
-    }
-  }
-  if ( nchanDen > 0 ) chanfrac = double(nchanNum)/double(nchanDen);
-  if ( dbg() ) cout << myname << "--chanfrac=" << chanfrac << endl;
-  return chanfrac;
-}
-
-//**********************************************************************
-
-double TpcSignalMapComparison::binFraction() const {
-  const string myname = "TpcSignalMapComparison::binFraction: ";
-  double binfrac = 0.0;
-  if ( referenceChannelCount() == 0 ) {
-    if ( dbg() ) cout << myname << "No reference channels." << endl;
-    return binfrac;
-  }
-  if ( matchChannelCount() == 0 ) {
-    if ( dbg() ) cout << myname << "No match channels." << endl;
-    return binfrac;
-  }
-  // Find the fraction of overlapping bins (in the allowed channel range).
-  unsigned int nbinNum = 0;
-  unsigned int nbinDen = 0;
-  if ( dbg() ) cout << myname << "Checking " << referenceChannelCount() << " and "
-                    << matchChannelCount() << " channels for ROP " << rop() << endl;
-  // Loop over channels in the reference.
-  for ( IndexPair ijtpc : m_tsm1.sharedTpcPairs(m_tsm2.tpcs()) ) {
-    Index itpc1 = ijtpc.first;
-    Index itpc2 = ijtpc.second;
-    for ( const auto& chanticksigs1 : m_tsm1.tickSignalMap(itpc1) ) {
-      Channel ch1 = chanticksigs1.first;
-      const SignalTickMap& ticksigs1 = chanticksigs1.second;
-      if ( ch1 < m_chbegin ) continue;
-      if ( ch1 >= m_chend ) continue;
-      if ( dbg() ) cout << myname << setw(6) << ch1;
-      const auto& ichanticksigs2 = m_tsm2.tickSignalMap(itpc2).find(ch1);
-      const Tick badtick = badTick();
-      Tick ticklast = badtick;
-      // Find the matching channel in the match.
-      const SignalTickMap* pticksigs2 = nullptr;
-      if ( ichanticksigs2 != m_tsm2.tickSignalMap(itpc2).end() ) {
-        pticksigs2 = &ichanticksigs2->second;
-      }
-      // Loop over ticks in the reference channel.
-      for ( auto ticksig1 : ticksigs1 ) {
-        Tick tick = ticksig1.first;
-        bool match = (pticksigs2 != nullptr) && (pticksigs2->find(tick) != pticksigs2->end());
-        if ( match ) ++nbinNum;
-        ++nbinDen;
-        if ( dbg() ) {
-          if ( ticklast == badtick || tick != ticklast+1 ) cout << " ";
-          cout << (match ? "+" : ".");
+    const TickChannelMap& tsmap1 = m_tsm1.tickSignalMap(itpc1);
+    const TickChannelMap& tsmap2 = m_tsm2.tickSignalMap(itpc2);
+    // Walk the sorted channel lists for the reference and match together.
+    const TickChannelMap::ChannelVector& chans1 = tsmap1.channels();
+    const TickChannelMap::ChannelVector& chans2 = tsmap2.channels();
+    Index ich2 = tsmap2.lowerChannel(m_chbegin);
+    Index ich1End = tsmap1.lowerChannel(m_chend);
+    for ( Index ich1=tsmap1.lowerChannel(m_chbegin); ich1<ich1End; ++ich1 ) {
+      Channel ch1 = chans1[ich1];
+      ChannelBins bins1 = tsmap1.channelBins(ich1);
+      Index nbin1 = bins1.binCount();
+      double sig1 = tsmap1.channelSignal(ich1);
+      ++m_nchanTotal;
+      m_nbinTotal += nbin1;
+      m_sigRef += sig1;
+      while ( ich2 < chans2.size() && chans2[ich2] < ch1 ) ++ich2;
+      bool match = ich2 < chans2.size() && chans2[ich2] == ch1;
+      Index nbinShared = 0;
+      if ( match ) {
+        ++m_nchanShared;
+        ChannelBits bits2 = tsmap2.channelBits(ich2);
+        nbinShared = tsmap1.channelBits(ich1).overlapCount(bits2);
+        m_nbinShared += nbinShared;
+        // The reference bins are only visited if some but not all are shared.
+        if ( nbinShared == nbin1 ) {
+          m_sigShared += sig1;
+        } else if ( nbinShared > 0 ) {
+          for ( Index ibin1=0; ibin1<bins1.size(); ++ibin1 ) {
+            if ( bins1.filled(ibin1) && bits2.filled(bins1.tick(ibin1)) ) m_sigShared += bins1.signal(ibin1);
+          }
         }
-        ticklast = tick;
       }
-      if ( dbg() ) cout << endl;
+      if ( dbg() > 2 ) cout << myname << "    Channel " << setw(6) << ch1 << ": "
+                            << nbinShared << "/" << nbin1 << endl;
     }  // End loop over channels.
   }  // End loop over TPCs.
-  if ( nbinDen > 0 ) binfrac = double(nbinNum)/double(nbinDen);
-  if ( dbg() ) cout << myname << " binfrac=" << binfrac << endl;
-  return binfrac;
+  // Sum the match signal from the channel summaries.
+  for ( Index itpc : m_tsm2.tpcs() ) {
+    const TickChannelMap& tsmap2 = m_tsm2.tickSignalMap(itpc);
+    Index ich2End = tsmap2.lowerChannel(m_chend);
+    for ( Index ich2=tsmap2.lowerChannel(m_chbegin); ich2<ich2End; ++ich2 ) {
+      m_sigMatch += tsmap2.channelSignal(ich2);
+    }
+  }
+  if ( dbg() ) cout << myname << "Shared channels: " << m_nchanShared << "/" << m_nchanTotal
+                    << ", bins: " << m_nbinShared << "/" << m_nbinTotal
+                    << ", signal: " << m_sigShared << "/" << m_sigRef << endl;
 }
 
 //**********************************************************************
@@ -189,6 +213,10 @@ ostream& TpcSignalMapComparison::print(ostream& out, string pre) const {
   out << pre << "       Match Nchan: " << matchChannelCount() << endl;
   out << pre << "  Channel fraction: " << channelFraction() << endl;
   out << pre << "      Bin fraction: " << binFraction() << endl;
+  out << pre << "   Signal fraction: " << signalFraction() << endl;
+  out << pre << "  Reference signal: " << referenceSignal() << endl;
+  out << pre << "      Match signal: " << matchSignal() << endl;
+  out << pre << "     Shared signal: " << sharedSignal() << endl;
   return out;
 }
 
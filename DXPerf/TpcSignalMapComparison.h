@@ -7,6 +7,10 @@
 // May 2015
 //
 // Compares two TpcSignalMap objects.
+//
+// The metrics are evaluated together in one walk over the reference channels
+// when any is first requested. Shared bins are counted with the tick occupancy
+// bits of the signal stores.
 
 #include <string>
 #include <iostream>
@@ -47,12 +51,25 @@ public:
   double channelFraction() const;
   // binFraction = fraction of reference channel-tick bins included in match
   double binFraction() const;
+  // signalFraction = fraction of reference signal in bins included in match
+  double signalFraction() const;
+
+  // Summed signals in the ROP channel range.
+  // referenceSignal = reference signal in the TPCs shared with the match
+  // matchSignal = match signal
+  // sharedSignal = reference signal in bins included in the match
+  double referenceSignal() const;
+  double matchSignal() const;
+  double sharedSignal() const;
 
   // Display result.
   std::ostream& print(std::ostream& out = std::cout, std::string prefix ="") const;
 
 private:
 
+  // Count the shared channels and bins.
+  void evaluate() const;
+
   const TpcSignalMap& m_tsm1;
   const TpcSignalMap& m_tsm2;
   Index m_rop;
@@ -60,6 +77,14 @@ private:
   Channel m_chend;
   Index m_nchanref;
   Index m_nchanmat;
+  mutable bool m_evaluated;
+  mutable Index m_nchanShared;   // # reference channels also in the match
+  mutable Index m_nchanTotal;    // # reference channels
+  mutable Index m_nbinShared;    // # reference bins also in the match
+  mutable Index m_nbinTotal;     // # reference bins
+  mutable double m_sigShared;    // Reference signal in bins also in the match
+  mutable double m_sigRef;       // Reference signal
+  mutable double m_sigMatch;     // Match signal
 
 };
 
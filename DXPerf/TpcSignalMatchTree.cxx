@@ -51,6 +51,9 @@ TpcSignalMatchTree::TpcSignalMatchTree(string tname)
   m_ptree->Branch("rnseg",       &frnseg,          "rnseg/I");     // # bins in ref
   m_ptree->Branch("rsig",        &frsig,           "rsig/F");      // total signal in ref
   m_ptree->Branch("msig",        &fmsig,           "msig/F");      // total signal in match
+  m_ptree->Branch("rcsig",       &frcsig,          "rcsig/F");     // ref signal compared with match
+  m_ptree->Branch("mcsig",       &fmcsig,          "mcsig/F");     // match signal compared with ref
+  m_ptree->Branch("shsig",       &fshsig,          "shsig/F");     // ref signal shared with match
 
   if ( dbg > 0 ) {
     cout << myname << "Initialization complete." << endl;
@@ -87,10 +90,18 @@ int TpcSignalMatchTree::fill(const art::EventID& evid, const TpcSignalMatcher& m
     frsig = rtsm.tickSignal();
     fmnbin = 0;
     fmsig = 0.0;
+    frcsig = 0.0;
+    fmcsig = 0.0;
+    fshsig = 0.0;
     if ( fstat==TpcSignalMatcher::MATCHED || fstat==TpcSignalMatcher::DUPLICATE ) {
       const TpcSignalMap& mtsm = *match.matchVector().at(imat);
       fmnbin = mtsm.binCount();
       fmsig = mtsm.tickSignal();
+      // The signal sums are those kept by the matcher for this pair.
+      TpcSignalMatcher::MatchSignals sigs = match.matchSignals(ient);
+      frcsig = sigs.reference;
+      fmcsig = sigs.match;
+      fshsig = sigs.shared;
     }
     m_ptree->Fill();
   }
@@ -57,6 +57,9 @@ private:
   int frnseg;         // # segments attached to the reference.
   float frsig;
   float fmsig;
+  float frcsig;       // Reference signal compared with the match.
+  float fmcsig;       // Match signal compared with the reference.
+  float fshsig;       // Reference signal in bins shared with the match.
 
 }; // class TpcSignalMatchTree
 
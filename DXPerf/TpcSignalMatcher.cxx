@@ -4,6 +4,12 @@
 #include <sstream>
 #include <ostream>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <atomic>
+#include <thread>
 #include "DXPerf/TpcSignalMapComparison.h"
 
 using std::string;
@@ -15,9 +21,14 @@ using std::endl;
 using std::vector;
 using tpc::badIndex;
 using tpc::badIndex2;
+using tpc::Channel;
+using tpc::Tick;
 
 typedef TpcSignalMatcher::Index Index;
+typedef TpcSignalMatcher::IndexVector IndexVector;
 typedef TpcSignalMatcher::Distance Distance;
+typedef TpcSignalMatcher::ComparisonDistance ComparisonDistance;
+typedef TpcSignalMatcher::MatchSignals MatchSignals;
 typedef TpcSignalMatcher::T1 T1;
 typedef TpcSignalMatcher::T2 T2;
 
@@ -25,28 +36,183 @@ typedef TpcSignalMatcher::T2 T2;
 
 namespace {
 
-double channelFractionDistance(const T1& o1, const T2& o2) {
-  TpcSignalMapComparison com(o1, o2);
+double channelFractionComparison(const TpcSignalMapComparison& com) {
   return 1.0 - com.channelFraction();
 }
 
-double binFractionDistance(const T1& o1, const T2& o2) {
-  TpcSignalMapComparison com(o1, o2);
+double binFractionComparison(const TpcSignalMapComparison& com) {
   return 1.0 - com.binFraction();
 }
 
+double signalFractionComparison(const TpcSignalMapComparison& com) {
+  return 1.0 - com.signalFraction();
+}
+
+double channelFractionDistance(const T1& o1, const T2& o2) {
+  return channelFractionComparison(TpcSignalMapComparison(o1, o2));
+}
+
+double binFractionDistance(const T1& o1, const T2& o2) {
+  return binFractionComparison(TpcSignalMapComparison(o1, o2));
+}
+
+double signalFractionDistance(const T1& o1, const T2& o2) {
+  return signalFractionComparison(TpcSignalMapComparison(o1, o2));
+}
+
+// Maps without shared channels have the maximum distance.
+double tickCentroidDistance(const T1& o1, const T2& o2) {
+  if ( o1.channelCount() == 0 || o2.channelCount() == 0 ) return 1.0;
+  if ( o1.channelMax() < o2.channelMin() || o2.channelMax() < o1.channelMin() ) return 1.0;
+  double ntick = 0.5*(o1.tickCount() + o2.tickCount());
+  double dis = fabs(o1.tickCentroid() - o2.tickCentroid())/ntick;
+  return dis < 1.0 ? dis : 1.0;
+}
+
+// Registry of metrics indexed by Metric.
+const vector<TpcSignalMatcher::MetricInfo>& metrics() {
+  static const vector<TpcSignalMatcher::MetricInfo> mets = {
+    {"Undefined",       nullptr,                  nullptr,                    false, false},
+    {"BinFraction",     &binFractionDistance,     &binFractionComparison,     true,  true},
+    {"ChannelFraction", &channelFractionDistance, &channelFractionComparison, true,  false},
+    {"SignalFraction",  &signalFractionDistance,  &signalFractionComparison,  true,  true},
+    {"TickCentroid",    &tickCentroidDistance,    nullptr,                    true,  false}
+  };
+  return mets;
+}
+
+// Channel and tick bounding box for a signal map.
+// The box for an empty map has first > last and overlaps nothing.
+struct BoundingBox {
+  Channel chan1;
+  Channel chan2;
+  Tick tick1;
+  Tick tick2;
+  BoundingBox(const TpcSignalMap& sm)
+  : chan1(sm.channelMin()), chan2(sm.channelMax()),
+    tick1(sm.tickMin()), tick2(sm.tickMax()) { }
+  bool overlapsChannels(const BoundingBox& rhs) const {
+    return chan1 <= rhs.chan2 && rhs.chan1 <= chan2;
+  }
+  bool overlapsTicks(const BoundingBox& rhs) const {
+    return tick1 <= rhs.tick2 && rhs.tick1 <= tick2;
+  }
+};
+
+// Allowed assignment of a row to a column with its cost.
+struct Arc {
+  Index col;
+  double cost;
+};
+typedef vector<Arc> ArcVector;
+
+// Solve the assignment problem for rows with sparse costs, i.e. find the column
+// for each row that minimizes the summed cost with each column used at most once.
+// Only the listed arcs are allowed and each row must have an assignment.
+// Rows are added one at a time, each with the shortest augmenting path found by
+// Dijkstra's algorithm over the arcs reached from that row. Row potentials u and
+// column potentials v keep the reduced costs non-negative. Only the columns
+// reached by a search are visited so the time for a row is set by the arcs
+// near it rather than the total number of columns.
+// Entry irow of the returned vector is the column assigned to row irow.
+IndexVector solveAssignment(const vector<ArcVector>& rowarcs, Index ncol) {
+  const double inf = std::numeric_limits<double>::infinity();
+  Index nrow = rowarcs.size();
+  vector<double> u(nrow, 0.0);
+  vector<double> v(ncol, 0.0);
+  IndexVector rowcol(nrow, badIndex());
+  IndexVector colrow(ncol, badIndex());
+  // Path length to each column and the row preceding it on the path.
+  vector<double> dist(ncol, inf);
+  IndexVector way(ncol, badIndex());
+  vector<bool> done(ncol, false);
+  IndexVector reachedCols;
+  IndexVector doneCols;
+  IndexVector doneRows;
+  // Heap of (distance, column) with the nearest column at the front.
+  // Ties go to the lowest column. Entries for columns already done are skipped.
+  typedef std::pair<double, Index> HeapEntry;
+  vector<HeapEntry> heap;
+  std::greater<HeapEntry> heapOrder;
+  for ( Index irow0=0; irow0<nrow; ++irow0 ) {
+    Index irow = irow0;
+    double dmin = 0.0;
+    Index jsink = badIndex();
+    // Grow the search from the new row until a free column is reached.
+    while ( jsink == badIndex() ) {
+      doneRows.push_back(irow);
+      for ( const Arc& arc : rowarcs[irow] ) {
+        Index jcol = arc.col;
+        if ( done[jcol] ) continue;
+        double dis = dmin + arc.cost - u[irow] - v[jcol];
+        if ( dis < dist[jcol] ) {
+          if ( dist[jcol] == inf ) reachedCols.push_back(jcol);
+          dist[jcol] = dis;
+          way[jcol] = irow;
+          heap.push_back(HeapEntry(dis, jcol));
+          std::push_heap(heap.begin(), heap.end(), heapOrder);
+        }
+      }
+      Index jcol = badIndex();
+      while ( ! heap.empty() && jcol == badIndex() ) {
+        std::pop_heap(heap.begin(), heap.end(), heapOrder);
+        HeapEntry ent = heap.back();
+        heap.pop_back();
+        if ( ! done[ent.second] && ent.first == dist[ent.second] ) jcol = ent.second;
+      }
+      if ( jcol == badIndex() ) break;
+      done[jcol] = true;
+      doneCols.push_back(jcol);
+      dmin = dist[jcol];
+      if ( colrow[jcol] == badIndex() ) jsink = jcol;
+      else irow = colrow[jcol];
+    }
+    // Update the potentials and flip the path.
+    // A row without a path is left unassigned.
+    if ( jsink != badIndex() ) {
+      u[irow0] += dmin;
+      for ( Index jrow : doneRows ) {
+        if ( jrow != irow0 ) u[jrow] += dmin - dist[rowcol[jrow]];
+      }
+      for ( Index jcol : doneCols ) v[jcol] -= dmin - dist[jcol];
+      for ( Index jcol=jsink; jcol!=badIndex(); ) {
+        Index jrow = way[jcol];
+        Index jnext = rowcol[jrow];
+        rowcol[jrow] = jcol;
+        colrow[jcol] = jrow;
+        jcol = jnext;
+      }
+    }
+    for ( Index jcol : reachedCols ) {
+      dist[jcol] = inf;
+      done[jcol] = false;
+    }
+    reachedCols.clear();
+    doneCols.clear();
+    doneRows.clear();
+    heap.clear();
+  }
+  return rowcol;
+}
+
 }
 
 //**********************************************************************
 
-TpcSignalMatcher::TpcSignalMatcher(const C1& cr, const C2& cm, bool ropMatch, int dbg)
-: m_cr(cr), m_cm(cm) {
+TpcSignalMatcher::
+TpcSignalMatcher(const C1& cr, const C2& cm, bool ropMatch, int dbg, Assignment amode, Metric met,
+                 unsigned int nthread)
+: m_cr(cr), m_cm(cm), m_ndistance(0), m_amode(amode), m_metric(met) {
   const string myname = "TpcSignalMatcher::ctor: ";
+  const MetricInfo* pmet = metricInfo(m_metric);
+  if ( pmet == nullptr ) {
+    cout << myname << "ERROR: Invalid metric: " << m_metric << endl;
+    return;
+  }
   if ( dbg ) {
     cout << myname << "C1 size: " <<  m_cr.size() << endl;
     cout << myname << "C2 size: " <<  m_cm.size() << endl;
   }
-  unsigned int i1 = 0;
   // Create vector that holds the indices of cm indexed by ROP.
   // If ropMatch is not true, all are recorded with ROP=0.
   vector<IndexVector> indicesByRop(1);
@@ -94,33 +260,124 @@ TpcSignalMatcher::TpcSignalMatcher(const C1& cr, const C2& cm, bool ropMatch, in
       indicesByRop[0].push_back(i2);
     }
   }
+  // Group the references by ROP. Each ROP is a shard that may be matched in its own thread.
+  Index nshard = indicesByRop.size();
+  vector<IndexVector> refsByRop(nshard);
+  for ( Index i1=0; i1<m_cr.size(); ++i1 ) {
+    Index irop = ropMatch ? m_cr[i1]->rop() : 0;
+    refsByRop[irop].push_back(i1);
+  }
+  unsigned int nthr = nthread;
+  if ( nthr > nshard ) nthr = nshard;
+  if ( nthr < 1 ) nthr = 1;
+  // Build the per-map summaries used by the metric.
+  // The maps are read concurrently when there is more than one thread, so they are
+  // then consolidated and summarized here in any case.
+  if ( pmet->useSummaries || nthr > 1 ) {
+    for ( const auto& p1 : m_cr ) p1->buildSummaries();
+    for ( const auto& p2 : m_cm ) p2->buildSummaries();
+  }
+  // Index the candidates by bounding box.
+  // The candidates for each ROP are sorted by their first channel so the scan for
+  // a reference can stop at the first candidate beyond its last channel.
+  // All metrics require a shared channel and some also require a shared tick.
+  bool pruneTicks = pmet->needTickOverlap;
+  Distance dfun = pmet->distance;
+  ComparisonDistance cfun = pmet->comparisonDistance;
+  double dmax = maxDistance();
+  vector<BoundingBox> boxes;
+  boxes.reserve(m_cm.size());
+  for ( const auto& p2 : m_cm ) boxes.emplace_back(*p2);
+  for ( IndexVector& indices : indicesByRop ) {
+    std::stable_sort(indices.begin(), indices.end(),
+                     [&boxes](Index lhs, Index rhs) { return boxes[lhs].chan1 < boxes[rhs].chan1; });
+  }
   // Do the matching.
-  for ( const auto& p1 : m_cr ) {
-    if ( dbg > 1 ) cout << myname << "  Reference candidate " << i1 << endl;
-    double dmin = maxDistance();
-    Status stat = UNMATCHED;
-    Index imin = tpc::badIndex();
-    Index irop = ropMatch ? p1->rop() : 0;
-    if ( dbg > 1 ) cout << myname << "  Match vector size for ROP " << irop << " is "
-                        << indicesByRop[irop].size() << endl;
-    for ( Index i2 : indicesByRop[irop] ) {
-      P2 p2 = m_cm[i2];
-      double dis = distance()(*p1, *p2);
-      if ( dbg > 1 ) cout << myname << "    Matching candidate " << i2 << " has distance " << dis << endl;
-      if ( dis < dmin ) {
-        stat = MATCHED;
-        imin = i2;
-        dmin = dis;
+  // Each shard writes the results for its references and records its distance count
+  // and, for the optimal assignment, the pairs with less than the maximum distance.
+  // Each reference is printed only when matching in one thread.
+  int refdbg = nthr > 1 ? 0 : dbg;
+  m_matchStatus.assign(m_cr.size(), UNMATCHED);
+  m_matchIndex.assign(m_cr.size(), badIndex());
+  m_matchDistance.assign(m_cr.size(), dmax);
+  m_matchSignals.assign(m_cr.size(), MatchSignals{0.0, 0.0, 0.0});
+  vector<EdgeVector> shardEdges(nshard);
+  vector<unsigned int> shardCounts(nshard, 0);
+  auto matchShard = [&](Index irop) {
+    const IndexVector& cans = indicesByRop[irop];
+    EdgeVector& edges = shardEdges[irop];
+    unsigned int& ndis = shardCounts[irop];
+    for ( Index i1 : refsByRop[irop] ) {
+      const P1& p1 = m_cr[i1];
+      if ( refdbg > 1 ) cout << myname << "  Reference candidate " << i1 << endl;
+      double dmin = dmax;
+      Status stat = UNMATCHED;
+      Index imin = tpc::badIndex();
+      MatchSignals sigmin = {0.0, 0.0, 0.0};
+      if ( refdbg > 1 ) cout << myname << "  Match vector size for ROP " << irop << " is "
+                             << cans.size() << endl;
+      BoundingBox box1(*p1);
+      for ( Index i2 : cans ) {
+        const BoundingBox& box2 = boxes[i2];
+        if ( box2.chan1 > box1.chan2 ) break;
+        if ( ! box1.overlapsChannels(box2) ) continue;
+        if ( pruneTicks && ! box1.overlapsTicks(box2) ) continue;
+        const P2& p2 = m_cm[i2];
+        // Keep the signal sums from the comparison that gives the distance.
+        double dis = dmax;
+        MatchSignals sigs = {0.0, 0.0, 0.0};
+        if ( cfun != nullptr ) {
+          TpcSignalMapComparison com(*p1, *p2);
+          dis = cfun(com);
+          sigs = {com.referenceSignal(), com.matchSignal(), com.sharedSignal()};
+        } else {
+          dis = dfun(*p1, *p2);
+        }
+        ++ndis;
+        if ( refdbg > 1 ) cout << myname << "    Matching candidate " << i2 << " has distance " << dis << endl;
+        if ( m_amode == OPTIMAL && dis < dmax ) edges.push_back({i1, i2, dis, sigs});
+        // Candidates are not visited in index order so ties go to the lowest index
+        // as in an exhaustive scan.
+        if ( dis < dmin || (stat == MATCHED && dis == dmin && i2 < imin) ) {
+          stat = MATCHED;
+          imin = i2;
+          dmin = dis;
+          sigmin = sigs;
+        }
+      }
+      m_matchStatus[i1] = stat;
+      m_matchIndex[i1] = imin;
+      m_matchDistance[i1] = dmin;
+      m_matchSignals[i1] = sigmin;
+      if ( refdbg && m_amode != OPTIMAL ) {
+        if ( stat == MATCHED ) cout << myname << "  Match to " << imin << " with distance " << dmin << endl;
+        else cout << myname << "  No match found" << endl;
       }
     }
-    m_matchStatus.push_back(stat);
-    m_matchIndex.push_back(imin);
-    m_matchDistance.push_back(dmin);
-    if ( dbg ) {
-      if ( stat == MATCHED ) cout << myname << "  Match to " << imin << " with distance " << dmin << endl;
-      else cout << myname << "  No match found" << endl;
-    }
-    ++i1;
+  };
+  if ( nthr > 1 ) {
+    if ( dbg ) cout << myname << "Matching " << nshard << " shards with " << nthr << " threads." << endl;
+    std::atomic<Index> nextShard(0);
+    auto work = [&]() {
+      for ( Index irop=nextShard++; irop<nshard; irop=nextShard++ ) matchShard(irop);
+    };
+    vector<std::thread> threads;
+    for ( unsigned int ithr=1; ithr<nthr; ++ithr ) threads.emplace_back(work);
+    work();
+    for ( std::thread& thr : threads ) thr.join();
+  } else {
+    for ( Index irop=0; irop<nshard; ++irop ) matchShard(irop);
+  }
+  EdgeVector edges;
+  for ( Index irop=0; irop<nshard; ++irop ) {
+    m_ndistance += shardCounts[irop];
+    edges.insert(edges.end(), shardEdges[irop].begin(), shardEdges[irop].end());
+  }
+  if ( dbg ) cout << myname << "Distance evaluation count: " << m_ndistance << endl;
+  if ( m_amode == OPTIMAL ) {
+    assignOptimal(edges, dbg);
+    if ( cfun == nullptr ) evaluateMatchSignals();
+    return;
   }
   // Remove duplicate matches.
   // For now remove the match with fewer bins.
@@ -149,13 +406,102 @@ TpcSignalMatcher::TpcSignalMatcher(const C1& cr, const C2& cm, bool ropMatch, in
       }
     }
   }
+  if ( cfun == nullptr ) evaluateMatchSignals();
+}
+
+//**********************************************************************
+
+void TpcSignalMatcher::assignOptimal(const EdgeVector& edges, int dbg) {
+  const string myname = "TpcSignalMatcher::assignOptimal: ";
+  Index nref = m_cr.size();
+  double dmax = maxDistance();
+  for ( Index i1=0; i1<nref; ++i1 ) {
+    m_matchStatus[i1] = UNMATCHED;
+    m_matchIndex[i1] = badIndex();
+    m_matchDistance[i1] = dmax;
+    m_matchSignals[i1] = {0.0, 0.0, 0.0};
+  }
+  // Build the assignment rows from the references with edges.
+  // Column i2 is candidate i2 and each row also has its own column with the
+  // maximum distance so that any reference may be left unmatched.
+  Index ncan = m_cm.size();
+  IndexVector refrow(nref, badIndex());
+  IndexVector refs;
+  vector<ArcVector> rowarcs;
+  vector<IndexVector> rowedges;
+  for ( Index iedg=0; iedg<edges.size(); ++iedg ) {
+    const Edge& edge = edges[iedg];
+    Index& irow = refrow[edge.i1];
+    if ( irow == badIndex() ) {
+      irow = refs.size();
+      refs.push_back(edge.i1);
+      rowarcs.emplace_back();
+      rowedges.emplace_back();
+    }
+    rowarcs[irow].push_back({edge.i2, edge.dis});
+    rowedges[irow].push_back(iedg);
+  }
+  Index nrow = refs.size();
+  for ( Index irow=0; irow<nrow; ++irow ) rowarcs[irow].push_back({ncan + irow, dmax});
+  if ( dbg ) cout << myname << "Assigning " << edges.size() << " pairs for "
+                  << nrow << " references." << endl;
+  IndexVector rowcol = solveAssignment(rowarcs, ncan + nrow);
+  for ( Index irow=0; irow<nrow; ++irow ) {
+    Index icol = rowcol[irow];
+    if ( icol >= ncan ) continue;
+    for ( Index iedg : rowedges[irow] ) {
+      const Edge& edge = edges[iedg];
+      if ( edge.i2 != icol ) continue;
+      m_matchStatus[edge.i1] = MATCHED;
+      m_matchIndex[edge.i1] = icol;
+      m_matchDistance[edge.i1] = edge.dis;
+      m_matchSignals[edge.i1] = edge.sigs;
+      break;
+    }
+  }
+  if ( dbg ) {
+    for ( Index i1=0; i1<nref; ++i1 ) {
+      if ( m_matchStatus[i1] == MATCHED ) cout << myname << "  Reference " << i1 << " matched to "
+                                               << m_matchIndex[i1] << " with distance "
+                                               << m_matchDistance[i1] << endl;
+      else cout << myname << "  Reference " << i1 << " is not matched" << endl;
+    }
+  }
+}
+
+//**********************************************************************
+
+void TpcSignalMatcher::evaluateMatchSignals() {
+  for ( Index i1=0; i1<m_cr.size(); ++i1 ) {
+    Status stat = m_matchStatus[i1];
+    if ( stat != MATCHED && stat != DUPLICATE ) continue;
+    TpcSignalMapComparison com(*m_cr[i1], *m_cm[m_matchIndex[i1]]);
+    m_matchSignals[i1] = {com.referenceSignal(), com.matchSignal(), com.sharedSignal()};
+  }
+}
+
+//**********************************************************************
+
+const TpcSignalMatcher::MetricInfo* TpcSignalMatcher::metricInfo(Metric met) {
+  if ( met == UNDEFINEDMETRIC || Index(met) >= metrics().size() ) return nullptr;
+  return &metrics()[met];
+}
+
+//**********************************************************************
+
+TpcSignalMatcher::Metric TpcSignalMatcher::metric(string name) {
+  for ( Index imet=1; imet<metrics().size(); ++imet ) {
+    if ( metrics()[imet].name == name ) return Metric(imet);
+  }
+  return UNDEFINEDMETRIC;
 }
 
 //**********************************************************************
 
 Distance TpcSignalMatcher::distance() const {
-  if ( 1 ) return &binFractionDistance;
-  else return &channelFractionDistance;
+  const MetricInfo* pmet = metricInfo(m_metric);
+  if ( pmet == nullptr ) return nullptr;
+  return pmet->distance;
 }
 
 //**********************************************************************
@@ -195,6 +541,13 @@ float TpcSignalMatcher::matchDistance(Index iref) const {
 
 //**********************************************************************
 
+MatchSignals TpcSignalMatcher::matchSignals(Index iref) const {
+  if ( iref >= m_matchSignals.size() ) return {0.0, 0.0, 0.0};
+  return m_matchSignals[iref];
+}
+
+//**********************************************************************
+
 string TpcSignalMatcher::show(int opt) const {
   ostringstream ssout;
   int widx = 4;
@@ -4,14 +4,42 @@
 #define TpcSignalMatcher_H
 
 #include <vector>
+#include <string>
 #include <iosfwd>
 #include "DXUtil/TpcTypes.h"
 #include "TpcSignalMap.h"
 
+class TpcSignalMapComparison;
+
 // David Adams
 // May 2015
 //
 // Class to match entries in two vectors of TpcSignalMap objects.
+//
+// The match candidates for each ROP are indexed by their channel and tick
+// bounding boxes and the distance is only evaluated for candidates whose box
+// overlaps that of the reference. Other candidates share no bins with the
+// reference and so have the maximum distance. The results are the same as
+// those from evaluating the distance for every candidate.
+//
+// The distance metric is selected from those in a registry. Each metric declares
+// whether it uses the per-map summaries (see TpcSignalMap::buildSummaries) so
+// those are built once for each map before any distances are evaluated.
+// Metrics taken from a TpcSignalMapComparison also provide the distance for a
+// comparison so the signal sums from the same walk are kept for the matches.
+//
+// When matching by ROP, the references for each ROP form a shard and the shards
+// may be matched concurrently. The results do not depend on the number of threads.
+//
+// By default, each reference is matched to the nearest candidate and, when two
+// references share a candidate, the match for the smaller reference is marked
+// as a duplicate. In the optimal assignment mode, each candidate is matched to
+// at most one reference and the matches for each connected group of overlapping
+// references and candidates are chosen to minimize the summed distance, with
+// unmatched references contributing the maximum distance. There are then no
+// duplicates. The assignment is solved over only the pairs with less than the
+// maximum distance so its cost grows with the number of such pairs rather than
+// with the product of the reference and candidate counts.
 
 class TpcSignalMatcher {
 
@@ -27,6 +55,7 @@ public:
   typedef std::shared_ptr<T2> P2;
   typedef std::vector<P2> C2;
   typedef double (*Distance)(const T1&, const T2&);
+  typedef double (*ComparisonDistance)(const TpcSignalMapComparison&);
 
   enum Status {
     UNDEFINEDSTATUS = 0,
@@ -36,6 +65,42 @@ public:
   };
   typedef std::vector<Status> StatusVector;
 
+  enum Assignment {
+    GREEDY = 0,
+    OPTIMAL = 1
+  };
+
+  enum Metric {
+    UNDEFINEDMETRIC = 0,
+    BINFRACTION = 1,       // 1 - fraction of reference bins in the match
+    CHANNELFRACTION = 2,   // 1 - fraction of reference channels in the match
+    SIGNALFRACTION = 3,    // 1 - fraction of reference signal in bins in the match
+    TICKCENTROID = 4       // Difference in mean tick over the mean tick range
+  };
+
+  // Description of a distance metric.
+  struct MetricInfo {
+    std::string name;         // Name used to select the metric, e.g. BinFraction
+    Distance distance;        // Distance function
+    ComparisonDistance comparisonDistance;  // Distance from a comparison or null
+    bool useSummaries;        // Does the distance read the per-map summaries?
+    bool needTickOverlap;     // Do pairs without overlapping ticks have the maximum distance?
+  };
+
+  // Summed signals for a reference and its match (see TpcSignalMapComparison).
+  struct MatchSignals {
+    double reference;   // Reference signal in the TPCs shared with the match
+    double match;       // Match signal
+    double shared;      // Reference signal in bins included in the match
+  };
+  typedef std::vector<MatchSignals> MatchSignalsVector;
+
+  // Return the description of a metric. Null for an undefined metric.
+  static const MetricInfo* metricInfo(Metric met);
+
+  // Return the metric with a given name or UNDEFINEDMETRIC if there is none.
+  static Metric metric(std::string name);
+
 public:
 
   // Ctor.
@@ -43,7 +108,12 @@ public:
   //  cm - match collection
   //  matchByRop - If true, only objects with the same ROP are matched. If so,
   //               all objects must have an assigned ROP.
-  TpcSignalMatcher(const C1& cr, const C2& cm, bool matchByRop, int dbg =0);
+  //  amode - GREEDY for nearest candidate, OPTIMAL for the global assignment
+  //  met - distance metric
+  //  nthread - maximum number of threads used to match the ROP shards
+  TpcSignalMatcher(const C1& cr, const C2& cm, bool matchByRop, int dbg =0,
+                   Assignment amode =GREEDY, Metric met =BINFRACTION,
+                   unsigned int nthread =1);
 
   // Vector of reference objects.
   const C1& referenceVector() const { return m_cr; }
@@ -52,11 +122,18 @@ public:
   const C2& matchVector() const { return m_cm; }
 
   // Distance metric.
+  Metric metric() const { return m_metric; }
   Distance distance() const;
 
   // Maximum allowed distance.
   double maxDistance() const;
 
+  // Number of reference-candidate pairs for which the distance was evaluated.
+  unsigned int distanceCount() const { return m_ndistance; }
+
+  // Assignment mode.
+  Assignment assignment() const { return m_amode; }
+
   // # of entries (ref-match pairs)
   unsigned int size() const;
 
@@ -66,6 +143,11 @@ public:
   Index matchIndex(Index iref) const;
   float matchDistance(Index iref) const;
 
+  // Summed signals for each ref index and its match, including duplicate matches.
+  // These are kept from the distance evaluation when the metric compares the maps
+  // and are otherwise evaluated once for each match. All zero if there is no match.
+  MatchSignals matchSignals(Index iref) const;
+
   // Return a string describing the match.
   //   opt = 0: Index pairs
   std::string show(int opt =0) const;
@@ -75,11 +157,30 @@ public:
 
 private:
 
+  // Reference-candidate pair with distance less than the maximum.
+  struct Edge {
+    Index i1;
+    Index i2;
+    double dis;
+    MatchSignals sigs;
+  };
+  typedef std::vector<Edge> EdgeVector;
+
+  // Replace the nearest-candidate matches with the optimal assignment.
+  void assignOptimal(const EdgeVector& edges, int dbg);
+
+  // Evaluate the signal sums for the matches when the metric does not provide them.
+  void evaluateMatchSignals();
+
   const C1& m_cr;
   const C2& m_cm;
   StatusVector m_matchStatus;
   IndexVector m_matchIndex;
   FloatVector m_matchDistance;
+  MatchSignalsVector m_matchSignals;
+  unsigned int m_ndistance;
+  Assignment m_amode;
+  Metric m_metric;
 
 };
 
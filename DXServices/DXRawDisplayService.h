@@ -32,6 +32,10 @@
 //   DoChannelStatus - Create channel status histograms.
 //   MaxEventsLog - Maximum # of events (calls to process) to log.
 //   MaxDigitsLog - Maximum # of digits (calls to process) to log.
+//   NThread      - Number of threads used to process the digits (default 1). Each ROP
+//                  is processed in one thread. One thread is used if NChanPerBin > 1 and
+//                  a full-detector channel-tick histogram is made or if DoZSROPs is set,
+//                  because the signal finding service may not be thread safe.
 
 #ifndef DXRawDisplayService_H
 #define DXRawDisplayService_H
@@ -83,7 +87,7 @@ private:
                        unsigned int wbin, unsigned int went) const;
 
   // Delete event histograms after writing them to the output file.
-  // This saves a lot of memory.
+  // This saves a lot of memory. Histograms with no entries are not written.
   void removeEventHists() const;
 
 private:
@@ -108,6 +112,7 @@ private:
   bool m_SkipStuckBits;
   unsigned int m_MaxEventsLog;
   unsigned int m_MaxDigitsLog;
+  unsigned int m_NThread;
 
   GeoHelper* m_pgh;
 
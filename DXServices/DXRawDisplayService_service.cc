@@ -17,6 +17,8 @@
 
 #include <sstream>
 #include <iomanip>
+#include <atomic>
+#include <thread>
 
 #include "lardataobj/RawData/RawDigit.h"
 #include "lardataobj/RawData/raw.h"
@@ -43,6 +45,8 @@
 
 // Local includes.
 #include "DXUtil/ChannelTickHistCreator.h"
+#include "DXUtil/ChannelTickHistFiller.h"
+#include "DXUtil/RunningStats.h"
 #include "DXGeometry/GeoHelper.h"
 
 using std::string;
@@ -57,18 +61,6 @@ using raw::RawDigit;
 
 //************************************************************************
 
-namespace {
-
-void fill2dhist(TH2* ph, double x, double y, double val, double err =-1.0) {
-  int ibin = ph->FindBin(x, y);
-  ph->SetBinContent(ibin, val);
-  if ( err > 0.0 ) ph->SetBinError(ibin, err);
-}
-
-}  // end unnamed namespace
-
-//************************************************************************
-
 DXRawDisplayService::DXRawDisplayService(const fhicl::ParameterSet& pset)
 : m_LogLevel(1), m_NEventsProcessed(0), m_NDigitsProcessed(0) {
   const string myname = "DXRawDisplayService::ctor: ";
@@ -93,6 +85,8 @@ DXRawDisplayService::DXRawDisplayService(const fhicl::ParameterSet& pset)
   m_SkipStuckBits          = pset.get<bool>("SkipStuckBits");
   m_MaxEventsLog           = pset.get<int>("MaxEventsLog");
   m_MaxDigitsLog           = pset.get<int>("MaxDigitsLog");
+  m_NThread                = 1;
+  pset.get_if_present<unsigned int>("NThread", m_NThread);
   art::ServiceHandle<geo::Geometry> geosvc;       // pointer to Geometry service
   m_pgh = new GeoHelper(&*geosvc, true, 0);
   if ( m_LogLevel > 0 ) cout << myname << "Fetched geometry helper." << endl;
@@ -117,6 +111,7 @@ DXRawDisplayService::DXRawDisplayService(const fhicl::ParameterSet& pset)
     cout << myname << "           SkipStuckBits: " << m_SkipStuckBits << endl;
     cout << myname << "            MaxEventsLog: " << m_MaxEventsLog << endl;
     cout << myname << "            MaxDigitsLog: " << m_MaxDigitsLog << endl;
+    cout << myname << "                 NThread: " << m_NThread << endl;
   }
 }
 
@@ -215,23 +210,24 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
   int nchan = m_pgh->geometry()->Nchannels();
 
   // Create histograms.
-  vector<TH2*> rophists_sig;
+  // The ROP channel-tick histograms are booked here and created after the digits
+  // are grouped by ROP so that they are only made for ROPs with digits.
+  vector<ChannelTickHist> ropbooks_sig;
   vector<TH1*> pedhists;
   vector<TH1*> badhists;
-  vector<TH2*> rophists_zs;
+  vector<ChannelTickHist> ropbooks_zs;
   if ( dbg > 2 ) cout << myname << "Creating raw data histograms." << endl;
   if ( m_DoROPs ) {
     string proclab = "Raw";
     for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-      TH2* ph = hcreateRop.create("raw" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                  proclab + " signals for " + geohelp.ropName(irop));
-      if ( dbg > 3 ) cout << myname << "  " << ph->GetName() << endl;
-      rophists_sig.push_back(ph);
-      m_eventhists.push_back(ph);
+      ChannelTickHist hist = hcreateRop.book("raw" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                             proclab + " signals for " + geohelp.ropName(irop));
+      if ( dbg > 3 ) cout << myname << "  " << hist.name() << endl;
+      ropbooks_sig.push_back(hist);
       // Pedestal hists.
-      string hpedname = string(ph->GetName()) + "_ped";
-      string hpedtitl = "Pedestals for " + string(ph->GetTitle());
-      unsigned int nchan = ph->GetNbinsY();
+      string hpedname = hist.name() + "_ped";
+      string hpedtitl = "Pedestals for " + hist.title();
+      unsigned int nchan = hist.nchan();
       TH1* phped = tfsdir.make<TH1F>(hpedname.c_str(), hpedtitl.c_str(), nchan, 0, nchan);
       phped->GetXaxis()->SetTitle("Channel");
       phped->GetYaxis()->SetTitle("Pedestal [ADC counts]");
@@ -239,8 +235,8 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
       m_eventhists.push_back(phped);
       // Bad channel hists.
       if ( m_DoChannelStatus ) {
-        string hbadname = string(ph->GetName()) + "_badchan";
-        string hbadtitl = "Channel status for " + string(ph->GetTitle());
+        string hbadname = hist.name() + "_badchan";
+        string hbadtitl = "Channel status for " + hist.title();
         TH1* phbad = tfsdir.make<TH1F>(hbadname.c_str(), hbadtitl.c_str(), nchan, 0, nchan);
         phbad->GetXaxis()->SetTitle("Channel");
         phbad->GetYaxis()->SetTitle("Status (-1=missing, 0=ok, 1=bad, 2=noisy)");
@@ -254,11 +250,10 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
   }
   if ( m_DoZSROPs ) {
     for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-      TH2* ph = hcreateRop.create("rzs" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                      "Zero-suppressed raw signals for " + geohelp.ropName(irop));
-      if ( dbg > 3 ) cout << myname << "  " << ph->GetName() << endl;
-      rophists_zs.push_back(ph);
-      m_eventhists.push_back(ph);
+      ChannelTickHist hist = hcreateRop.book("rzs" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                             "Zero-suppressed raw signals for " + geohelp.ropName(irop));
+      if ( dbg > 3 ) cout << myname << "  " << hist.name() << endl;
+      ropbooks_zs.push_back(hist);
     }
   }
   TH2* phalladc = nullptr;
@@ -301,20 +296,18 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
     phmean = tfsdir.make<TH1F>(hname.c_str(), htitle.c_str(), nchan, 0, nchan);
     m_eventhists.push_back(phmean);
   }
-  vector<TH2*> rophists_mean;
-  vector<TH2*> rophists_rms;
+  vector<ChannelTickHist> ropbooks_mean;
+  vector<ChannelTickHist> ropbooks_rms;
   if ( m_NchanMeanRms ) {
     for ( unsigned int irop=0; irop<geohelp.nrop(); ++irop ) {
-      TH2* ph = hcreateRopMr.create("rawmean" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                    "Raw signal mean for " + geohelp.ropName(irop));
-      rophists_mean.push_back(ph);
-      m_eventhists.push_back(ph);
-      if ( dbg > 3 ) cout << myname << "  " << ph->GetName() << endl;
-      ph = hcreateRopMr.create("rawrms" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
-                                    "Raw signal RMS for " + geohelp.ropName(irop));
-      rophists_rms.push_back(ph);
-      m_eventhists.push_back(ph);
-      if ( dbg > 3 ) cout << myname << "  " << ph->GetName() << endl;
+      ChannelTickHist hist = hcreateRopMr.book("rawmean" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                                               "Raw signal mean for " + geohelp.ropName(irop));
+      ropbooks_mean.push_back(hist);
+      if ( dbg > 3 ) cout << myname << "  " << hist.name() << endl;
+      hist = hcreateRopMr.book("rawrms" + geohelp.ropName(irop), 0, geohelp.ropNChannel(irop),
+                               "Raw signal RMS for " + geohelp.ropName(irop));
+      ropbooks_rms.push_back(hist);
+      if ( dbg > 3 ) cout << myname << "  " << hist.name() << endl;
     }
   }
 
@@ -324,27 +317,20 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
     psfs = &*art::ServiceHandle<AdcSignalFindingService>();
   }
 
-  // Loop over digits.
-  // Digit information is only logged for dbg >= 5.
-  unsigned int idig = 0;
+  // Index the digits, skip bad channels and group the digits by ROP.
+  // The last group holds digits for channels that are not in any ROP.
+  // The channel status is also found here because the provider may not be thread safe.
   // Flags that record how the digits are ordered.
   bool isOnlineOrdered = true;
   bool isOfflineOrdered = true;
-  if ( dbg > 4 ) cout << myname << "Looping over digits." << endl;
+  vector<const AdcChannelDataMap::value_type*> chprepdigs;
+  vector<unsigned int> chanons;
+  vector<int> chanstats;    // 1 for bad plus 2 for noisy if DoChannelStatus is set.
+  vector<vector<unsigned int>> digsByRop(geohelp.nrop() + 1);
   for ( const AdcChannelDataMap::value_type& chprepdig : prepdigs ) {
     ++m_NDigitsProcessed;
-    // Extract and check prep data.
-    AdcChannel ichan        =  chprepdig.first;
-    const AdcChannelData& prepdig = chprepdig.second;
-    const AdcCountVector& adcs =  prepdig.raw;
-    const AdcSignalVector& sigs =  prepdig.samples;
-    const AdcFlagVector& flags  =  prepdig.flags;
-    AdcSignal pedestal = prepdig.pedestal;
-    const raw::RawDigit& digit  = *prepdig.digit;
-    unsigned int nsig = digit.Samples();
-    if ( sigs.size() != nsig || flags.size() != nsig ) {
-      cout << myname << "ERROR: Inconsistent array sizes in prep data." << endl;
-    }
+    AdcChannel ichan = chprepdig.first;
+    unsigned int idig = chprepdigs.size();
     // Determine if data is online or offline ordered.
     unsigned int ichanon = ichan;
     if ( pchanmap != nullptr ) {
@@ -359,129 +345,269 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
         continue;
       }
     }
-    if ( dbg > 5 ) cout << myname << "          Channel: " << ichan << endl;
-    // Find the ROP.
     unsigned int irop = geohelp.channelRop(ichan);
-    if ( dbg > 5 ) cout << myname << "              ROP: " << irop << endl;
-    unsigned int iropchan = ichan - geohelp.ropFirstChannel(irop);
-    if ( dbg > 5 ) cout << myname << "      ROP channel: " << iropchan << endl;
-    // Set the ROP histogram pointers.
-    TH2* phrop = nullptr;
-    TH1* phped = nullptr;
-    TH2* phzs = nullptr;
-    TH2* ph_mean = nullptr;
-    TH2* ph_rms = nullptr;
-    TH1* phbad = nullptr;
-    if ( rophists_sig.size() > irop ) phrop = rophists_sig[irop];
-    if ( pedhists.size() > irop ) phped = pedhists[irop];
-    if ( badhists.size() > irop ) phbad = badhists[irop];
+    if ( irop >= geohelp.nrop() ) irop = geohelp.nrop();
+    digsByRop[irop].push_back(idig);
+    chprepdigs.push_back(&chprepdig);
+    chanons.push_back(ichanon);
     if ( m_DoChannelStatus ) {
       int val = 0;
       if ( pcsp->IsBad(ichan)   ) val += 1;
       if ( pcsp->IsNoisy(ichan) ) val += 2;
-      phbad->SetBinContent(iropchan+1, val);
+      chanstats.push_back(val);
     }
-    if ( rophists_zs.size() > irop ) phzs = rophists_zs[irop];
-    if ( rophists_mean.size() > irop ) ph_mean = rophists_mean[irop];
-    if ( rophists_rms.size() > irop ) ph_rms = rophists_rms[irop];
-    if ( dbg >= 5 ) {
-      cout << myname << "ROP hists for channel " << ichan << ":";
-      if ( phrop != nullptr ) cout << " " << phrop->GetName();
-      if ( ph_mean != nullptr ) cout << " " << ph_mean->GetName();
-      if ( ph_rms != nullptr ) cout << " " << ph_rms->GetName();
-      cout << endl;
+  }
+  unsigned int ndig = chprepdigs.size();
+
+  // Create the booked ROP histograms for the ROPs with digits.
+  // The histograms for other ROPs are null.
+  auto createRopHists = [&](vector<ChannelTickHist>& books) {
+    vector<TH2*> hists(books.size(), nullptr);
+    for ( unsigned int irop=0; irop<books.size(); ++irop ) {
+      if ( digsByRop[irop].empty() ) continue;
+      TH2* ph = books[irop].hist();
+      if ( ph == nullptr ) continue;
+      hists[irop] = ph;
+      m_eventhists.push_back(ph);
     }
-    if ( phped != nullptr ) phped->SetBinContent(iropchan+1, pedestal);
-    // If requested, apply zero suppression.
-    // This requires making temporary channel data.
-    const AdcChannelData* pprepdig = &prepdig;
-    AdcChannelData* pprepdigtmp = nullptr;
-    if ( psfs != nullptr ) {
-      pprepdigtmp = new AdcChannelData;
-      pprepdigtmp->channel = prepdig.channel;
-      pprepdigtmp->samples = prepdig.samples;
-      psfs->find(*pprepdigtmp);
-      pprepdig = pprepdigtmp;
+    return hists;
+  };
+  vector<TH2*> rophists_sig = createRopHists(ropbooks_sig);
+  vector<TH2*> rophists_zs = createRopHists(ropbooks_zs);
+  vector<TH2*> rophists_mean = createRopHists(ropbooks_mean);
+  vector<TH2*> rophists_rms = createRopHists(ropbooks_rms);
+
+  // Find the number of threads.
+  // Each ROP is processed in one thread so the ROP histograms are filled as in a single
+  // thread. Rows of the full-detector histograms hold more than one channel if NChanPerBin
+  // is above one and so those histograms are then filled in a single thread. The signal
+  // finding service is also only called from a single thread.
+  unsigned int ngrp = 0;
+  for ( const vector<unsigned int>& digs : digsByRop ) if ( digs.size() ) ++ngrp;
+  unsigned int nthr = m_NThread;
+  if ( m_NChanPerBin > 1 && (phalladc != nullptr || phallraw != nullptr || phallrawon != nullptr) ) {
+    if ( dbg > 1 && nthr > 1 ) cout << myname << "Using one thread because full-detector rows are shared." << endl;
+    nthr = 1;
+  }
+  if ( psfs != nullptr ) {
+    if ( dbg > 1 && nthr > 1 ) cout << myname << "Using one thread because the signal finder may not be thread safe." << endl;
+    nthr = 1;
+  }
+  if ( nthr > ngrp ) nthr = ngrp;
+  if ( nthr < 1 ) nthr = 1;
+  // Digit information is only logged for dbg >= 5 and one thread.
+  int digdbg = nthr > 1 ? 0 : dbg;
+
+  // Create the fillers for the channel-tick histograms.
+  // Each ROP histogram is filled in one thread. Each thread has its own fillers for the
+  // full-detector histograms. The error arrays for those are created before they are
+  // filled from several threads and are removed afterwards if nothing is filled.
+  vector<ChannelTickHistFiller> ropfills_sig;
+  vector<ChannelTickHistFiller> ropfills_zs;
+  for ( TH2* ph : rophists_sig ) ropfills_sig.emplace_back(ph);
+  for ( TH2* ph : rophists_zs ) ropfills_zs.emplace_back(ph);
+  vector<TH2*> reservedErrorHists;
+  if ( nthr > 1 ) {
+    for ( TH2* ph : {phallraw, phallrawon} ) {
+      if ( ph != nullptr && ph->GetSumw2N() == 0 ) {
+        ph->Sumw2();
+        reservedErrorHists.push_back(ph);
+      }
     }
-    // Loop over ticks.
-    int icnt = 0;
-    double tsum = 0.0;
-    double tsumsq = 0.0;
-    double tsum_bin = 0;
-    double tsumsq_bin = 0.0;
-    unsigned int ibin = 0;
-    unsigned int ntick_bin = 0;
-    unsigned int ntick_bin_nominal = 0;
-    for ( unsigned int tick=0; tick<nsig; ++tick ) {
-      double adc = adcs[tick];
-      double wt = sigs[tick];
-      double wtzs = m_DoZSROPs ? pprepdig->signal[tick]*wt : 0.0;
-      ++icnt;
-      tsum += wt;
-      tsumsq += wt*wt;
-      ++ntick_bin_nominal;
-      if ( wt != 0 ) {
-        if ( phallflag != nullptr )  fill2dhist(phallflag, tick, ichan, flags[tick]);
-        bool isSticky = flags[tick] == AdcStuckOn || flags[tick] == AdcStuckOff;
-        if ( !isSticky || !m_SkipStuckBits )  {
-          bool isFixed = flags[tick] == AdcSetFixed;
-          bool isInterpolated = flags[tick] == AdcInterpolated;
-          bool isExtrapolated = flags[tick] == AdcExtrapolated;
-          double err = 0.5;
-          if ( isSticky ) err = 32.0;
-          if ( isFixed ) err = 100.0;
-          if ( isInterpolated ) err = 2.0;
-          if ( isExtrapolated ) err = 5.0;
-          if ( phrop != nullptr ) fill2dhist(phrop, tick, iropchan, wt, err);
-          if ( phzs != nullptr ) fill2dhist(phzs, tick, iropchan, wtzs, err);
-          double allwt = wt;
-          if ( fAbsAll ) allwt = fabs(allwt);
-          if ( phalladc != nullptr )   fill2dhist(phalladc, tick, ichan, adc, 0.0);
-          if ( phallraw != nullptr )   fill2dhist(phallraw, tick, ichan, allwt, err);
-          if ( phallrawon != nullptr ) fill2dhist(phallrawon, tick, ichanon, allwt, err);
-          tsum_bin += wt;
-          tsumsq_bin += wt*wt;
-          ++ntick_bin;
-        }
+  }
+  struct AllFillers {
+    ChannelTickHistFiller adc;
+    ChannelTickHistFiller raw;
+    ChannelTickHistFiller rawon;
+    ChannelTickHistFiller flag;
+  };
+  vector<AllFillers> allfills;
+  for ( unsigned int ithr=0; ithr<nthr; ++ithr ) {
+    allfills.push_back({ChannelTickHistFiller(phalladc), ChannelTickHistFiller(phallraw),
+                        ChannelTickHistFiller(phallrawon), ChannelTickHistFiller(phallflag)});
+  }
+
+  // Channel mean and RMS for each digit.
+  vector<double> chanmeans(ndig, 0.0);
+  vector<double> chanrmss(ndig, 0.0);
+  vector<char> havechanmeans(ndig, false);
+
+  // Scratch channel data for zero suppression, one for each thread.
+  // There is only one thread when zero suppression is used but the data
+  // is kept per thread so that processRop does not depend on that.
+  // It is reused for all channels so its vectors are allocated only for
+  // the first few channels.
+  vector<AdcChannelData> zsdatas(psfs == nullptr ? 0 : nthr);
+
+  // Flags for the ticks used in the mean and RMS windows, one vector for
+  // each thread.
+  vector<vector<char>> tickkeeps(nthr);
+
+  // Process the digits for a ROP in thread ithr.
+  auto processRop = [&](unsigned int irop, unsigned int ithr) {
+    AllFillers& fills = allfills[ithr];
+    for ( unsigned int idig : digsByRop[irop] ) {
+      // Extract and check prep data.
+      AdcChannel ichan        =  chprepdigs[idig]->first;
+      const AdcChannelData& prepdig = chprepdigs[idig]->second;
+      const AdcCountVector& adcs =  prepdig.raw;
+      const AdcSignalVector& sigs =  prepdig.samples;
+      const AdcFlagVector& flags  =  prepdig.flags;
+      AdcSignal pedestal = prepdig.pedestal;
+      const raw::RawDigit& digit  = *prepdig.digit;
+      unsigned int nsig = digit.Samples();
+      if ( sigs.size() != nsig || flags.size() != nsig ) {
+        cout << myname << "ERROR: Inconsistent array sizes in prep data." << endl;
+      }
+      unsigned int ichanon = chanons[idig];
+      if ( digdbg > 5 ) cout << myname << "          Channel: " << ichan << endl;
+      if ( digdbg > 5 ) cout << myname << "              ROP: " << irop << endl;
+      unsigned int iropchan = irop < geohelp.nrop() ? ichan - geohelp.ropFirstChannel(irop) : 0;
+      if ( digdbg > 5 ) cout << myname << "      ROP channel: " << iropchan << endl;
+      // Set the ROP histogram pointers.
+      TH2* phrop = nullptr;
+      TH1* phped = nullptr;
+      TH2* phzs = nullptr;
+      TH2* ph_mean = nullptr;
+      TH2* ph_rms = nullptr;
+      TH1* phbad = nullptr;
+      ChannelTickHistFiller* pfrop = nullptr;
+      ChannelTickHistFiller* pfzs = nullptr;
+      if ( rophists_sig.size() > irop ) {
+        phrop = rophists_sig[irop];
+        pfrop = &ropfills_sig[irop];
+        pfrop->setChannel(iropchan);
+      }
+      if ( pedhists.size() > irop ) phped = pedhists[irop];
+      if ( badhists.size() > irop ) phbad = badhists[irop];
+      if ( m_DoChannelStatus ) phbad->SetBinContent(iropchan+1, chanstats[idig]);
+      if ( rophists_zs.size() > irop ) {
+        phzs = rophists_zs[irop];
+        pfzs = &ropfills_zs[irop];
+        pfzs->setChannel(iropchan);
+      }
+      fills.adc.setChannel(ichan);
+      fills.raw.setChannel(ichan);
+      fills.rawon.setChannel(ichanon);
+      fills.flag.setChannel(ichan);
+      if ( rophists_mean.size() > irop ) ph_mean = rophists_mean[irop];
+      if ( rophists_rms.size() > irop ) ph_rms = rophists_rms[irop];
+      if ( digdbg >= 5 ) {
+        cout << myname << "ROP hists for channel " << ichan << ":";
+        if ( phrop != nullptr ) cout << " " << phrop->GetName();
+        if ( ph_mean != nullptr ) cout << " " << ph_mean->GetName();
+        if ( ph_rms != nullptr ) cout << " " << ph_rms->GetName();
+        cout << endl;
       }
-      if ( ph_mean != nullptr && ph_rms != nullptr &&
-           (ntick_bin_nominal == m_NchanMeanRms || tick==nsig-1) ) {
-        double mean = 0.0;
-        double rms = 0.0;
-        if ( ntick_bin > 0 ) {
-          mean = tsum_bin/ntick_bin;
-          rms = sqrt(tsumsq_bin/ntick_bin);
+      if ( phped != nullptr ) phped->SetBinContent(iropchan+1, pedestal);
+      // If requested, apply zero suppression.
+      // The signal finder is run on this thread's scratch channel data so
+      // the input data is not modified.
+      const AdcChannelData* pprepdig = &prepdig;
+      if ( psfs != nullptr ) {
+        AdcChannelData& zsdata = zsdatas[ithr];
+        zsdata.channel = prepdig.channel;
+        zsdata.samples.assign(prepdig.samples.begin(), prepdig.samples.end());
+        zsdata.signal.clear();
+        psfs->find(zsdata);
+        pprepdig = &zsdata;
+      }
+      // Loop over ticks.
+      vector<char>& keeps = tickkeeps[ithr];
+      keeps.assign(nsig, 0);
+      for ( unsigned int tick=0; tick<nsig; ++tick ) {
+        double adc = adcs[tick];
+        double wt = sigs[tick];
+        double wtzs = m_DoZSROPs ? pprepdig->signal[tick]*wt : 0.0;
+        if ( wt != 0 ) {
+          if ( phallflag != nullptr )  fills.flag.fill(tick, flags[tick]);
+          bool isSticky = flags[tick] == AdcStuckOn || flags[tick] == AdcStuckOff;
+          if ( !isSticky || !m_SkipStuckBits )  {
+            bool isFixed = flags[tick] == AdcSetFixed;
+            bool isInterpolated = flags[tick] == AdcInterpolated;
+            bool isExtrapolated = flags[tick] == AdcExtrapolated;
+            double err = 0.5;
+            if ( isSticky ) err = 32.0;
+            if ( isFixed ) err = 100.0;
+            if ( isInterpolated ) err = 2.0;
+            if ( isExtrapolated ) err = 5.0;
+            if ( phrop != nullptr ) pfrop->fill(tick, wt, err);
+            if ( phzs != nullptr ) pfzs->fill(tick, wtzs, err);
+            double allwt = wt;
+            if ( fAbsAll ) allwt = fabs(allwt);
+            if ( phalladc != nullptr )   fills.adc.fill(tick, adc, 0.0);
+            if ( phallraw != nullptr )   fills.raw.fill(tick, allwt, err);
+            if ( phallrawon != nullptr ) fills.rawon.fill(tick, allwt, err);
+            keeps[tick] = 1;
+          }
         }
-        ph_mean->SetBinContent(ibin+1, iropchan+1, mean);
-        ph_rms->SetBinContent(ibin+1, iropchan+1, rms);
-        if ( dbg >= 5 ) {
-          cout << myname << "Mean[" << ibin << ", " << iropchan << "] = " << mean << endl;
-          cout << myname << " Rms[" << ibin << ", " << iropchan << "] = " << rms << endl;
+      }  // end loop over ticks
+      // Mean and RMS (about zero) of the kept ticks in each window.
+      if ( ph_mean != nullptr && ph_rms != nullptr && nsig > 0 ) {
+        unsigned int nwin = m_NchanMeanRms > 0 ? m_NchanMeanRms : nsig;
+        unsigned int ibin = 0;
+        for ( unsigned int tick1=0; tick1<nsig; tick1+=nwin, ++ibin ) {
+          unsigned int ntick = nsig - tick1 < nwin ? nsig - tick1 : nwin;
+          RunningStats winstats;
+          winstats.add(&sigs[tick1], &keeps[tick1], ntick);
+          double mean = winstats.mean();
+          double rms = winstats.rms();
+          ph_mean->SetBinContent(ibin+1, iropchan+1, mean);
+          ph_rms->SetBinContent(ibin+1, iropchan+1, rms);
+          if ( digdbg >= 5 ) {
+            cout << myname << "Mean[" << ibin << ", " << iropchan << "] = " << mean << endl;
+            cout << myname << " Rms[" << ibin << ", " << iropchan << "] = " << rms << endl;
+          }
         }
-        tsum_bin = 0.0;
-        tsumsq_bin = 0.0;
-        ++ibin;
-        ntick_bin = 0;
-        ntick_bin_nominal = 0;
       }
-    }  // end loop over ticks
-    delete pprepdigtmp;
-    // Channel stats.
-    double tcnt = icnt;
-    double mean = -1.e6;
-    double rms = 0.0;
-    if ( tcnt > 0.0 ) {
-      mean = tsum/tcnt;
-      double rmssq = tsumsq/tcnt - mean*mean;
-      if ( rmssq > 0.0 ) rms = sqrt(rmssq);
-      if ( phmean != nullptr ) {
-        phmean->SetBinContent(ichan+1, mean);
-        phmean->SetBinError(ichan+1, rms);
+      // Channel stats.
+      if ( nsig > 0 ) {
+        RunningStats chanstats;
+        chanstats.add(&sigs[0], nsig);
+        double mean = chanstats.mean();
+        double rms = chanstats.sdev();
+        chanmeans[idig] = mean;
+        chanrmss[idig] = rms;
+        havechanmeans[idig] = true;
+        if ( digdbg > 4 ) cout << myname << "Digit channel " << ichan << " Mean, RMS: " << mean << " +/- " << rms << endl;
       }
-      if ( dbg > 4 ) cout << myname << "Digit channel " << ichan << " Mean, RMS: " << mean << " +/- " << rms << endl;
+    }  // end loop over digits
+  };
+  if ( dbg > 4 ) cout << myname << "Looping over digits." << endl;
+  if ( nthr > 1 ) {
+    if ( dbg > 1 ) cout << myname << "Processing " << ngrp << " ROPs with " << nthr << " threads." << endl;
+    std::atomic<unsigned int> nextRop(0);
+    auto work = [&](unsigned int ithr) {
+      for ( unsigned int irop=nextRop++; irop<digsByRop.size(); irop=nextRop++ ) processRop(irop, ithr);
+    };
+    vector<std::thread> threads;
+    for ( unsigned int ithr=1; ithr<nthr; ++ithr ) threads.emplace_back(work, ithr);
+    work(0);
+    for ( std::thread& thr : threads ) thr.join();
+  } else {
+    for ( unsigned int irop=0; irop<digsByRop.size(); ++irop ) processRop(irop, 0);
+  }
+  // Record the channel means in digit order.
+  if ( phmean != nullptr ) {
+    for ( unsigned int idig=0; idig<ndig; ++idig ) {
+      if ( ! havechanmeans[idig] ) continue;
+      AdcChannel ichan = chprepdigs[idig]->first;
+      phmean->SetBinContent(ichan+1, chanmeans[idig]);
+      phmean->SetBinError(ichan+1, chanrmss[idig]);
     }
-    ++idig;
-  }  // end loop over digits.
+  }
+  // Update the entry counts for the channel-tick histograms.
+  for ( ChannelTickHistFiller& fill : ropfills_sig ) fill.flush();
+  for ( ChannelTickHistFiller& fill : ropfills_zs ) fill.flush();
+  for ( AllFillers& fills : allfills ) {
+    fills.adc.flush();
+    fills.raw.flush();
+    fills.rawon.flush();
+    fills.flag.flush();
+  }
+  for ( TH2* ph : reservedErrorHists ) {
+    if ( ph->GetEntries() == 0 ) ph->Sumw2(false);
+  }
 
   if ( dbg > 4 ) cout << myname << "----------" << endl;
   if ( dbg > 2 && pchanmap != nullptr ) {
@@ -494,16 +620,16 @@ int DXRawDisplayService::process(const AdcChannelDataMap& prepdigs, const art::E
   if ( dbg >= 2 ) {
     cout << myname << "Summary of raw data histograms:" << endl;
     for ( TH2* ph : rophists_sig ) {
-      summarize2dHist(ph, myname, wnam, 4, 7);
+      if ( ph != nullptr ) summarize2dHist(ph, myname, wnam, 4, 7);
     }
     for ( TH2* ph : rophists_zs ) {
-      summarize2dHist(ph, myname, wnam, 4, 7);
+      if ( ph != nullptr ) summarize2dHist(ph, myname, wnam, 4, 7);
     }
     for ( TH2* ph : rophists_mean ) {
-      summarize2dHist(ph, myname, wnam, 4, 7);
+      if ( ph != nullptr ) summarize2dHist(ph, myname, wnam, 4, 7);
     }
     for ( TH2* ph : rophists_rms ) {
-      summarize2dHist(ph, myname, wnam, 4, 7);
+      if ( ph != nullptr ) summarize2dHist(ph, myname, wnam, 4, 7);
     }
     if ( phallraw != nullptr ) summarize2dHist(phallraw, myname, wnam, 4, 7);
     if ( phallrawon != nullptr ) summarize2dHist(phallrawon, myname, wnam, 4, 7);
@@ -561,7 +687,8 @@ void DXRawDisplayService::removeEventHists() const {
   if ( dbg >= 3 ) cout << myname << "Deleting events hists, count = " << m_eventhists.size() << endl;
   for ( TH1* ph : m_eventhists ) {
     if ( dbg >= 4 ) cout << myname << "Removing " << ph->GetName() << endl;
-    ph->Write();
+    // Histograms that were never filled are not written.
+    if ( ph->GetEntries() > 0 ) ph->Write();
     ph->SetDirectory(0);
     delete ph;
   }
@@ -0,0 +1,61 @@
+// ChannelTickHist.cxx
+
+#include "ChannelTickHist.h"
+#include <iostream>
+#include "art/Framework/Services/Optional/TFileDirectory.h"
+#include "TH2.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using art::TFileDirectory;
+
+//**********************************************************************
+
+ChannelTickHist::ChannelTickHist() { }
+
+//**********************************************************************
+
+ChannelTickHist::
+ChannelTickHist(TFileDirectory& tfs, string name, string title,
+                int ntick, int tick1, int tick2, int nchan, int chan1, int chan2,
+                double zmin, double zmax, int ncontour)
+: m_pstate(new State{&tfs, name, title, ntick, tick1, tick2, nchan, chan1, chan2,
+                     zmin, zmax, ncontour, nullptr}) { }
+
+//**********************************************************************
+
+TH2* ChannelTickHist::hist() {
+  const string myname = "ChannelTickHist::hist: ";
+  if ( m_pstate == nullptr ) return nullptr;
+  State& sta = *m_pstate;
+  if ( sta.ph != nullptr || sta.ptfs == nullptr ) return sta.ph;
+  sta.ph = sta.ptfs->make<TH2F>(sta.name.c_str(), sta.title.c_str(),
+                                sta.ntick, sta.tick1, sta.tick2, sta.nchan, sta.chan1, sta.chan2);
+  if ( sta.ph == nullptr ) {
+    cout << myname << "Unable to create histogram " << sta.name << endl;
+    // Do not try again.
+    sta.ptfs = nullptr;
+  } else {
+    sta.ph->GetZaxis()->SetRangeUser(sta.zmin, sta.zmax);
+    sta.ph->SetContour(sta.ncontour);
+    sta.ph->SetStats(0);
+  }
+  return sta.ph;
+}
+
+//**********************************************************************
+
+const string& ChannelTickHist::name() const {
+  static const string empty;
+  return m_pstate == nullptr ? empty : m_pstate->name;
+}
+
+//**********************************************************************
+
+const string& ChannelTickHist::title() const {
+  static const string empty;
+  return m_pstate == nullptr ? empty : m_pstate->title;
+}
+
+//**********************************************************************
@@ -0,0 +1,81 @@
+// ChannelTickHist.h
+
+#ifndef ChannelTickHist_H
+#define ChannelTickHist_H
+
+// David Adams
+// October 2026
+//
+// Handle for a channel vs. tick histogram that is booked by ChannelTickHistCreator
+// but only created in its TFileDirectory when it is first requested.
+//
+// This avoids allocating full-size 2D histograms that are never filled,
+// e.g. those for ROPs with no signals in an event.
+//
+// A default-constructed handle is invalid and never creates a histogram.
+// Copies of a handle share the booking, so the histogram is created once and
+// all the copies return it.
+
+#include <string>
+#include <memory>
+
+class TH2;
+namespace art {
+class TFileDirectory;
+}
+
+class ChannelTickHist {
+
+public:
+
+  // Default ctor. The handle is invalid.
+  ChannelTickHist();
+
+  // Ctor from the directory and the histogram properties.
+  ChannelTickHist(art::TFileDirectory& tfs, std::string name, std::string title,
+                  int ntick, int tick1, int tick2, int nchan, int chan1, int chan2,
+                  double zmin, double zmax, int ncontour);
+
+  // Return if the histogram is booked.
+  bool isValid() const { return m_pstate != nullptr && m_pstate->ptfs != nullptr; }
+
+  // Return if the histogram has been created.
+  bool isCreated() const { return createdHist() != nullptr; }
+
+  // Return the histogram, creating it if it is booked and not yet created.
+  TH2* hist();
+
+  // Return the histogram if it has been created and null otherwise.
+  TH2* createdHist() const { return m_pstate == nullptr ? nullptr : m_pstate->ph; }
+
+  // Return the histogram name and title.
+  const std::string& name() const;
+  const std::string& title() const;
+
+  // Return the number of channel bins.
+  int nchan() const { return m_pstate == nullptr ? 0 : m_pstate->nchan; }
+
+private:
+
+  // Booking shared by the copies of a handle.
+  struct State {
+    art::TFileDirectory* ptfs;
+    std::string name;
+    std::string title;
+    int ntick;
+    int tick1;
+    int tick2;
+    int nchan;
+    int chan1;
+    int chan2;
+    double zmin;
+    double zmax;
+    int ncontour;
+    TH2* ph;
+  };
+
+  std::shared_ptr<State> m_pstate;
+
+};
+
+#endif
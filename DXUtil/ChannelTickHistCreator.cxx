@@ -3,8 +3,6 @@
 #include "ChannelTickHistCreator.h"
 #include <iostream>
 #include <sstream>
-#include "art/Framework/Services/Optional/TFileDirectory.h"
-#include "TH2.h"
 
 using std::string;
 using std::cout;
@@ -29,13 +27,12 @@ ChannelTickHistCreator(TFileDirectory& tfs, string sevt, int tick1, int tick2,
 
 //**********************************************************************
 
-TH2* ChannelTickHistCreator::
-create(string slab, unsigned int chan1, unsigned int chan2, string stitle,
-       string sevtNameSuffix, string sevtTitleSuffix, TickRange atickRange) const {
-  const string myname = "ChannelTickHistCreator::create: ";
+ChannelTickHist ChannelTickHistCreator::
+book(string slab, unsigned int chan1, unsigned int chan2, string stitle,
+     string sevtNameSuffix, string sevtTitleSuffix, TickRange atickRange) const {
+  const string myname = "ChannelTickHistCreator::book: ";
   const int dbg = 0;    // 0 for normal running
-  TH2* ph = nullptr;
-  if ( chan2 <= chan1 ) return nullptr;
+  if ( chan2 <= chan1 ) return ChannelTickHist();
   int nchan = chan2 - chan1;
   if ( m_nchanperbin > 1 ) nchan /= m_nchanperbin;
   if ( nchan < 1 ) nchan = 1;
@@ -61,7 +58,7 @@ create(string slab, unsigned int chan1, unsigned int chan2, string stitle,
     if ( dbg ) cout << myname << "X-axis: " << atick1 << "-" << atick2 << " ==> "
                     << tick1 << "-" << tick2 << endl;
     // Check if ther is no overlap between object and requested ranges.
-    if ( tick2 <= tick1 ) return nullptr;
+    if ( tick2 <= tick1 ) return ChannelTickHist();
   }
   unsigned int ntick = tick2 - tick1;
   if ( m_ntickperbin > 1 ) ntick /= m_ntickperbin;
@@ -74,20 +71,18 @@ create(string slab, unsigned int chan1, unsigned int chan2, string stitle,
   if ( m_nchanperbin > 1 ) sszlab << " /(" << m_nchanperbin << " channels)";
   if ( m_ntickperbin > 1 ) sszlab << " /(" << m_ntickperbin << " TDC ticks)";
   title += ";TDC tick;Channel;" + sszlab.str();
-  if ( dbg > 0 ) cout << myname << "Creating hit histo " << hname << " with " << ntick
+  if ( dbg > 0 ) cout << myname << "Booking hit histo " << hname << " with " << ntick
                       << " TDC bins and " << nchan << " channel bins" << endl;
-  if ( dbg > 1 ) cout << myname << "  Using TFileService." << endl;
-  ph = m_tfs.make<TH2F>(hname.c_str(), title.c_str(),
-                        ntick, tick1, tick2, nchan, chan1, chan2);
-  if ( ph == nullptr ) {
-    cout << myname << "Unable to create histogram " << hname << endl;
-  } else {
-    if ( dbg > 1 ) cout << myname << "  Created histogram " << ph->GetName() << endl;
-    ph->GetZaxis()->SetRangeUser(m_zmin, m_zmax);
-    ph->SetContour(m_ncontour);
-    ph->SetStats(0);
-  }
-  return ph;
+  return ChannelTickHist(m_tfs, hname, title, ntick, tick1, tick2, nchan, chan1, chan2,
+                         m_zmin, m_zmax, m_ncontour);
+}
+
+//**********************************************************************
+
+TH2* ChannelTickHistCreator::
+create(string slab, unsigned int chan1, unsigned int chan2, string stitle,
+       string sevtNameSuffix, string sevtTitleSuffix, TickRange atickRange) const {
+  return book(slab, chan1, chan2, stitle, sevtNameSuffix, sevtTitleSuffix, atickRange).hist();
 }
 
 //**********************************************************************
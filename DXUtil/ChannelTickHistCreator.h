@@ -7,9 +7,14 @@
 // May 2015
 //
 // Class to create channel vs. tick histograms.
+//
+// Histograms may be booked, i.e. returned as a ChannelTickHist handle
+// that creates the histogram when it is first requested, or created
+// immediately.
 
 #include <string>
 #include "DXUtil/Range.h"
+#include "DXUtil/ChannelTickHist.h"
 
 class TH2;
 namespace art {
@@ -38,13 +43,20 @@ public:  // methods
                          std::string zlab, double zmin, double zmax, int ncontour,
                          unsigned int ntickperbin =1, unsigned int nchanperbin = 1);
 
-  // Create a histogram for a given channel range.
+  // Book a histogram for a given channel range.
   //   slab = Unique label, e.g. "hitapa2v" or "rawall"
   //   chan1, chan2 = y-axis range
   //   stitle Unique prefix for histogram title, e.g. "Hits for APA plane 2u"
   //   sevtNameSuffix = field appended to event ID in histogram name, e.g. "trk123"
   //   sevtTitleSuffix = field appended to event ID in histogram title, e.g. "track 123"
   //   tickRange - used to define range of x-axis iff range has at least one tick
+  // The returned handle is invalid if the channel or tick range is empty.
+  ChannelTickHist book(std::string slab, unsigned int chan1, unsigned int chan2, std::string stitle,
+                       std::string sevtNameSuffix ="", std::string sevtTitleSuffix ="",
+                       TickRange tickRange =TickRange(0,-1)) const;
+
+  // Create a histogram for a given channel range.
+  // Same as book(...).hist(). Returns null if the booking is invalid.
   TH2* create(std::string slab, unsigned int chan1, unsigned int chan2, std::string stitle,
               std::string sevtNameSuffix ="", std::string sevtTitleSuffix ="",
               TickRange tickRange =TickRange(0,-1)) const;
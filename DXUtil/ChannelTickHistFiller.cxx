@@ -0,0 +1,75 @@
+// ChannelTickHistFiller.cxx
+
+#include "ChannelTickHistFiller.h"
+#include "TH2.h"
+
+typedef ChannelTickHistFiller::Tick Tick;
+
+//**********************************************************************
+
+ChannelTickHistFiller::ChannelTickHistFiller(TH2* ph)
+: m_ph(ph), m_pfcon(nullptr), m_pdcon(nullptr), m_perr(nullptr),
+  m_nxcell(0), m_rowbin(0), m_nfill(0) {
+  if ( m_ph == nullptr ) return;
+  TH2F* phf = dynamic_cast<TH2F*>(m_ph);
+  TH2D* phd = dynamic_cast<TH2D*>(m_ph);
+  if ( phf != nullptr ) m_pfcon = phf->GetArray();
+  if ( phd != nullptr ) m_pdcon = phd->GetArray();
+  if ( m_ph->GetSumw2N() ) m_perr = m_ph->GetSumw2()->GetArray();
+  m_nxcell = m_ph->GetNbinsX() + 2;
+}
+
+//**********************************************************************
+
+void ChannelTickHistFiller::setChannel(double chan) {
+  if ( m_ph == nullptr ) return;
+  m_rowbin = m_nxcell*m_ph->GetYaxis()->FindBin(chan);
+}
+
+//**********************************************************************
+
+void ChannelTickHistFiller::fill(Tick tick, double val, double err) {
+  if ( m_ph == nullptr ) return;
+  int ibin = m_rowbin + xbin(tick);
+  // Use the histogram methods if this is not a TH2F or TH2D.
+  if ( m_pfcon == nullptr && m_pdcon == nullptr ) {
+    m_ph->SetBinContent(ibin, val);
+    if ( err > 0.0 ) m_ph->SetBinError(ibin, err);
+    return;
+  }
+  if ( m_pfcon != nullptr ) m_pfcon[ibin] = val;
+  else m_pdcon[ibin] = val;
+  ++m_nfill;
+  if ( err > 0.0 ) {
+    if ( m_perr == nullptr ) {
+      // Create the error array as SetBinError would, i.e. after the entry count
+      // includes this value.
+      flush();
+      if ( m_ph->GetSumw2N() == 0 ) m_ph->Sumw2();
+      m_perr = m_ph->GetSumw2()->GetArray();
+    }
+    m_perr[ibin] = err*err;
+  }
+}
+
+//**********************************************************************
+
+void ChannelTickHistFiller::flush() {
+  if ( m_ph == nullptr || m_nfill == 0 ) return;
+  m_ph->SetEntries(m_ph->GetEntries() + m_nfill);
+  m_nfill = 0;
+}
+
+//**********************************************************************
+
+int ChannelTickHistFiller::xbin(Tick tick) {
+  if ( tick < 0 ) return m_ph->GetXaxis()->FindBin(tick);
+  if ( Tick(m_xbins.size()) <= tick ) {
+    Tick ntick = m_xbins.size();
+    m_xbins.resize(tick + 1);
+    for ( Tick itick=ntick; itick<=tick; ++itick ) m_xbins[itick] = m_ph->GetXaxis()->FindBin(itick);
+  }
+  return m_xbins[tick];
+}
+
+//**********************************************************************
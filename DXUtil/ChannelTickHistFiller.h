@@ -0,0 +1,65 @@
+// ChannelTickHistFiller.h
+
+#ifndef ChannelTickHistFiller_H
+#define ChannelTickHistFiller_H
+
+// David Adams
+// October 2026
+//
+// Class to write values into the bins of a channel vs. tick histogram,
+// e.g. one made with ChannelTickHistCreator.
+//
+// The result is the same as calling FindBin and SetBinContent (and SetBinError
+// if the error is positive) for each value: a bin holds the last value written
+// to it and the entry count is incremented for each value. The x-bin for each
+// tick is found once and the y-bin once for each channel row. Values for a TH2F
+// or TH2D are written directly into the bin arrays.
+//
+// The histogram entry count is updated when flush() is called. Like
+// SetBinContent, the filler does not update the histogram statistics sums.
+
+#include <vector>
+
+class TH2;
+
+class ChannelTickHistFiller {
+
+public:
+
+  typedef int Tick;
+
+  // Ctor from the histogram to fill. Nothing is written if ph is null.
+  explicit ChannelTickHistFiller(TH2* ph);
+
+  // Return the histogram.
+  TH2* hist() const { return m_ph; }
+
+  // Select the row for channel chan.
+  void setChannel(double chan);
+
+  // Write the value for a tick in the selected row.
+  // The error is also written if err is positive.
+  void fill(Tick tick, double val, double err =-1.0);
+
+  // Add the number of values written since the last flush to the entry count.
+  void flush();
+
+private:
+
+  // Return the x-bin for a tick.
+  int xbin(Tick tick);
+
+private:
+
+  TH2* m_ph;
+  float* m_pfcon;              // Bin contents for a TH2F.
+  double* m_pdcon;             // Bin contents for a TH2D.
+  double* m_perr;              // Squared errors (null until the first error is written).
+  int m_nxcell;                // Number of x-bins including underflow and overflow.
+  int m_rowbin;                // Global bin for x-bin 0 in the selected row.
+  std::vector<int> m_xbins;    // m_xbins[tick] is the x-bin for non-negative tick.
+  unsigned long m_nfill;       // Number of values written since the last flush.
+
+};
+
+#endif
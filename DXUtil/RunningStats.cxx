@@ -0,0 +1,29 @@
+// RunningStats.cxx
+
+#include "RunningStats.h"
+
+//**********************************************************************
+
+void RunningStats::add(const RunningStats& rhs) {
+  merge(rhs.m_count, rhs.m_mean, rhs.m_m2);
+}
+
+//**********************************************************************
+
+void RunningStats::merge(unsigned long n, double mean, double m2) {
+  if ( n == 0 ) return;
+  if ( m_count == 0 ) {
+    m_count = n;
+    m_mean = mean;
+    m_m2 = m2;
+    return;
+  }
+  unsigned long ntot = m_count + n;
+  double dev = mean - m_mean;
+  double fac = double(n)/ntot;
+  m_mean += dev*fac;
+  m_m2 += m2 + dev*dev*m_count*fac;
+  m_count = ntot;
+}
+
+//**********************************************************************
@@ -0,0 +1,129 @@
+// RunningStats.h
+
+#ifndef RunningStats_H
+#define RunningStats_H
+
+// David Adams
+// October 2026
+//
+// Class to accumulate the count, mean and variance of a stream of values.
+//
+// Single values are added with Welford's update. Arrays of values are added
+// with two passes over the array (sum and then the sum of squared deviations
+// from the array mean) which are merged into the running values with the
+// Chan et al. update. The array loops are free of branches and per-value
+// divisions.
+//
+// Values may be masked with an array of keep flags, e.g. to drop ticks with
+// sticky ADC codes. Values with a zero flag are ignored.
+//
+// The RMS is evaluated about zero, i.e. it is sqrt(mean^2 + variance).
+// The standard deviation is the RMS about the mean.
+
+#include <cmath>
+
+class RunningStats {
+
+public:
+
+  // Ctor.
+  RunningStats() { reset(); }
+
+  // Remove all values.
+  void reset() {
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+  }
+
+  // Add one value.
+  void add(double val) {
+    ++m_count;
+    double dev = val - m_mean;
+    m_mean += dev/m_count;
+    m_m2 += dev*(val - m_mean);
+  }
+
+  // Add the values from another accumulator.
+  void add(const RunningStats& rhs);
+
+  // Add the values in [vals, vals+nval).
+  template<typename T>
+  void add(const T* vals, unsigned int nval);
+
+  // Add the values in [vals, vals+nval) for which keeps is nonzero.
+  template<typename T, typename K>
+  void add(const T* vals, const K* keeps, unsigned int nval);
+
+  // Number of values.
+  unsigned long count() const { return m_count; }
+
+  // Sum of the values.
+  double sum() const { return m_count*m_mean; }
+
+  // Mean. Zero if there are no values.
+  double mean() const { return m_mean; }
+
+  // Population variance. Zero if there are no values.
+  double variance() const { return m_count > 0 ? m_m2/m_count : 0.0; }
+
+  // Standard deviation, i.e. RMS about the mean.
+  double sdev() const { return sqrt(variance()); }
+
+  // RMS about zero.
+  double rms() const { return sqrt(m_mean*m_mean + variance()); }
+
+private:
+
+  // Merge the values from a block with count n, mean mean and sum of squared
+  // deviations m2.
+  void merge(unsigned long n, double mean, double m2);
+
+private:
+
+  unsigned long m_count;  // Number of values.
+  double m_mean;          // Mean of the values.
+  double m_m2;            // Sum of the squared deviations from the mean.
+
+};
+
+//**********************************************************************
+
+template<typename T>
+void RunningStats::add(const T* vals, unsigned int nval) {
+  if ( nval == 0 ) return;
+  double sum = 0.0;
+  for ( unsigned int ival=0; ival<nval; ++ival ) sum += vals[ival];
+  double mean = sum/nval;
+  double m2 = 0.0;
+  for ( unsigned int ival=0; ival<nval; ++ival ) {
+    double dev = vals[ival] - mean;
+    m2 += dev*dev;
+  }
+  merge(nval, mean, m2);
+}
+
+//**********************************************************************
+
+template<typename T, typename K>
+void RunningStats::add(const T* vals, const K* keeps, unsigned int nval) {
+  double sum = 0.0;
+  unsigned long nkeep = 0;
+  for ( unsigned int ival=0; ival<nval; ++ival ) {
+    bool keep = keeps[ival] != 0;
+    sum += keep ? double(vals[ival]) : 0.0;
+    nkeep += keep;
+  }
+  if ( nkeep == 0 ) return;
+  double mean = sum/nkeep;
+  double m2 = 0.0;
+  for ( unsigned int ival=0; ival<nval; ++ival ) {
+    double dev = keeps[ival] != 0 ? vals[ival] - mean : 0.0;
+    m2 += dev*dev;
+  }
+  merge(nkeep, mean, m2);
+}
+
+//**********************************************************************
+
+#endif
@@ -3,6 +3,7 @@
 #include "DrawResult.h"
 #include "howStuck.h"
 #include "TruncatedHist.h"
+#include "DXUtil/RunningStats.h"
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -604,7 +605,9 @@ TH2* DrawResult::rmsWindow(unsigned int a_wtick, unsigned int a_ntick, TH2** pph
   phmea->SetStats(0);
   phmea->SetMinimum(-100.0);
   phmea->SetMaximum( 100.0);
+  std::vector<double> sigs(nbinsig);
   for ( int iy=0; iy<nchan; ++iy ) {
+    for ( int tick=0; tick<nbinsig; ++tick ) sigs[tick] = phsig->GetBinContent(tick+1, iy+1);
     for ( int ix=0; ix<nbin; ++ix ) {
       int binout = phrms->GetBin(ix+1, iy+1);
       int tick0 = xmin + ix*wtick;
@@ -612,20 +615,10 @@ TH2* DrawResult::rmsWindow(unsigned int a_wtick, unsigned int a_ntick, TH2** pph
       if ( tick1 < 0 ) tick1 = 0;
       int tick2 = tick0 + hitick;
       if ( tick2 > nbinsig ) tick2 = nbinsig;
-      double ntick = tick2 - tick1;
-      double sum = 0.0;
-      double sumsq = 0.0;
-      for ( int tick=tick1; tick<tick2; ++tick ) {
-        int bin = phsig->GetBin(tick+1, iy+1);
-        double sig = phsig->GetBinContent(bin);
-        sum += sig;
-        sumsq += sig*sig;
-      }
-      double mean = sum/ntick;
-      double rmssq = sumsq/ntick - mean*mean;
-      double rms = sqrt(rmssq);
-      phrms->SetBinContent(binout, rms);
-      phmea->SetBinContent(binout, mean);
+      RunningStats stats;
+      if ( tick2 > tick1 ) stats.add(&sigs[tick1], tick2 - tick1);
+      phrms->SetBinContent(binout, stats.sdev());
+      phmea->SetBinContent(binout, stats.mean());
     }
   }
   return phrms;
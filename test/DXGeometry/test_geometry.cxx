@@ -138,9 +138,120 @@ SurfaceY: 0
   cout << myname << "   Reference cry: " << tid.Cryostat << endl;
   cout << myname << "   Reference TPC: " << tid.TPC << endl;
   cout << myname << "      # channels: " << nchan << endl;
+  // Compare the TPC and cryostat found with the grid with those from the geometry
+  // service for points inside, outside and on the boundaries of each TPC.
+  cout << myname << "Checking TPC grid" << endl;
+  {
+    vector<double> fracs = {-0.2, 0.0, 0.001, 0.5, 0.999, 1.0, 1.2};
+    unsigned int ncheck = 0;
+    unsigned int nbad = 0;
+    for ( int itpc=0; itpc<ntpc; ++itpc ) {
+      double tpos1[3], tpos2[3];
+      gh.tpcCorners(0, itpc, tpos1, tpos2);
+      for ( double fx : fracs ) {
+        for ( double fy : fracs ) {
+          for ( double fz : fracs ) {
+            double xyz[3] = {tpos1[0] + fx*(tpos2[0] - tpos1[0]),
+                             tpos1[1] + fy*(tpos2[1] - tpos1[1]),
+                             tpos1[2] + fz*(tpos2[2] - tpos1[2])};
+            TPCID tidGrid = gh.findTpc(xyz);
+            TPCID tidRef = pgeo->FindTPCAtPosition(xyz);
+            unsigned int icryGrid = gh.findCryostat(xyz);
+            unsigned int icryRef = pgeo->FindCryostatAtPosition(xyz);
+            ++ncheck;
+            bool same = tidGrid.isValid == tidRef.isValid && icryGrid == icryRef;
+            if ( same && tidRef.isValid ) {
+              same = tidGrid.Cryostat == tidRef.Cryostat && tidGrid.TPC == tidRef.TPC;
+            }
+            if ( ! same ) ++nbad;
+          }
+        }
+      }
+    }
+    cout << myname << "  TPC mismatches: " << nbad << "/" << ncheck << endl;
+    assert( nbad == 0 );
+  }
   cout << myname << "Displaying channel map info" << endl;
   cout << myname << "           # ROP: " << gh.nrop() << endl;
   cout << myname << "           # APA: " << gh.napa() << endl;
+  if ( gh.haveChannelMap() ) {
+    cout << myname << "Checking channel table" << endl;
+    vector<unsigned int> chans;
+    vector<unsigned int> ropsExp;
+    for ( unsigned int irop=0; irop<gh.nrop(); ++irop ) {
+      unsigned int ch1 = gh.ropFirstChannel(irop);
+      for ( unsigned int ich=0; ich<gh.ropNChannel(irop); ++ich ) {
+        unsigned int chan = ch1 + ich;
+        assert( gh.channelRop(chan) == irop );
+        assert( gh.channelRopChannel(chan) == ich );
+        assert( gh.channelView(chan) == gh.ropView(irop) );
+        assert( gh.channelTpcs(chan) == gh.ropTpcs(irop) );
+        chans.push_back(chan);
+        ropsExp.push_back(irop);
+      }
+    }
+    chans.push_back(nchan + 100);
+    ropsExp.push_back(gh.nrop());
+    vector<unsigned int> rops;
+    assert( gh.channelRops(chans, rops) == 0 );
+    assert( rops == ropsExp );
+    assert( gh.channelRop(nchan + 100) == gh.nrop() );
+    assert( gh.channelApa(nchan + 100) == GeoHelper::badIndex() );
+    // Compare the cached plane projection with the geometry service on a grid
+    // of points in the reference TPC.
+    cout << myname << "Checking cached plane positions" << endl;
+    double tpos1[3], tpos2[3];
+    gh.tpcCorners(tid.Cryostat, tid.TPC, tpos1, tpos2);
+    unsigned int ncheck = 0;
+    unsigned int nbad = 0;
+    const int ngrid = 20;
+    for ( int ix=0; ix<ngrid; ++ix ) {
+      for ( int iy=0; iy<ngrid; ++iy ) {
+        for ( int iz=0; iz<ngrid; ++iz ) {
+          double xyzt[4] = {tpos1[0] + (ix + 0.37)/ngrid*(tpos2[0] - tpos1[0]),
+                            tpos1[1] + (iy + 0.37)/ngrid*(tpos2[1] - tpos1[1]),
+                            tpos1[2] + (iz + 0.37)/ngrid*(tpos2[2] - tpos1[2]), 0.0};
+          PlanePositionVector pps = gh.planePositions(xyzt, false);
+          PlanePositionVector ppsRef = gh.geometryPlanePositions(xyzt, false);
+          assert( pps.size() == ppsRef.size() );
+          for ( unsigned int ipp=0; ipp<pps.size(); ++ipp ) {
+            ++ncheck;
+            assert( pps[ipp].planeid == ppsRef[ipp].planeid );
+            assert( pps[ipp].rop == ppsRef[ipp].rop );
+            if ( pps[ipp].channel != ppsRef[ipp].channel ) ++nbad;
+          }
+        }
+      }
+    }
+    cout << myname << "  Channel mismatches: " << nbad << "/" << ncheck << endl;
+    assert( ncheck > 0 );
+    assert( 1000*nbad < ncheck );
+    // Check the batch projection against the single-point projection along a line
+    // through the reference TPC.
+    cout << myname << "Checking batch plane positions" << endl;
+    const unsigned int npt = 100;
+    vector<double> xs, ys, zs, ts;
+    for ( unsigned int ipt=0; ipt<npt; ++ipt ) {
+      double frac = (ipt + 0.5)/npt;
+      xs.push_back(tpos1[0] + frac*(tpos2[0] - tpos1[0]));
+      ys.push_back(tpos1[1] + frac*(tpos2[1] - tpos1[1]));
+      zs.push_back(tpos1[2] + frac*(tpos2[2] - tpos1[2]));
+      ts.push_back(0.0);
+    }
+    vector<unsigned int> brops;
+    vector<unsigned int> bchans;
+    vector<double> bticks;
+    assert( gh.planePositions(tid, npt, &xs[0], &ys[0], &zs[0], &ts[0], brops, bchans, bticks, false) == 0 );
+    for ( unsigned int ipt=0; ipt<npt; ++ipt ) {
+      double xyzt[4] = {xs[ipt], ys[ipt], zs[ipt], ts[ipt]};
+      PlanePositionVector pps = gh.planePositions(xyzt, false);
+      assert( pps.size() == brops.size() );
+      for ( unsigned int ipla=0; ipla<pps.size(); ++ipla ) {
+        assert( pps[ipla].rop == brops[ipla] );
+        assert( pps[ipla].channel == bchans[ipla*npt + ipt] );
+      }
+    }
+  }
   cout << myname << "Checking basic geometry info" << endl;
   assert(detname==gname);
   assert(ncry==ncryExp[idet]);
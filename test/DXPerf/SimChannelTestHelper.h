@@ -0,0 +1,88 @@
+// SimChannelTestHelper.h
+
+// David Adams
+// October 2026
+//
+// Helpers shared by the tests that build sim channels and compare the
+// signal maps made from them.
+
+#ifndef SimChannelTestHelper_H
+#define SimChannelTestHelper_H
+
+#include "DXPerf/TpcSignalMap.h"
+#include "lardataobj/Simulation/SimChannel.h"
+#include "DXGeometry/GeoHelper.h"
+
+#include <vector>
+#include <cmath>
+
+namespace SimChannelTestHelper {
+
+typedef std::vector<sim::SimChannel> SimChannelVector;
+
+//**********************************************************************
+
+// Add ionization at a point to the sim channels for each plane.
+inline
+void addIonization(SimChannelVector& scs, int trackid, unsigned int tdc, const double pos[3],
+                   double qdep, double edep, const GeoHelper& gh) {
+  double postim[4] = {pos[0], pos[1], pos[2], 0.0};
+  PlanePositionVector pps = gh.planePositions(postim, false);
+  for ( PlanePosition pp : pps ) {
+    sim::SimChannel* psc = nullptr;
+    for ( sim::SimChannel& sc : scs ) {
+      if ( sc.Channel() == pp.channel ) {
+        psc = &sc;
+        break;
+      }
+    }
+    if ( psc == nullptr ) {
+      scs.push_back(sim::SimChannel(pp.channel));
+      psc = &scs.back();
+    }
+    double xyz[3] = {pos[0], pos[1], pos[2]};
+    psc->AddIonizationElectrons(trackid, tdc, qdep, xyz, edep);
+  }
+}
+
+//**********************************************************************
+
+// Check two signal maps have the same signal in each (TPC, channel, tick) bin.
+// Signals may be summed in a different order so they are compared to a
+// relative precision.
+inline
+bool sameSignals(const TpcSignalMap& sm1, const TpcSignalMap& sm2) {
+  typedef TpcSignalMap::Index Index;
+  typedef TpcSignalMap::TickChannelMap TickChannelMap;
+  typedef TpcSignalMap::ChannelBins ChannelBins;
+  if ( sm1.tpcs() != sm2.tpcs() ) return false;
+  if ( sm1.binCount() != sm2.binCount() ) return false;
+  for ( Index itpc : sm1.tpcs() ) {
+    const TickChannelMap& sto1 = sm1.tickSignalMap(itpc);
+    const TickChannelMap& sto2 = sm2.tickSignalMap(itpc);
+    if ( sto1.size() != sto2.size() ) return false;
+    for ( Index ich=0; ich<sto1.size(); ++ich ) {
+      ChannelBins bins1 = sto1.channelBins(ich);
+      ChannelBins bins2 = sto2.channelBins(ich);
+      if ( bins1.channel() != bins2.channel() ) return false;
+      // With equal counts, finding each filled bin of the first in the second
+      // matches the two sets of bins one to one.
+      if ( bins1.binCount() != bins2.binCount() ) return false;
+      for ( Index ibin1=0; ibin1<bins1.size(); ++ibin1 ) {
+        if ( ! bins1.filled(ibin1) ) continue;
+        Index ibin2 = bins2.find(bins1.tick(ibin1));
+        if ( ibin2 >= bins2.size() ) return false;
+        double sig1 = bins1.signal(ibin1);
+        double sig2 = bins2.signal(ibin2);
+        if ( fabs(sig1 - sig2) > 1.e-9*(1.0 + fabs(sig1)) ) return false;
+      }
+    }
+  }
+  return true;
+}
+
+//**********************************************************************
+
+}  // end namespace SimChannelTestHelper
+
+#endif
@@ -0,0 +1,270 @@
+// test_ChannelTickStore.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for ChannelTickStore.
+
+#include "DXPerf/ChannelTickStore.h"
+
+#include <string>
+#include <iostream>
+#include <cassert>
+
+using std::string;
+using std::cout;
+using std::endl;
+
+typedef ChannelTickStore::Index Index;
+typedef ChannelTickStore::ChannelBins ChannelBins;
+typedef ChannelTickStore::ChannelBits ChannelBits;
+
+int main() {
+  const string myname = "test_ChannelTickStore: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  cout << myname << line << endl;
+  cout << myname << "Empty store." << endl;
+  ChannelTickStore sto;
+  assert( sto.size() == 0 );
+  assert( sto.binCount() == 0 );
+  assert( !(sto.begin() != sto.end()) );
+  assert( sto.channelRange().size() == 0 );
+  assert( sto.tickRange().size() == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Fill out of order." << endl;
+  sto.add(12, 105, 1.0);
+  sto.add(10, 101, 2.0);
+  sto.add(12, 103, 3.0);
+  sto.add(10, 101, 4.0);
+  assert( sto.size() == 2 );
+  assert( sto.binCount() == 3 );
+  assert( sto.channel(0) == 10 );
+  assert( sto.channel(1) == 12 );
+  ChannelBins bins0 = sto.channelBins(0);
+  assert( bins0.size() == 1 );
+  assert( bins0.tick(0) == 101 );
+  assert( bins0.signal(0) == 6.0 );
+  ChannelBins bins1 = sto.channelBins(1);
+  assert( bins1.size() == 2 );
+  assert( bins1.tick(0) == 103 );
+  assert( bins1.tick(1) == 105 );
+  assert( bins1.find(105) == 1 );
+  assert( bins1.find(104) == bins1.size() );
+
+  cout << myname << line << endl;
+  cout << myname << "Merge into existing bins." << endl;
+  sto.add(11, 100, 1.5);
+  sto.add(12, 104, 0.5);
+  sto.add(12, 105, 2.0);
+  assert( sto.size() == 3 );
+  assert( sto.binCount() == 5 );
+  assert( sto.findChannel(11) == 1 );
+  assert( sto.findChannel(13) == sto.size() );
+  assert( sto.lowerChannel(13) == 3 );
+  assert( sto.binCount(11, 13) == 4 );
+  assert( sto.channelBins(2).signal(2) == 3.0 );
+  assert( sto.signalSum() == 14.0 );
+  assert( sto.channelRange().first() == 10 );
+  assert( sto.channelRange().last() == 12 );
+  assert( sto.tickRange().first() == 100 );
+  assert( sto.tickRange().last() == 105 );
+  Index nchan = 0;
+  for ( ChannelBins bins : sto ) {
+    cout << myname << "  Channel " << bins.channel() << " has " << bins.size() << " bins." << endl;
+    ++nchan;
+  }
+  assert( nchan == 3 );
+
+  cout << myname << line << endl;
+  cout << myname << "Copy a channel range." << endl;
+  ChannelTickStore sto2;
+  assert( sto2.appendChannels(sto, 11, 100) == 4 );
+  assert( sto2.size() == 2 );
+  assert( sto2.channel(0) == 11 );
+  assert( sto2.offsets().size() == 3 );
+  assert( sto2.signalSum() == 8.0 );
+  sto2.clear();
+  assert( sto2.size() == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Dense tile." << endl;
+  ChannelTickStore sto3;
+  sto3.add(10, 101, 2.0);
+  sto3.add(20, 100, 1.0);
+  sto3.add(20, 102, 2.0);
+  sto3.add(21, 101, 3.0);
+  sto3.add(23, 100, 4.0);
+  assert( sto3.occupancy(20, 2) == 0.5 );
+  // A tile cell (double and flag) is 9 bytes and a sparse bin (int and double) is 12.
+  assert( ChannelTickStore::breakEvenOccupancy() == 0.75 );
+  assert( sto3.densify(20, 4) == 0 );
+  assert( sto3.densify(22, 4) == 2 );
+  assert( sto3.densify(30, 4) == 1 );
+  assert( sto3.tileCount() == 1 );
+  assert( sto3.isDense(22) );
+  assert( ! sto3.isDense(10) );
+  assert( sto3.sparseChannels().size() == 1 );
+  assert( sto3.size() == 4 );
+  assert( sto3.binCount() == 5 );
+  assert( sto3.binCount(21, 30) == 2 );
+  assert( sto3.channel(1) == 20 );
+  ChannelBins dbins = sto3.channelBins(1);
+  assert( dbins.dense() );
+  assert( dbins.size() == 3 );
+  assert( dbins.binCount() == 2 );
+  assert( dbins.tick(2) == 102 );
+  assert( ! dbins.filled(1) );
+  assert( dbins.find(101) == dbins.size() );
+  assert( dbins.find(102) == 2 );
+  sto3.add(22, 99, 5.0);
+  sto3.add(22, 104, 6.0);
+  assert( sto3.size() == 5 );
+  assert( sto3.binCount() == 7 );
+  // The window grows by at least a quarter: 3 to 4 ticks and then to 6.
+  assert( sto3.channelBins(3).size() == 6 );
+  assert( sto3.tickRange().first() == 99 );
+  assert( sto3.tickRange().last() == 104 );
+  assert( sto3.signalSum() == 23.0 );
+  ChannelTickStore sto4;
+  assert( sto4.appendChannels(sto3, 21, 30) == 4 );
+  assert( sto4.tileCount() == 1 );
+  assert( sto4.size() == 3 );
+  assert( sto4.channel(0) == 21 );
+  assert( sto4.signalSum() == 18.0 );
+
+  // A bin with zero summed signal stays filled.
+  sto4.add(22, 104, -6.0);
+  assert( sto4.binCount() == 4 );
+  assert( sto4.signalSum() == 12.0 );
+  // A tick far outside the window moves the tile back to sparse storage.
+  sto4.add(23, 63000, 1.0);
+  assert( sto4.tileCount() == 0 );
+  assert( ! sto4.isDense(22) );
+  assert( sto4.size() == 3 );
+  assert( sto4.binCount() == 5 );
+  assert( sto4.signalSum() == 13.0 );
+  assert( sto4.tickRange().last() == 63000 );
+
+  cout << myname << line << endl;
+  cout << myname << "Dense and sparse storage agree." << endl;
+  // Fill the same signals into two stores, one with a dense tile made after
+  // some of the signals are added. Signals include bins that sum to zero and
+  // values that are not exact in float precision.
+  ChannelTickStore stos;
+  ChannelTickStore stod;
+  for ( int ipass=0; ipass<2; ++ipass ) {
+    for ( int chan=30; chan<38; ++chan ) {
+      for ( int tick=200 - 20*ipass; tick<240 + 30*ipass; tick+=chan%3 + 1 ) {
+        double sig = 1.0 + 1.e-9*tick;
+        if ( (chan + tick)%5 == 0 ) sig = ipass ? -1.0 : 1.0;
+        stos.add(chan, tick, sig);
+        stod.add(chan, tick, sig);
+      }
+    }
+    if ( ipass == 0 ) assert( stod.densify(30, 8) == 0 );
+  }
+  stod.add(33, 500, 2.0);
+  stos.add(33, 500, 2.0);
+  assert( stod.tileCount() == 1 );
+  assert( stos.tileCount() == 0 );
+  assert( stod.size() == stos.size() );
+  assert( stod.binCount() == stos.binCount() );
+  assert( stod.signalSum() == stos.signalSum() );
+  assert( stod.tickRange().first() == stos.tickRange().first() );
+  assert( stod.tickRange().last() == stos.tickRange().last() );
+  for ( Index ich=0; ich<stos.size(); ++ich ) {
+    ChannelBins sbins = stos.channelBins(ich);
+    ChannelBins dbins = stod.channelBins(ich);
+    assert( dbins.dense() );
+    assert( dbins.channel() == sbins.channel() );
+    assert( dbins.binCount() == sbins.binCount() );
+    for ( Index ibin=0; ibin<sbins.size(); ++ibin ) {
+      Index jbin = dbins.find(sbins.tick(ibin));
+      assert( jbin < dbins.size() );
+      assert( dbins.signal(jbin) == sbins.signal(ibin) );
+    }
+    assert( stod.channelSignal(ich) == stos.channelSignal(ich) );
+    assert( stod.channelBits(ich).overlapCount(stos.channelBits(ich)) == sbins.binCount() );
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Occupancy bits." << endl;
+  ChannelTickStore sto5;
+  for ( int tick=-70; tick<200; tick+=3 ) sto5.add(5, tick, 1.0);
+  sto5.add(6, 130, 1.0);
+  ChannelTickStore sto6;
+  for ( int tick=-100; tick<300; tick+=2 ) sto6.add(5, tick, 1.0);
+  sto6.add(6, 131, 1.0);
+  ChannelBits bits5 = sto5.channelBits(0);
+  ChannelBits bits6 = sto6.channelBits(0);
+  assert( bits5.firstWord() == -2 );
+  assert( bits5.size() == 6 );
+  Index nshared = 0;
+  for ( int tick=-70; tick<200; tick+=3 ) if ( tick%2 == 0 ) ++nshared;
+  cout << myname << "Shared bin count: " << bits5.overlapCount(bits6) << endl;
+  assert( bits5.overlapCount(bits6) == nshared );
+  assert( bits6.overlapCount(bits5) == nshared );
+  assert( sto5.channelBits(1).overlapCount(sto6.channelBits(1)) == 0 );
+  // Bits are rebuilt after the store changes.
+  sto5.add(6, 131, 1.0);
+  assert( sto5.channelBits(1).overlapCount(sto6.channelBits(1)) == 1 );
+  // Dense tile bits.
+  ChannelBits dbits = sto3.channelBits(3);
+  assert( dbits.overlapCount(dbits) == 2 );
+  assert( sto3.channelBits(1).overlapCount(dbits) == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Slices." << endl;
+  ChannelTickStore sl1 = sto3.slice(21, 30);
+  assert( sl1.isSlice() );
+  assert( sl1.size() == 3 );
+  assert( sl1.channel(0) == 21 );
+  assert( sl1.binCount() == 4 );
+  assert( sl1.binCount(0, 22) == 1 );
+  assert( sl1.signalSum() == 18.0 );
+  assert( sl1.tileCount() == 1 );
+  assert( sl1.isDense(22) );
+  assert( ! sl1.isDense(20) );
+  assert( sl1.channelRange().first() == 21 );
+  assert( sl1.channelRange().last() == 23 );
+  assert( sl1.tickRange().first() == 99 );
+  assert( sl1.tickRange().last() == 104 );
+  assert( sl1.channelBits(1).overlapCount(dbits) == 2 );
+  assert( sl1.slice(22, 23).size() == 1 );
+  assert( sto3.slice(40, 50).size() == 0 );
+  assert( sto3.slice(40, 50).tileCount() == 0 );
+  ChannelTickStore sl2 = sto.slice(11, 13);
+  assert( sl2.size() == 2 );
+  assert( sl2.binCount() == 4 );
+  assert( sl2.signalSum() == 8.0 );
+  assert( sl2.tileCount() == 0 );
+  // A slice copies its bins before it is changed.
+  sl2.add(12, 110, 1.0);
+  assert( ! sl2.isSlice() );
+  assert( sl2.size() == 2 );
+  assert( sl2.binCount() == 5 );
+  assert( sto.binCount() == 5 );
+  // The parent copies its bins before it is changed.
+  ChannelTickStore sl3 = sto.slice(10, 11);
+  ChannelTickStore sto7(sto);
+  sto.add(10, 300, 1.0);
+  assert( sto.binCount() == 6 );
+  assert( sl3.binCount() == 1 );
+  assert( sto7.binCount() == 5 );
+  // Direct column access makes a private copy of the slice columns.
+  assert( sl1.sparseChannels().size() == 0 );
+  assert( ! sl1.isSlice() );
+  assert( sl1.size() == 3 );
+  assert( sl1.signalSum() == 18.0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
@@ -0,0 +1,115 @@
+// test_MCTrajectoryCache.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for MCTrajectoryCache.
+
+#include "DXPerf/MCTrajectoryCache.h"
+
+#include <string>
+#include <iostream>
+#include <cassert>
+#include "nusimdata/SimulationBase/MCParticle.h"
+#include "DXGeometry/GeoHelper.h"
+#include "dune/ArtSupport/ArtServiceHelper.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using simb::MCParticle;
+
+typedef MCTrajectoryCache::Trajectory Trajectory;
+
+int main() {
+  const string myname = "test_MCTrajectoryCache: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  cout << myname << line << endl;
+  cout << myname << "Load detector properties (for ticks)." << endl;
+  ArtServiceHelper& ash = ArtServiceHelper::instance();
+  string fcfg = "prodsingle_dune35t.fcl";
+  bool isFile = true;
+  assert( ash.addService("DetectorClocksService",     fcfg, isFile) == 0 );
+  assert( ash.addService("DetectorPropertiesService", fcfg, isFile) == 0 );
+  assert( ash.addService("LArPropertiesService",      fcfg, isFile) == 0 );
+  assert( ash.loadServices() == 1 );
+
+  cout << myname << line << endl;
+  cout << myname << "Create geometry helper." << endl;
+  GeoHelper gh("dune35t4apa_v5", true);
+
+  cout << myname << line << endl;
+  cout << myname << "Create a muon crossing TPC 1." << endl;
+  double tpos1[3];
+  double tpos2[3];
+  assert( gh.tpcCorners(0, 1, tpos1, tpos2) == 0 );
+  MCParticle par(1, 13, "primary", -1, 0.1057, 1);
+  unsigned int npt = 11;
+  TLorentzVector mom;
+  mom.SetXYZT(0.0, 0.0, 1.0, 1.1);
+  for ( unsigned int ipt=0; ipt<npt; ++ipt ) {
+    // The first and last points are outside the TPC.
+    double frac = -0.1 + 1.2*ipt/(npt - 1);
+    TLorentzVector pos;
+    pos.SetXYZT(tpos1[0] + frac*(tpos2[0] - tpos1[0]),
+                tpos1[1] + frac*(tpos2[1] - tpos1[1]),
+                tpos1[2] + frac*(tpos2[2] - tpos1[2]), 10.0*ipt);
+    par.AddTrajectoryPoint(pos, mom);
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Check TPCs." << endl;
+  MCTrajectoryCache cache(&gh);
+  assert( cache.size() == 0 );
+  const Trajectory& traj1 = cache.trajectory(par, false);
+  assert( cache.size() == 1 );
+  assert( cache.tpcEvaluationCount() == npt );
+  assert( cache.planeEvaluationCount() == 0 );
+  assert( traj1.tpcids.size() == npt );
+  assert( traj1.crys.size() == npt );
+  assert( ! traj1.havePlanePositions );
+  assert( traj1.ndet == npt - 2 );
+  assert( ! traj1.tpcids[0].isValid );
+  assert( traj1.tpcids[1].isValid );
+  assert( traj1.tpcids[1].TPC == 1 );
+  assert( traj1.crys[1] == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Check plane positions." << endl;
+  const Trajectory& traj2 = cache.trajectory(par);
+  assert( &traj2 == &traj1 );
+  assert( cache.tpcEvaluationCount() == npt );
+  assert( cache.planeEvaluationCount() == npt );
+  assert( traj2.havePlanePositions );
+  assert( traj2.ppoffs.size() == npt + 1 );
+  assert( traj2.ppoffs[1] == 0 );
+  for ( unsigned int ipt=0; ipt<npt; ++ipt ) {
+    const TLorentzVector& pos = par.Position(ipt);
+    double xyzt[4] = {pos.X(), pos.Y(), pos.Z(), pos.T()};
+    PlanePositionVector pps;
+    if ( traj2.tpcids[ipt].isValid ) pps = gh.planePositions(xyzt);
+    assert( traj2.ppoffs[ipt+1] - traj2.ppoffs[ipt] == pps.size() );
+    for ( unsigned int ipp=0; ipp<pps.size(); ++ipp ) {
+      const PlanePosition& pp = traj2.pps[traj2.ppoffs[ipt] + ipp];
+      assert( pp.channel == pps[ipp].channel );
+      assert( pp.tick == pps[ipp].tick );
+    }
+  }
+  cache.trajectory(par);
+  assert( cache.planeEvaluationCount() == npt );
+
+  cout << myname << line << endl;
+  cout << myname << "Clear." << endl;
+  cache.clear();
+  assert( cache.size() == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
@@ -10,7 +10,11 @@
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 #include "DXGeometry/GeoHelper.h"
+#include "DXPerf/TpcSignalMap.h"
 #include "dune/ArtSupport/ArtServiceHelper.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "art/Framework/Services/Optional/TFileService.h"
@@ -20,7 +24,35 @@
 using std::string;
 using std::cout;
 using std::endl;
+using std::vector;
 using simb::MCParticle;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+//**********************************************************************
+
+// Return the fraction of the segment between pos1 and pos2 lying in the
+// box with corners lo and hi.
+double boxFraction(const double pos1[], const double pos2[], const double lo[], const double hi[]) {
+  double slo = 0.0;
+  double shi = 1.0;
+  for ( int icor=0; icor<3; ++icor ) {
+    double p1 = pos1[icor];
+    double dp = pos2[icor] - p1;
+    if ( dp == 0.0 ) {
+      if ( p1 < lo[icor] || p1 > hi[icor] ) return 0.0;
+      continue;
+    }
+    double s1 = (lo[icor] - p1)/dp;
+    double s2 = (hi[icor] - p1)/dp;
+    if ( s1 > s2 ) std::swap(s1, s2);
+    if ( s1 > slo ) slo = s1;
+    if ( s2 < shi ) shi = s2;
+  }
+  return shi > slo ? shi - slo : 0.0;
+}
+
+//**********************************************************************
 
 int main() {
   const string myname = "test_MCTrajectoryFollower: ";
@@ -38,6 +70,12 @@ int main() {
   cout << myname << "Add TFileService" << endl;
   string scfg = "fileName: \"mctraj_test.root\"";
   assert( ash.addService("TFileService", scfg) == 0 );
+  cout << myname << "Add detector properties (for ticks)" << endl;
+  string fcfg = "prodsingle_dune35t.fcl";
+  bool isFile = true;
+  assert( ash.addService("DetectorClocksService",     fcfg, isFile) == 0 );
+  assert( ash.addService("DetectorPropertiesService", fcfg, isFile) == 0 );
+  assert( ash.addService("LArPropertiesService",      fcfg, isFile) == 0 );
   cout << myname << "Load services." << endl;
   assert( ash.loadServices() == 1 );
   ash.print();
@@ -65,7 +103,7 @@ int main() {
   // We could but don't use geometry service for this.
   cout << myname << line << endl;
   cout << myname << "Create geometry helper." << endl;
-  GeoHelper gh("dune35t4apa_v5");
+  GeoHelper gh("dune35t4apa_v5", true);
 
   // Create follower.
   cout << myname << line << endl;
@@ -90,6 +128,132 @@ int main() {
   cout << myname << "Tree print: " << endl;
   ptree->Scan("npt:nptdet:nptcry:StartXYZT:EndXYZT:StartPE:EndPE:ptx:pty:ptz:ptt:pte");
 
+  cout << myname << line << endl;
+  cout << myname << "Compare sampled and exact deposition." << endl;
+  // Muon crossing TPC 1 and losing 2 MeV at each step.
+  double tpos1[3];
+  double tpos2[3];
+  assert( gh.tpcCorners(0, 1, tpos1, tpos2) == 0 );
+  MCParticle par1(1, 13, "primary", -1, m, 1);
+  double e1 = 1.0;
+  unsigned int nstp = 20;
+  for ( unsigned int ipt=0; ipt<=nstp; ++ipt ) {
+    double frac = 0.1 + 0.8*ipt/nstp;
+    TLorentzVector pos1;
+    TLorentzVector mom1;
+    pos1.SetXYZT(tpos1[0] + frac*(tpos2[0] - tpos1[0]),
+                 tpos1[1] + frac*(tpos2[1] - tpos1[1]),
+                 tpos1[2] + frac*(tpos2[2] - tpos1[2]), 10.0*ipt);
+    mom1.SetXYZT(0.0, 0.0, sqrt(e1*e1 - m*m), e1);
+    par1.AddTrajectoryPoint(pos1, mom1);
+    e1 -= 0.002;
+  }
+  // Expected signal is 2 MeV for each step on each of the three planes.
+  double sigexp = 3*2.0*nstp;
+  // The first follower uses the exact deposition.
+  vector<double> dsmaxs = {0.0, 1.0, 0.1, 0.01};
+  unsigned int nrep = 10;
+  double sigexact = 0.0;
+  for ( double dsmax : dsmaxs ) {
+    MCTrajectoryFollower f2(dsmax, "", &gh, 0, 0);
+    double sig = 0.0;
+    unsigned int nbin = 0;
+    steady_clock::time_point tim1 = steady_clock::now();
+    for ( unsigned int irep=0; irep<nrep; ++irep ) {
+      TpcSignalMap sm("sm", &gh, true);
+      f2.addMCParticle(par1, &sm);
+      sig = sm.tickSignal();
+      nbin = sm.binCount();
+    }
+    steady_clock::time_point tim2 = steady_clock::now();
+    double msec = 1000.0*duration<double>(tim2 - tim1).count()/nrep;
+    cout << myname << "  DsMax " << dsmax << ": " << msec << " ms, signal " << sig
+         << " MeV, bin count " << nbin << endl;
+    if ( dsmax <= 0.0 ) sigexact = sig;
+    assert( fabs(sig - sigexp) < 1.e-3*sigexp );
+  }
+  assert( fabs(sigexact - sigexp) < 1.e-6*sigexp );
+
+  cout << myname << line << endl;
+  cout << myname << "Exact deposition for a step crossing TPC boundaries." << endl;
+  // One step from the center of TPC 1 along z for twice the TPC length.
+  // The end points may be in TPCs that are not adjacent.
+  {
+    double lo[3];
+    double hi[3];
+    double pos1[3];
+    double pos2[3];
+    for ( int icor=0; icor<3; ++icor ) {
+      lo[icor] = std::min(tpos1[icor], tpos2[icor]);
+      hi[icor] = std::max(tpos1[icor], tpos2[icor]);
+      pos1[icor] = 0.5*(lo[icor] + hi[icor]);
+      pos2[icor] = pos1[icor];
+    }
+    pos2[2] += 2.0*(hi[2] - lo[2]);
+    MCParticle par2(2, 13, "primary", -1, m, 1);
+    TLorentzVector mom2;
+    mom2.SetXYZT(0.0, 0.0, sqrt(1.0 - m*m), 1.0);
+    par2.AddTrajectoryPoint(TLorentzVector(pos1[0], pos1[1], pos1[2], 0.0), mom2);
+    mom2.SetXYZT(0.0, 0.0, sqrt(0.99*0.99 - m*m), 0.99);
+    par2.AddTrajectoryPoint(TLorentzVector(pos2[0], pos2[1], pos2[2], 10.0), mom2);
+    // Expected signal is 10 MeV times the fraction of the step in each TPC for
+    // each of the three planes.
+    double sigexp2 = 0.0;
+    unsigned int ntpccrs = 0;
+    for ( unsigned int itpc=0; itpc<gh.ntpc(); ++itpc ) {
+      double c1[3];
+      double c2[3];
+      assert( gh.tpcCorners(0, itpc, c1, c2) == 0 );
+      double tlo[3];
+      double thi[3];
+      for ( int icor=0; icor<3; ++icor ) {
+        tlo[icor] = std::min(c1[icor], c2[icor]);
+        thi[icor] = std::max(c1[icor], c2[icor]);
+      }
+      double frac = boxFraction(pos1, pos2, tlo, thi);
+      if ( frac <= 0.0 ) continue;
+      ++ntpccrs;
+      sigexp2 += 3*10.0*frac;
+    }
+    cout << myname << "  TPC count: " << ntpccrs << endl;
+    assert( ntpccrs > 2 );
+    MCTrajectoryFollower f2(0.0, "", &gh, 0, 0);
+    TpcSignalMap sm("sm", &gh, true);
+    f2.addMCParticle(par2, &sm);
+    cout << myname << "  Signal: " << sm.tickSignal() << " MeV, expected " << sigexp2 << " MeV" << endl;
+    assert( fabs(sm.tickSignal() - sigexp2) < 1.e-6*sigexp2 );
+    // The TPC holding the middle of the step is not at either end and has signal.
+    double posmid[3];
+    for ( int icor=0; icor<3; ++icor ) posmid[icor] = 0.5*(pos1[icor] + pos2[icor]);
+    geo::TPCID tpcmid = gh.findTpc(posmid);
+    assert( tpcmid.isValid );
+    assert( tpcmid != gh.findTpc(pos1) );
+    assert( tpcmid != gh.findTpc(pos2) );
+    assert( sm.tickSignalMap(tpcmid.TPC).signalSum() > 0.0 );
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Fill signal maps for several particles with threads." << endl;
+  {
+    MCTrajectoryFollower f3(0.1, "", &gh, 0, 0);
+    MCTrajectoryFollower::MCParticlePtrVector pars = {&par1, &par0, &par1, &par1};
+    vector<TpcSignalMap> sms(pars.size(), TpcSignalMap("sm", &gh, true));
+    MCTrajectoryFollower::SignalMapVector psms;
+    for ( TpcSignalMap& sm : sms ) psms.push_back(&sm);
+    MCTrajectoryFollower::StatusVector stats;
+    int nacc = f3.addMCParticles(pars, psms, false, MCTrajectoryFollower::IndexVectorPtrVector(), stats, 4);
+    cout << myname << "  Accepted particle count: " << nacc << endl;
+    assert( nacc == int(pars.size()) );
+    assert( stats.size() == pars.size() );
+    for ( unsigned int ipar=0; ipar<pars.size(); ++ipar ) {
+      TpcSignalMap sm("sm", &gh, true);
+      assert( f3.addMCParticle(*pars[ipar], &sm) == stats[ipar] );
+      assert( sms[ipar].binCount() == sm.binCount() );
+      assert( sms[ipar].tickSignal() == sm.tickSignal() );
+    }
+    assert( fabs(sms[0].tickSignal() - sigexp) < 1.e-3*sigexp );
+  }
+
   cout << myname << line << endl;
   pfs->file().ls();
   ArtServiceHelper::close();
@@ -0,0 +1,132 @@
+// test_SimChannelDemultiplexer.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for SimChannelDemultiplexer.
+
+#include "DXPerf/SimChannelDemultiplexer.h"
+#include "DXPerf/TpcSignalMap.h"
+#include "lardataobj/Simulation/SimChannel.h"
+#include "DXGeometry/GeoHelper.h"
+#include "SimChannelTestHelper.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <cassert>
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::istringstream;
+using sim::SimChannel;
+using SimChannelTestHelper::addIonization;
+using SimChannelTestHelper::sameSignals;
+
+typedef SimChannelDemultiplexer::Index Index;
+typedef SimChannelDemultiplexer::IndexVector IndexVector;
+typedef SimChannelDemultiplexer::SimChannelVector SimChannelVector;
+
+//**********************************************************************
+
+int main(int argc, char* argv[]) {
+  const string myname = "test_SimChannelDemultiplexer: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  int dbg = 0;
+  if ( argc > 1 ) {
+    istringstream ssdbg(argv[1]);
+    ssdbg >> dbg;
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Create and check geometry:" << endl;
+  GeoHelper gh("dune35t4apa_v5", true);
+  if ( dbg ) gh.print();
+  assert(gh.geometry() != nullptr);
+
+  cout << myname << line << endl;
+  cout << myname << "Create some sim channels." << endl;
+  SimChannelVector scs;
+  double pos[3] = {100.0, 70.0, 30.0};
+  for ( Index ipt=0; ipt<40; ++ipt ) {
+    int tid = 1 + ipt%4;
+    // Track 4 is an untracked descendant of track 3.
+    if ( tid == 4 ) tid = -3;
+    addIonization(scs, tid, 1000 + 5*ipt, pos, 10000 + 100*ipt, 0.20 + 0.01*ipt, gh);
+    pos[0] +=  1.0;
+    pos[1] += -0.5;
+    pos[2] +=  0.4;
+  }
+  cout << myname << "SimChannel count: " << scs.size() << endl;
+  assert( scs.size() > 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Fill signal maps one at a time." << endl;
+  bool usetpc = true;
+  TpcSignalMap smAll1("all", &gh, usetpc);
+  TpcSignalMap smtrk1("trk1", &gh, usetpc);
+  TpcSignalMap smtrk3("trk3", &gh, usetpc);
+  TpcSignalMap smtrk23("trk23", &gh, usetpc);
+  TpcSignalMap smnotpc1("notpc", &gh, false);
+  IndexVector tids23 = {2, 3, 3};
+  for ( const SimChannel& sc : scs ) {
+    smAll1.addSimChannel(sc, -1);
+    smtrk1.addSimChannel(sc, 1);
+    smtrk3.addSimChannel(sc, 3);
+    smtrk23.addSimChannel(sc, tids23);
+    smnotpc1.addSimChannel(sc, 2);
+  }
+  assert( smAll1.binCount() > 0 );
+  assert( smtrk3.tickSignal() > smtrk1.tickSignal() );
+
+  cout << myname << line << endl;
+  cout << myname << "Fill signal maps in one pass." << endl;
+  TpcSignalMap smAll2("all", &gh, usetpc);
+  TpcSignalMap smtrk2("trk1", &gh, usetpc);
+  TpcSignalMap smtrk32("trk3", &gh, usetpc);
+  TpcSignalMap smtrk232("trk23", &gh, usetpc);
+  TpcSignalMap smnotpc2("notpc", &gh, false);
+  SimChannelDemultiplexer demux(&gh, true, dbg);
+  assert( demux.addDestination(-1, &smAll2) == 0 );
+  assert( demux.addDestination(1, &smtrk2) == 0 );
+  assert( demux.addDestination(3, &smtrk32) == 0 );
+  assert( demux.addDestination(tids23, &smtrk232) == 0 );
+  assert( demux.addDestination(2, &smnotpc2) == 0 );
+  assert( demux.addDestination(2, &smnotpc2) != 0 );
+  assert( demux.addDestination(2, nullptr) != 0 );
+  assert( demux.destinationCount() == 5 );
+  assert( demux.addSimChannels(scs) == 0 );
+  assert( ! smAll2.inBatch() );
+  assert( sameSignals(smAll1, smAll2) );
+  assert( sameSignals(smtrk1, smtrk2) );
+  assert( sameSignals(smtrk3, smtrk32) );
+  assert( sameSignals(smtrk23, smtrk232) );
+  assert( sameSignals(smnotpc1, smnotpc2) );
+
+  cout << myname << line << endl;
+  cout << myname << "Exclude untracked descendants." << endl;
+  TpcSignalMap smtrk33("trk3", &gh, usetpc);
+  TpcSignalMap smtrk34("trk3", &gh, usetpc);
+  for ( const SimChannel& sc : scs ) smtrk33.addSimChannel(sc, 3, false);
+  SimChannelDemultiplexer demux2(&gh, false, dbg);
+  assert( demux2.addDestination(3, &smtrk34) == 0 );
+  assert( demux2.addSimChannels(scs) == 0 );
+  assert( sameSignals(smtrk33, smtrk34) );
+  assert( smtrk34.tickSignal() < smtrk32.tickSignal() );
+  demux2.clear();
+  assert( demux2.destinationCount() == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
+
+//**********************************************************************
@@ -0,0 +1,143 @@
+// test_SimChannelTpcCache.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for SimChannelTpcCache.
+
+#include "DXPerf/SimChannelTpcCache.h"
+#include "DXPerf/SimChannelDemultiplexer.h"
+#include "DXPerf/TpcSignalMap.h"
+#include "lardataobj/Simulation/SimChannel.h"
+#include "DXGeometry/GeoHelper.h"
+#include "SimChannelTestHelper.h"
+#include "larcore/Geometry/Geometry.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <cassert>
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::istringstream;
+using sim::SimChannel;
+using SimChannelTestHelper::addIonization;
+using SimChannelTestHelper::sameSignals;
+
+typedef SimChannelTpcCache::Index Index;
+typedef SimChannelTpcCache::TPCIDVector TPCIDVector;
+typedef std::vector<SimChannel> SimChannelVector;
+
+//**********************************************************************
+
+int main(int argc, char* argv[]) {
+  const string myname = "test_SimChannelTpcCache: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  int dbg = 0;
+  if ( argc > 1 ) {
+    istringstream ssdbg(argv[1]);
+    ssdbg >> dbg;
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Create and check geometry:" << endl;
+  GeoHelper gh("dune35t4apa_v5", true);
+  if ( dbg ) gh.print();
+  assert(gh.geometry() != nullptr);
+
+  cout << myname << line << endl;
+  cout << myname << "Create some sim channels." << endl;
+  SimChannelVector scs;
+  double pos[3] = {100.0, 70.0, 30.0};
+  for ( Index ipt=0; ipt<40; ++ipt ) {
+    int tid = 1 + ipt%3;
+    addIonization(scs, tid, 1000 + 5*ipt, pos, 10000 + 100*ipt, 0.20 + 0.01*ipt, gh);
+    pos[0] +=  1.0;
+    pos[1] += -0.5;
+    pos[2] +=  0.4;
+  }
+  Index nide = 0;
+  for ( const SimChannel& sc : scs ) {
+    for ( auto const& tickide : sc.TDCIDEMap() ) nide += tickide.second.size();
+  }
+  cout << myname << "SimChannel count: " << scs.size() << endl;
+  cout << myname << "      IDE count: " << nide << endl;
+  assert( nide > 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Check cached TPCs." << endl;
+  SimChannelTpcCachePtr pcache(new SimChannelTpcCache(&gh));
+  assert( pcache->size() == 0 );
+  const TPCIDVector& tpcids = pcache->tpcids(scs[0]);
+  assert( pcache->size() == 1 );
+  assert( pcache->requestCount() == 1 );
+  Index iide = 0;
+  for ( auto const& tickide : scs[0].TDCIDEMap() ) {
+    for ( auto const& ide : tickide.second ) {
+      double xyz[3] = {ide.x, ide.y, ide.z};
+      geo::TPCID tpcid = gh.geometry()->FindTPCAtPosition(xyz);
+      assert( tpcids[iide].isValid == tpcid.isValid );
+      assert( tpcids[iide].TPC == tpcid.TPC );
+      ++iide;
+    }
+  }
+  assert( tpcids.size() == iide );
+  assert( pcache->lookupCount() == iide );
+  assert( &pcache->tpcids(scs[0]) == &tpcids );
+  assert( pcache->lookupCount() == iide );
+  pcache->clear();
+  assert( pcache->size() == 0 );
+  assert( pcache->lookupCount() == 0 );
+
+  cout << myname << line << endl;
+  cout << myname << "Fill signal maps without and with the cache." << endl;
+  bool usetpc = true;
+  TpcSignalMap smAll1("all", &gh, usetpc);
+  TpcSignalMap smtrk1("trk1", &gh, usetpc);
+  TpcSignalMap smAll2("all", &gh, usetpc);
+  TpcSignalMap smtrk2("trk1", &gh, usetpc);
+  smAll2.setSimChannelTpcCache(pcache);
+  smtrk2.setSimChannelTpcCache(pcache);
+  assert( smAll2.simChannelTpcCache() == pcache );
+  for ( const SimChannel& sc : scs ) {
+    smAll1.addSimChannel(sc, -1);
+    smtrk1.addSimChannel(sc, 1);
+    smAll2.addSimChannel(sc, -1);
+    smtrk2.addSimChannel(sc, 1);
+  }
+  cout << myname << "Request count: " << pcache->requestCount() << endl;
+  cout << myname << " Lookup count: " << pcache->lookupCount() << endl;
+  assert( pcache->size() == scs.size() );
+  assert( pcache->requestCount() == 2*scs.size() );
+  assert( pcache->lookupCount() == nide );
+  assert( sameSignals(smAll1, smAll2) );
+  assert( sameSignals(smtrk1, smtrk2) );
+
+  cout << myname << line << endl;
+  cout << myname << "Share the cache with a demultiplexer." << endl;
+  TpcSignalMap smtrk3("trk3", &gh, usetpc);
+  TpcSignalMap smtrk4("trk3", &gh, usetpc);
+  for ( const SimChannel& sc : scs ) smtrk3.addSimChannel(sc, 3);
+  SimChannelDemultiplexer demux(&gh);
+  demux.setTpcCache(pcache);
+  assert( demux.tpcCache() == pcache );
+  assert( demux.addDestination(3, &smtrk4) == 0 );
+  assert( demux.addSimChannels(scs) == 0 );
+  assert( pcache->lookupCount() == nide );
+  assert( sameSignals(smtrk3, smtrk4) );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
+
+//**********************************************************************
@@ -110,6 +110,104 @@ int main(int argc, char* argv[]) {
   cout << myname << "Tick Z signal: " << sm3.viewTickSignal(geo::kZ) << endl;
   assert( sm3.viewTickSignal(geo::kZ) ==  2.0);
 
+  cout << myname << line << endl;
+  cout << myname << "Batch fill of signal map:" << endl;
+  TpcSignalMap sm4("sm4", &gh, true);
+  assert( sm4.beginBatch() == 0 );
+  assert( sm4.inBatch() );
+  assert( sm4.addSignal(1201, 208, 0.9, 5) == 0);
+  assert( sm4.addSignal(1200, 201, 4.1, 1) == 0);
+  assert( sm4.addSignal(1200, 205, 3.1, 4) == 0);
+  assert( sm4.addSignal(1201, 205, 1.1, 4) == 0);
+  assert( sm4.addSignal(1200, 201, 4.1, 4) == 0);
+  assert( sm4.addSignal(1201, 204, 2.1, 5) == 0);
+  assert( sm4.addSignal(1200, 202, 8.1, 4) == 0);
+  assert( sm4.addSignal(1200, 204, 7.1, 4) == 0);
+  assert( sm4.addSignal(1201, 206, 5.1, 4) == 0);
+  assert( sm4.addSignal(1201, 207, 2.1, 4) == 0);
+  assert( sm4.addSignal(1201, 205, 6.1, 5) == 0);
+  assert( sm4.addSignal(1201, 206, 9.1, 5) == 0);
+  assert( sm4.addSignal(1201, 207, 3.1, 5) == 0);
+  assert( sm4.binCount() == 0 );
+  assert( sm4.commitBatch() == 1 );
+  assert( ! sm4.inBatch() );
+  assert( sm4.commitBatch() == -1 );
+  assert( sm4.check() == 0 );
+  assert( sm4.channelCount() == sm1.channelCount() );
+  assert( sm4.tickCount() == sm1.tickCount() );
+  assert( sm4.binCount() == sm1.binCount() );
+  assert( sm4.tpcs() == sm1.tpcs() );
+  assert( floatcmp(sm4.tickSignal(), 52.0) );
+
+  cout << myname << line << endl;
+  cout << myname << "Dense fill of signal map:" << endl;
+  TpcSignalMap sm5("sm5", &gh, true);
+  sm5.setDenseOccupancy(0.0);
+  assert( sm5.beginBatch() == 0 );
+  assert( sm5.addSignal(1200, 201, 4.1, 4) == 0);
+  assert( sm5.addSignal(1200, 202, 8.1, 4) == 0);
+  assert( sm5.addSignal(1200, 204, 7.1, 4) == 0);
+  assert( sm5.addSignal(1200, 205, 3.1, 4) == 0);
+  assert( sm5.addSignal(1201, 205, 1.1, 4) == 0);
+  assert( sm5.addSignal(1201, 206, 5.1, 4) == 0);
+  assert( sm5.addSignal(1201, 207, 2.1, 4) == 0);
+  assert( sm5.addSignal(1201, 204, 2.1, 5) == 0);
+  assert( sm5.addSignal(1201, 205, 6.1, 5) == 0);
+  assert( sm5.addSignal(1201, 206, 9.1, 5) == 0);
+  assert( sm5.addSignal(1201, 207, 3.1, 5) == 0);
+  assert( sm5.addSignal(1201, 208, 0.9, 5) == 0);
+  assert( sm5.commitBatch() == 0 );
+  assert( ! sm5.ropIsDense(9) );
+  assert( sm5.densify() == 2 );
+  assert( sm5.ropIsDense(9) );
+  assert( ! sm5.ropIsDense(11) );
+  sm5.print(cout, 11, myname);
+  assert( sm5.check() == 0 );
+  assert( sm5.binCount() == sm1.binCount() );
+  assert( sm5.ropNbin(9) == sm1.ropNbin(9) );
+  assert( sm5.tickSignal() > 51.9 );
+  assert( sm5.tickSignal() < 52.1 );
+  assert( sm5.addSignal(1202, 210, 1.0, 4) == 0);
+  assert( sm5.binCount() == sm1.binCount() + 1 );
+  assert( sm5.buildHits() == 0 );
+  assert( sm5.hitCount() == 5 );
+  TpcSignalMapVector sm5s;
+  sm5.splitByRop(sm5s, true);
+  assert( sm5s.size() == 2 );
+  assert( sm5s[0]->ropIsDense(9) );
+  assert( sm5s[0]->binCount() == 8 );
+  assert( sm5s[1]->binCount() == 5 );
+  assert( sm5s[0]->tickCount() == 10 );
+
+  cout << myname << line << endl;
+  cout << myname << "Dense and sparse fills agree." << endl;
+  // Enough signals are added to trigger the automatic dense check.
+  // Some bins sum to zero.
+  TpcSignalMap sm6s("sm6s", &gh, true);
+  TpcSignalMap sm6d("sm6d", &gh, true);
+  sm6s.setDenseOccupancy(2.0);
+  sm6d.setDenseOccupancy(0.0);
+  for ( TpcSignalMap* psm : {&sm6s, &sm6d} ) {
+    for ( int ipass=0; ipass<3; ++ipass ) {
+      for ( unsigned int chan=1200; chan<1204; ++chan ) {
+        for ( unsigned int tick=200; tick<400; ++tick ) {
+          double sig = 0.1 + 1.e-9*tick;
+          if ( tick%7 == 0 ) sig = ipass==1 ? -1.0 : 0.5;
+          assert( psm->addSignal(chan, tick, sig, 4) == 0 );
+        }
+      }
+    }
+  }
+  assert( sm6d.ropIsDense(9) );
+  assert( ! sm6s.ropIsDense(9) );
+  assert( sm6d.check() == 0 );
+  assert( sm6d.channelCount() == sm6s.channelCount() );
+  assert( sm6d.tickCount() == sm6s.tickCount() );
+  assert( sm6d.binCount() == sm6s.binCount() );
+  assert( sm6d.ropNbin(9) == sm6s.ropNbin(9) );
+  assert( sm6d.tickSignal() == sm6s.tickSignal() );
+
+  cout << myname << line << endl;
   cout << myname << "Split signal map." << endl;
   TpcSignalMapVector sms;
   sm1.splitByRop(sms, true);
@@ -11,6 +11,7 @@
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 
 using std::string;
 using std::cout;
@@ -87,6 +88,10 @@ int main() {
   assert( cmp.matchChannelCount() == 5 );
   assert( cmp.channelFraction() == 0.5 );
   assert( cmp.binFraction() == 0.8 );
+  assert( fabs(cmp.signalFraction() - 46.8/62.0) < 1.e-6 );
+  assert( fabs(cmp.referenceSignal() - 62.0) < 1.e-6 );
+  assert( fabs(cmp.sharedSignal() - 46.8) < 1.e-6 );
+  assert( fabs(cmp.matchSignal() - 67.2) < 1.e-6 );
 
   cout << myname << line << endl;
   cout << myname << "Done." << endl;
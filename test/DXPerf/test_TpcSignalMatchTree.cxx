@@ -130,7 +130,7 @@ int main() {
   cout << myname << line << endl;
   cout << myname << "Fill tree with matches." << endl;
   mt.fill(evid, mat);
-  mt.tree()->Scan("run:event:stat:ref:match:distance:rop");
+  mt.tree()->Scan("run:event:stat:ref:match:distance:rop:rcsig:mcsig:shsig");
   assert( mt.tree()->GetEntries() == 2 );
 
   cout << myname << line << endl;
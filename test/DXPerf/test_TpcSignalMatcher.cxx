@@ -7,17 +7,50 @@
 
 #include "DXPerf/TpcSignalMatcher.h"
 #include "DXPerf/TpcSignalMap.h"
+#include "DXPerf/TpcSignalMapComparison.h"
 
 #include <string>
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
 #include <cassert>
 
 using std::string;
 using std::cout;
 using std::endl;
+using std::setw;
 using tpc::Index;
 using tpc::badIndex;
+using std::chrono::steady_clock;
+using std::chrono::duration;
 typedef TpcSignalMap::TpcSignalMapVector TpcSignalMapVector;
+typedef TpcSignalMap::TpcSignalMapPtr TpcSignalMapPtr;
+
+// Create a signal map filling a block of channels and ticks.
+TpcSignalMapPtr blockMap(string name, const GeoHelper& gh,
+                         Index chan, Index nchan, int tick, int ntick) {
+  TpcSignalMapPtr psm(new TpcSignalMap(name, &gh, false));
+  for ( Index ich=0; ich<nchan; ++ich ) {
+    for ( int itic=0; itic<ntick; ++itic ) {
+      assert( psm->addSignal(chan + ich, tick + itic, 1.0 + 0.1*itic) == 0 );
+    }
+  }
+  return psm;
+}
+
+// Check the signal sums kept by a matcher agree with a new comparison of the pair.
+bool checkMatchSignals(const TpcSignalMatcher& mat, Index iref) {
+  TpcSignalMatcher::MatchSignals sigs = mat.matchSignals(iref);
+  TpcSignalMatcher::Status stat = mat.matchStatus(iref);
+  if ( stat != TpcSignalMatcher::MATCHED && stat != TpcSignalMatcher::DUPLICATE ) {
+    return sigs.reference == 0.0 && sigs.match == 0.0 && sigs.shared == 0.0;
+  }
+  TpcSignalMapComparison com(*mat.referenceVector()[iref], *mat.matchVector()[mat.matchIndex(iref)]);
+  return sigs.reference == com.referenceSignal() &&
+         sigs.match == com.matchSignal() &&
+         sigs.shared == com.sharedSignal();
+}
 
 int main() {
   const string myname = "test_TpcSignalMatcher: ";
@@ -118,6 +151,215 @@ int main() {
   assert( mat.matchStatus(3) == TpcSignalMatcher::UNDEFINEDSTATUS );
   assert( mat.matchIndex(3) == tpc::badIndex() );
 
+  cout << myname << line << endl;
+  cout << myname << "Compare with exhaustive search." << endl;
+  TpcSignalMapVector refs;
+  TpcSignalMapVector cans;
+  for ( Index iref=0; iref<20; ++iref ) {
+    refs.push_back(blockMap("ref", gh, 1400 + 5*iref, 6, 200 + 10*(iref%4), 12));
+  }
+  for ( Index ican=0; ican<30; ++ican ) {
+    cans.push_back(blockMap("can", gh, 1398 + 4*ican, 3 + ican%3, 198 + 23*(ican%5), 8 + ican%4));
+  }
+  // Include a duplicate candidate to check the tie breaking.
+  cans.push_back(blockMap("can", gh, 1400, 6, 200, 12));
+  cans.push_back(blockMap("can", gh, 1400, 6, 200, 12));
+  TpcSignalMatcher matall(refs, cans, false);
+  assert( matall.size() == refs.size() );
+  cout << myname << "Distance count: " << matall.distanceCount() << " of "
+       << refs.size()*cans.size() << endl;
+  assert( matall.distanceCount() > 0 );
+  assert( matall.distanceCount() < refs.size()*cans.size() );
+  Index nmatch = 0;
+  for ( Index iref=0; iref<refs.size(); ++iref ) {
+    double dmin = matall.maxDistance();
+    Index imin = badIndex();
+    for ( Index ican=0; ican<cans.size(); ++ican ) {
+      double dis = matall.distance()(*refs[iref], *cans[ican]);
+      if ( dis < dmin ) {
+        dmin = dis;
+        imin = ican;
+      }
+    }
+    assert( matall.matchIndex(iref) == imin );
+    if ( imin == badIndex() ) {
+      assert( matall.matchStatus(iref) == TpcSignalMatcher::UNMATCHED );
+    } else {
+      assert( matall.matchStatus(iref) != TpcSignalMatcher::UNMATCHED );
+      assert( matall.matchDistance(iref) == float(dmin) );
+      ++nmatch;
+    }
+  }
+  cout << myname << "Match count: " << nmatch << endl;
+  assert( nmatch > 0 );
+  assert( matall.matchIndex(0) == 30 );
+
+  cout << myname << line << endl;
+  cout << myname << "Check metrics." << endl;
+  assert( matall.metric() == TpcSignalMatcher::BINFRACTION );
+  assert( TpcSignalMatcher::metric("BinFraction") == TpcSignalMatcher::BINFRACTION );
+  assert( TpcSignalMatcher::metric("NoSuchMetric") == TpcSignalMatcher::UNDEFINEDMETRIC );
+  assert( TpcSignalMatcher::metricInfo(TpcSignalMatcher::UNDEFINEDMETRIC) == nullptr );
+  std::vector<string> metnames = {"BinFraction", "ChannelFraction", "SignalFraction", "TickCentroid"};
+  for ( string metname : metnames ) {
+    TpcSignalMatcher::Metric met = TpcSignalMatcher::metric(metname);
+    assert( met != TpcSignalMatcher::UNDEFINEDMETRIC );
+    assert( TpcSignalMatcher::metricInfo(met)->name == metname );
+    TpcSignalMatcher matmet(refs, cans, false, 0, TpcSignalMatcher::GREEDY, met);
+    assert( matmet.metric() == met );
+    assert( matmet.distance() == TpcSignalMatcher::metricInfo(met)->distance );
+    Index nmatchmet = 0;
+    for ( Index iref=0; iref<refs.size(); ++iref ) {
+      double dmin = matmet.maxDistance();
+      Index imin = badIndex();
+      for ( Index ican=0; ican<cans.size(); ++ican ) {
+        double dis = matmet.distance()(*refs[iref], *cans[ican]);
+        assert( dis >= 0.0 );
+        assert( dis <= matmet.maxDistance() );
+        if ( dis < dmin ) {
+          dmin = dis;
+          imin = ican;
+        }
+      }
+      assert( matmet.matchIndex(iref) == imin );
+      assert( checkMatchSignals(matmet, iref) );
+      if ( imin != badIndex() ) ++nmatchmet;
+    }
+    cout << myname << "  " << setw(16) << metname << ": distance count " << matmet.distanceCount()
+         << ", match count " << nmatchmet << endl;
+    assert( nmatchmet > 0 );
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Check optimal assignment." << endl;
+  // Both references are closest to the first candidate. The greedy match marks
+  // the smaller as a duplicate and the optimal assignment gives it the second.
+  TpcSignalMapVector refs2;
+  TpcSignalMapVector cans2;
+  refs2.push_back(blockMap("refA", gh, 1600, 6, 300, 12));
+  refs2.push_back(blockMap("refB", gh, 1600, 4, 300, 12));
+  cans2.push_back(blockMap("canX", gh, 1600, 6, 300, 12));
+  cans2.push_back(blockMap("canY", gh, 1600, 4, 300, 6));
+  TpcSignalMatcher matgre(refs2, cans2, false);
+  assert( matgre.assignment() == TpcSignalMatcher::GREEDY );
+  assert( matgre.matchStatus(0) == TpcSignalMatcher::MATCHED );
+  assert( matgre.matchIndex(0) == 0 );
+  assert( matgre.matchStatus(1) == TpcSignalMatcher::DUPLICATE );
+  assert( matgre.matchIndex(1) == 0 );
+  TpcSignalMatcher matopt(refs2, cans2, false, 0, TpcSignalMatcher::OPTIMAL);
+  matopt.print(cout, 0);
+  assert( matopt.assignment() == TpcSignalMatcher::OPTIMAL );
+  assert( matopt.matchStatus(0) == TpcSignalMatcher::MATCHED );
+  assert( matopt.matchIndex(0) == 0 );
+  assert( matopt.matchDistance(0) == 0.0 );
+  assert( matopt.matchStatus(1) == TpcSignalMatcher::MATCHED );
+  assert( matopt.matchIndex(1) == 1 );
+  assert( matopt.matchDistance(1) == 0.5 );
+  // The signal sums are kept for the duplicate and for both assignments, also
+  // when the metric does not compare the maps.
+  assert( matopt.matchSignals(1).shared > 0.0 );
+  for ( Index iref=0; iref<refs2.size(); ++iref ) {
+    assert( checkMatchSignals(matgre, iref) );
+    assert( checkMatchSignals(matopt, iref) );
+  }
+  for ( TpcSignalMatcher::Assignment amode : {TpcSignalMatcher::GREEDY, TpcSignalMatcher::OPTIMAL} ) {
+    TpcSignalMatcher matcen(refs, cans, false, 0, amode, TpcSignalMatcher::TICKCENTROID);
+    for ( Index iref=0; iref<refs.size(); ++iref ) assert( checkMatchSignals(matcen, iref) );
+  }
+  // Each candidate is used at most once and the summed distance is no larger
+  // than that for the greedy matches.
+  TpcSignalMatcher matallopt(refs, cans, false, 0, TpcSignalMatcher::OPTIMAL);
+  std::vector<bool> used(cans.size(), false);
+  double sumopt = 0.0;
+  double sumgre = 0.0;
+  Index nmatchopt = 0;
+  for ( Index iref=0; iref<refs.size(); ++iref ) {
+    assert( matallopt.matchStatus(iref) != TpcSignalMatcher::DUPLICATE );
+    assert( checkMatchSignals(matallopt, iref) );
+    if ( matallopt.matchStatus(iref) == TpcSignalMatcher::MATCHED ) {
+      Index ican = matallopt.matchIndex(iref);
+      assert( ! used[ican] );
+      used[ican] = true;
+      sumopt += matallopt.matchDistance(iref);
+      ++nmatchopt;
+    } else {
+      assert( matallopt.matchIndex(iref) == badIndex() );
+      sumopt += matallopt.maxDistance();
+    }
+    if ( matall.matchStatus(iref) == TpcSignalMatcher::MATCHED ) sumgre += matall.matchDistance(iref);
+    else sumgre += matall.maxDistance();
+  }
+  cout << myname << "Optimal match count: " << nmatchopt << endl;
+  cout << myname << "Greedy, optimal distance sums: " << sumgre << ", " << sumopt << endl;
+  assert( nmatchopt >= nmatch );
+  assert( sumopt <= sumgre + 1.e-5 );
+
+  cout << myname << line << endl;
+  cout << myname << "Check matching ROP shards with threads." << endl;
+  TpcSignalMapVector refs3;
+  TpcSignalMapVector cans3;
+  for ( Index iref=0; iref<200; ++iref ) {
+    Index chan = 9*iref;
+    refs3.push_back(blockMap("ref", gh, chan, 5, 200 + 10*(iref%7), 12));
+    refs3.back()->setRop(gh.channelRop(chan));
+  }
+  for ( Index ican=0; ican<300; ++ican ) {
+    Index chan = 6*ican + 1;
+    cans3.push_back(blockMap("can", gh, chan, 3 + ican%3, 198 + 23*(ican%5), 8 + ican%4));
+    cans3.back()->setRop(gh.channelRop(chan));
+  }
+  for ( TpcSignalMatcher::Assignment amode : {TpcSignalMatcher::GREEDY, TpcSignalMatcher::OPTIMAL} ) {
+    TpcSignalMatcher mat1(refs3, cans3, true, 0, amode, TpcSignalMatcher::BINFRACTION, 1);
+    TpcSignalMatcher mat4(refs3, cans3, true, 0, amode, TpcSignalMatcher::BINFRACTION, 4);
+    assert( mat1.size() == refs3.size() );
+    assert( mat4.size() == refs3.size() );
+    assert( mat4.distanceCount() == mat1.distanceCount() );
+    Index nmatch3 = 0;
+    for ( Index iref=0; iref<refs3.size(); ++iref ) {
+      assert( mat4.matchStatus(iref) == mat1.matchStatus(iref) );
+      assert( mat4.matchIndex(iref) == mat1.matchIndex(iref) );
+      assert( mat4.matchDistance(iref) == mat1.matchDistance(iref) );
+      if ( mat1.matchStatus(iref) == TpcSignalMatcher::MATCHED ) ++nmatch3;
+    }
+    cout << myname << "  Assignment " << amode << ": distance count " << mat1.distanceCount()
+         << ", match count " << nmatch3 << endl;
+    assert( nmatch3 > 0 );
+  }
+
+  cout << myname << line << endl;
+  cout << myname << "Check optimal assignment for a long chain." << endl;
+  // Reference i shares 7 of its 10 ticks with candidate i+1 and 5 with candidate i,
+  // so all are connected in one group. The last reference can only take the last
+  // candidate which the one before prefers. The optimal assignment leaves the last
+  // reference unmatched rather than moving every other reference to its second choice.
+  Index nchain = 3000;
+  TpcSignalMapVector refs4;
+  TpcSignalMapVector cans4;
+  for ( Index iref=0; iref<nchain; ++iref ) {
+    refs4.push_back(blockMap("ref", gh, 1600, 4, 100 + 10*iref, 10));
+  }
+  for ( Index ican=0; ican<nchain; ++ican ) {
+    cans4.push_back(blockMap("can", gh, 1600, 4, 93 + 10*ican, 12));
+  }
+  steady_clock::time_point tim1 = steady_clock::now();
+  TpcSignalMatcher matchain(refs4, cans4, false, 0, TpcSignalMatcher::OPTIMAL);
+  steady_clock::time_point tim2 = steady_clock::now();
+  double msec = 1000.0*duration<double>(tim2 - tim1).count();
+  cout << myname << "  Matched " << nchain << " references in " << msec << " ms" << endl;
+  assert( matchain.distanceCount() == 2*nchain - 1 );
+  double sumchain = 0.0;
+  for ( Index iref=0; iref<nchain-1; ++iref ) {
+    assert( matchain.matchStatus(iref) == TpcSignalMatcher::MATCHED );
+    assert( matchain.matchIndex(iref) == iref + 1 );
+    assert( fabs(matchain.matchDistance(iref) - 0.3) < 1.e-6 );
+    sumchain += matchain.matchDistance(iref);
+  }
+  assert( matchain.matchStatus(nchain-1) == TpcSignalMatcher::UNMATCHED );
+  assert( matchain.matchIndex(nchain-1) == badIndex() );
+  sumchain += matchain.maxDistance();
+  cout << myname << "  Optimal distance sum: " << sumchain << endl;
+  assert( fabs(sumchain - (0.3*(nchain - 1) + 1.0)) < 1.e-2 );
+
   cout << myname << line << endl;
   cout << myname << "Done." << endl;
   return 0;
@@ -86,6 +86,40 @@ int test_ChannelTickHistCreator() {
   assert( nbinx ==  25 );
   assert( nbiny == 128 );
 
+  cout << myname << line << endl;
+  cout << myname << "Book a histogram." << endl;
+  ChannelTickHist hist = cthc.book("apa1x2", 0, 128, "APA 1x2", "trk02", "Track 2", TickRange(80, 290));
+  assert( hist.isValid() );
+  assert( ! hist.isCreated() );
+  assert( hist.createdHist() == nullptr );
+  assert( hist.name() == "h123trk02_apa1x2" );
+  assert( hist.nchan() == 128 );
+  assert( file.Get("h123trk02_apa1x2") == nullptr );
+  ChannelTickHist histcopy = hist;
+  assert( ! histcopy.isCreated() );
+  TH2* ph2b = hist.hist();
+  assert( ph2b != nullptr );
+  assert( hist.isCreated() );
+  assert( hist.createdHist() == ph2b );
+  assert( hist.hist() == ph2b );
+  // The copy shares the histogram.
+  assert( histcopy.isCreated() );
+  assert( histcopy.hist() == ph2b );
+  assert( file.Get("h123trk02_apa1x2") == ph2b );
+  assert( ph2b->GetXaxis()->GetXmin() ==  50 );
+  assert( ph2b->GetXaxis()->GetXmax() == 300 );
+  assert( ph2b->GetNbinsX() == nbinx );
+  assert( ph2b->GetNbinsY() == nbiny );
+  assert( ph2b->GetMaximum() == 200 );
+  assert( ph2b->GetContour() == 8 );
+
+  cout << myname << line << endl;
+  cout << myname << "Invalid booking." << endl;
+  ChannelTickHist badhist = cthc.book("apa1x3", 128, 128, "APA 1x3");
+  assert( ! badhist.isValid() );
+  assert( badhist.hist() == nullptr );
+  assert( cthc.create("apa1x3", 128, 128, "APA 1x3") == nullptr );
+
   cout << myname << line << endl;
   cout << myname << "Close services." << endl;
   ash.close();
@@ -0,0 +1,108 @@
+// test_ChannelTickHistFiller.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for ChannelTickHistFiller.
+
+#include "DXUtil/ChannelTickHistFiller.h"
+
+#include <string>
+#include <iostream>
+#include <cassert>
+#include "TH2.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+
+//**********************************************************************
+
+// Fill two histograms with the same values, the first with FindBin and
+// SetBinContent and the second with a filler.
+// Channels and ticks include values outside the histogram ranges.
+void fillBoth(TH2* ph1, TH2* ph2, bool useErrors) {
+  ChannelTickHistFiller filler(ph2);
+  assert( filler.hist() == ph2 );
+  for ( int chan=-1; chan<12; ++chan ) {
+    filler.setChannel(chan);
+    for ( int tick=-3; tick<130; ++tick ) {
+      if ( (chan + tick)%3 == 0 ) continue;
+      double val = 0.1*chan - 0.01*tick;
+      double err = useErrors ? 0.5 + 0.01*tick : -1.0;
+      int ibin = ph1->FindBin(tick, chan);
+      ph1->SetBinContent(ibin, val);
+      if ( err > 0.0 ) ph1->SetBinError(ibin, err);
+      filler.fill(tick, val, err);
+    }
+  }
+  filler.flush();
+}
+
+// Check that two histograms have the same contents, errors and entry count.
+bool sameHists(TH2* ph1, TH2* ph2) {
+  if ( ph1->GetEntries() != ph2->GetEntries() ) return false;
+  if ( ph1->GetSumw2N() != ph2->GetSumw2N() ) return false;
+  for ( int ibin=0; ibin<(ph1->GetNbinsX()+2)*(ph1->GetNbinsY()+2); ++ibin ) {
+    if ( ph1->GetBinContent(ibin) != ph2->GetBinContent(ibin) ) return false;
+    if ( ph1->GetBinError(ibin) != ph2->GetBinError(ibin) ) return false;
+  }
+  return true;
+}
+
+//**********************************************************************
+
+int main() {
+  const string myname = "test_ChannelTickHistFiller: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  cout << myname << line << endl;
+  cout << myname << "Null histogram." << endl;
+  ChannelTickHistFiller fnull(nullptr);
+  fnull.setChannel(1);
+  fnull.fill(10, 1.0, 1.0);
+  fnull.flush();
+  assert( fnull.hist() == nullptr );
+
+  cout << myname << line << endl;
+  cout << myname << "TH2F with errors and 4 ticks per bin." << endl;
+  TH2F hf1("hf1", "hf1", 25, 0, 100, 10, 0, 10);
+  TH2F hf2("hf2", "hf2", 25, 0, 100, 10, 0, 10);
+  fillBoth(&hf1, &hf2, true);
+  cout << myname << "Entries: " << hf2.GetEntries() << endl;
+  assert( hf2.GetEntries() > 0 );
+  assert( sameHists(&hf1, &hf2) );
+
+  cout << myname << line << endl;
+  cout << myname << "TH2F without errors." << endl;
+  TH2F hf3("hf3", "hf3", 120, 0, 120, 5, 0, 10);
+  TH2F hf4("hf4", "hf4", 120, 0, 120, 5, 0, 10);
+  fillBoth(&hf3, &hf4, false);
+  assert( hf4.GetSumw2N() == 0 );
+  assert( sameHists(&hf3, &hf4) );
+
+  cout << myname << line << endl;
+  cout << myname << "TH2D." << endl;
+  TH2D hd1("hd1", "hd1", 50, 0, 100, 10, 0, 10);
+  TH2D hd2("hd2", "hd2", 50, 0, 100, 10, 0, 10);
+  fillBoth(&hd1, &hd2, true);
+  assert( sameHists(&hd1, &hd2) );
+
+  cout << myname << line << endl;
+  cout << myname << "Other histogram type." << endl;
+  TH2I hi1("hi1", "hi1", 50, 0, 100, 10, 0, 10);
+  TH2I hi2("hi2", "hi2", 50, 0, 100, 10, 0, 10);
+  fillBoth(&hi1, &hi2, true);
+  assert( sameHists(&hi1, &hi2) );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
+
+//**********************************************************************
@@ -0,0 +1,142 @@
+// test_RunningStats.cxx
+
+// David Adams
+// October 2026
+//
+// Test script for RunningStats.
+
+#include "DXUtil/RunningStats.h"
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::vector;
+
+//**********************************************************************
+
+// Return if two values agree within a relative tolerance.
+bool near(double x1, double x2) {
+  double tol = 1.e-10*(1.0 + fabs(x1) + fabs(x2));
+  return fabs(x1 - x2) < tol;
+}
+
+// Check an accumulator against the expected count, mean and variance.
+bool check(const RunningStats& stats, unsigned long count, double mean, double var) {
+  cout << "  Count: " << stats.count() << "  Mean: " << stats.mean()
+       << "  Variance: " << stats.variance() << endl;
+  if ( stats.count() != count ) return false;
+  if ( !near(stats.mean(), mean) ) return false;
+  if ( !near(stats.sum(), count*mean) ) return false;
+  if ( !near(stats.variance(), var) ) return false;
+  if ( !near(stats.sdev(), sqrt(var)) ) return false;
+  if ( !near(stats.rms(), sqrt(mean*mean + var)) ) return false;
+  return true;
+}
+
+//**********************************************************************
+
+int main() {
+  const string myname = "test_RunningStats: ";
+  cout << myname << "Starting test" << endl;
+#ifdef NDEBUG
+  cout << myname << "NDEBUG must be off." << endl;
+  abort();
+#endif
+  string line = "-----------------------------";
+
+  cout << myname << line << endl;
+  cout << myname << "Empty." << endl;
+  RunningStats empty;
+  assert( check(empty, 0, 0.0, 0.0) );
+  empty.add((const float*) nullptr, 0);
+  assert( check(empty, 0, 0.0, 0.0) );
+
+  cout << myname << line << endl;
+  cout << myname << "Build values." << endl;
+  // Values with a large offset so that naive sums lose precision.
+  vector<float> vals;
+  vector<char> keeps;
+  for ( unsigned int ival=0; ival<1000; ++ival ) {
+    vals.push_back(1000.0 + 0.25*(ival%17) - 0.5*(ival%5));
+    keeps.push_back(ival%7 != 3);
+  }
+  double sum = 0.0;
+  double ksum = 0.0;
+  unsigned long nkeep = 0;
+  for ( unsigned int ival=0; ival<vals.size(); ++ival ) {
+    sum += vals[ival];
+    if ( keeps[ival] ) {
+      ksum += vals[ival];
+      ++nkeep;
+    }
+  }
+  double mean = sum/vals.size();
+  double kmean = ksum/nkeep;
+  double var = 0.0;
+  double kvar = 0.0;
+  for ( unsigned int ival=0; ival<vals.size(); ++ival ) {
+    var += (vals[ival] - mean)*(vals[ival] - mean);
+    if ( keeps[ival] ) kvar += (vals[ival] - kmean)*(vals[ival] - kmean);
+  }
+  var /= vals.size();
+  kvar /= nkeep;
+
+  cout << myname << line << endl;
+  cout << myname << "Single values." << endl;
+  RunningStats stats1;
+  for ( float val : vals ) stats1.add(val);
+  assert( check(stats1, vals.size(), mean, var) );
+
+  cout << myname << line << endl;
+  cout << myname << "Array." << endl;
+  RunningStats stats2;
+  stats2.add(&vals[0], vals.size());
+  assert( check(stats2, vals.size(), mean, var) );
+
+  cout << myname << line << endl;
+  cout << myname << "Array in blocks." << endl;
+  RunningStats stats3;
+  for ( unsigned int ival=0; ival<vals.size(); ival+=64 ) {
+    unsigned int nval = ival + 64 > vals.size() ? vals.size() - ival : 64;
+    stats3.add(&vals[ival], nval);
+  }
+  assert( check(stats3, vals.size(), mean, var) );
+
+  cout << myname << line << endl;
+  cout << myname << "Merge." << endl;
+  RunningStats stats4a;
+  RunningStats stats4b;
+  stats4a.add(&vals[0], 300);
+  stats4b.add(&vals[300], vals.size() - 300);
+  stats4a.add(stats4b);
+  assert( check(stats4a, vals.size(), mean, var) );
+  stats4a.add(empty);
+  assert( check(stats4a, vals.size(), mean, var) );
+
+  cout << myname << line << endl;
+  cout << myname << "Masked array." << endl;
+  RunningStats stats5;
+  stats5.add(&vals[0], &keeps[0], 500);
+  stats5.add(&vals[500], &keeps[500], vals.size() - 500);
+  assert( check(stats5, nkeep, kmean, kvar) );
+  vector<char> nokeeps(vals.size(), 0);
+  stats5.add(&vals[0], &nokeeps[0], vals.size());
+  assert( check(stats5, nkeep, kmean, kvar) );
+
+  cout << myname << line << endl;
+  cout << myname << "Reset." << endl;
+  stats5.reset();
+  assert( check(stats5, 0, 0.0, 0.0) );
+
+  cout << myname << line << endl;
+  cout << myname << "Done." << endl;
+  return 0;
+}
+
+//**********************************************************************